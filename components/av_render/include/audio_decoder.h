@@ -50,6 +50,17 @@ typedef struct {
     void                  *ctx;        /*!< Decoder context */
 } adec_cfg_t;
 
+/**
+ * @brief  Audio decoder output buffer callback configuration
+ *
+ * @note  When `fb_fetch` returns NULL decoder falls back to its internal output buffer
+ */
+typedef struct {
+    uint8_t *(*fb_fetch)(int size, void *ctx);             /*!< Fetch output buffer for one decoded frame */
+    int (*fb_return)(uint8_t *addr, bool drop, void *ctx); /*!< Return output buffer after frame callback */
+    void *ctx;                                             /*!< Context */
+} adec_fb_cb_cfg_t;
+
 /**
  * @brief  Audio decoder handle
  */
@@ -66,6 +77,18 @@ typedef void *adec_handle_t;
  */
 adec_handle_t adec_open(adec_cfg_t *cfg);
 
+/**
+ * @brief  Set output buffer callback so that PCM can be decoded into user buffer directly
+ *
+ * @param[in]  h    Audio decoder handle
+ * @param[in]  cfg  Output buffer callback configuration
+ *
+ * @return
+ *       - ESP_MEDIA_ERR_OK           On success
+ *       - ESP_MEDIA_ERR_INVALID_ARG  Invalid argument
+ */
+int adec_set_fb_cb(adec_handle_t h, adec_fb_cb_cfg_t *cfg);
+
 /**
  * @brief  Decode audio
  *
@@ -78,6 +101,22 @@ adec_handle_t adec_open(adec_cfg_t *cfg);
  */
 int adec_decode(adec_handle_t h, av_render_audio_data_t *data);
 
+/**
+ * @brief  Generate one concealment frame for lost packet
+ *
+ * @note  Concealed frame is output through frame callback same as normal decoded frame
+ *
+ * @param[in]  h    Audio decoder handle
+ * @param[in]  pts  Presentation time of the lost frame
+ *
+ * @return
+ *       - ESP_MEDIA_ERR_OK           On success
+ *       - ESP_MEDIA_ERR_INVALID_ARG  Invalid argument
+ *       - ESP_MEDIA_ERR_NOT_SUPPORT  Decoder not support packet loss concealment
+ *       - Others                     Fail to conceal
+ */
+int adec_conceal(adec_handle_t h, uint32_t pts);
+
 /**
  * @brief  Get decoded audio frame information
  *
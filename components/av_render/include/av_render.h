@@ -43,23 +43,112 @@ typedef enum {
     AV_RENDER_SYNC_FOLLOW_TIME,  /*!< Sync according system time */
 } av_render_sync_mode_t;
 
+/**
+ * @brief  AV render audio jitter buffer configuration
+ *
+ * @note  When enabled, arrival jitter is estimated from audio packet pts against wall clock
+ *        Buffered audio is kept around target delay by time-stretching through `audio_render_set_speed`
+ *        Set fields to 0 to use default values
+ */
+typedef struct {
+    bool     enable;       /*!< Enable adaptive jitter buffer for audio playback */
+    uint16_t target_delay; /*!< Target playout delay (unit ms), may grow according measured jitter */
+    uint16_t min_delay;    /*!< Minimum playout delay (unit ms) */
+    uint16_t max_delay;    /*!< Maximum playout delay (unit ms) */
+    float    max_stretch;  /*!< Maximum stretch deviation from normal speed, e.g. 0.1 means speed in range [0.9, 1.1] */
+} av_render_jitter_cfg_t;
+
+/**
+ * @brief  AV render video drop action
+ */
+typedef enum {
+    AV_RENDER_DROP_NONE,   /*!< Decode the frame */
+    AV_RENDER_DROP_FRAME,  /*!< Drop this frame only, should only be used for non-reference frame */
+    AV_RENDER_DROP_TO_KEY, /*!< Drop this frame and following frames until next key frame */
+} av_render_drop_action_t;
+
+/**
+ * @brief  AV render video frame information for drop decision
+ */
+typedef struct {
+    uint32_t pts;       /*!< Video frame PTS */
+    int32_t  late;      /*!< How late frame is against sync clock (unit ms)
+                             When sync mode is `AV_RENDER_SYNC_NONE` use duration queued in decoder fifo instead */
+    int      q_num;     /*!< Frames left in decoder fifo */
+    uint8_t  fps;       /*!< Video frame rate */
+    bool     key_frame; /*!< Frame can be decoded independently */
+    bool     reference; /*!< Frame is referenced by following frames */
+} av_render_drop_info_t;
+
+/**
+ * @brief  AV render video drop policy callback
+ *
+ * @param[in]  info  Frame information
+ * @param[in]  ctx   User context
+ *
+ * @return
+ *       - Drop action for the frame
+ */
+typedef av_render_drop_action_t (*av_render_drop_policy_cb)(av_render_drop_info_t *info, void *ctx);
+
+/**
+ * @brief  AV render video drop configuration
+ *
+ * @note  Only take effect when `allow_drop_data` is set, thresholds are counted in frames and converted using fps
+ *        Key frames referenced by following frames are never dropped by default policy
+ *        Intra-only frames such as MJPEG have no dependency and are dropped like non-reference frames
+ *        Set fields to 0 to use default values
+ */
+typedef struct {
+    uint8_t                  drop_late_frames; /*!< Drop non-reference frame when late for this frames, default 2 */
+    uint8_t                  skip_late_frames; /*!< Skip to next key frame when late for this frames, default 8 */
+    av_render_drop_policy_cb policy;           /*!< Custom drop policy, NULL to use default GOP-aware policy */
+    void                    *policy_ctx;       /*!< Custom drop policy context */
+} av_render_drop_cfg_t;
+
+/**
+ * @brief  AV render audio catch-up configuration
+ *
+ * @note  When audio render fifo grows over target, audio is played slightly faster until fifo drains back
+ *        Speed up is done by removing pitch periods so that pitch keeps unchanged, only support 16 bits PCM
+ *        Not take effect when `audio_jitter` enabled, jitter buffer already controls latency by itself
+ *        Set fields to 0 to use default values
+ */
+typedef struct {
+    bool     enable;       /*!< Enable automatic catch-up */
+    uint16_t target_level; /*!< Target audio render fifo level (unit ms), default 100 */
+    uint16_t hysteresis;   /*!< Start catch-up only when fifo level over `target_level` + `hysteresis` (unit ms), default 60 */
+    float    speed;        /*!< Catch-up playback speed, default 1.05, limited to 1.5 */
+} av_render_catchup_cfg_t;
+
 /**
  * @brief  AV render configuration
  */
 typedef struct {
-    audio_render_handle_t audio_render;           /*!< Audio render handle */
-    video_render_handle_t video_render;           /*!< Video render handle */
-    av_render_sync_mode_t sync_mode;              /*!< AV sync mode */
-    uint32_t              audio_raw_fifo_size;    /*!< Audio Decoder fifo size setting. if set, will create audio decode thread to decode data */
-    uint32_t              video_raw_fifo_size;    /*!< Video Decoder fifo size setting. If set, will create video decode thread to decode data */
-    uint32_t              audio_render_fifo_size; /*!< Audio Render fifo size setting. If set, will create audio render thread to render audio */
-    uint32_t              video_render_fifo_size; /*!< Video  Render fifo size setting. If set, will create video render thread to render audio */
-    bool                  quit_when_eos;          /*!< When received stream eos, quit thread or just wait for new data */
-    bool                  allow_drop_data;        /*!< Allow drop data when decode or render too slow */
-    bool                  pause_render_only;      /*!< If call `av_render_pause` only pause render thread or pause all thread */
-    bool                  pause_on_first_frame;   /*!< Whether automatically pause when render receive first frame */
-    void                 *ctx;                    /*!< User context */
-    bool                  video_cvt_in_render;    /*!< Convert color in render*/
+    audio_render_handle_t   audio_render;           /*!< Audio render handle */
+    video_render_handle_t   video_render;           /*!< Video render handle */
+    av_render_sync_mode_t   sync_mode;              /*!< AV sync mode */
+    uint32_t                audio_raw_fifo_size;    /*!< Audio Decoder fifo size setting. if set, will create audio decode thread to decode data */
+    uint32_t                video_raw_fifo_size;    /*!< Video Decoder fifo size setting. If set, will create video decode thread to decode data */
+    uint32_t                audio_render_fifo_size; /*!< Audio Render fifo size setting. If set, will create audio render thread to render audio */
+    uint32_t                video_render_fifo_size; /*!< Video  Render fifo size setting. If set, will create video render thread to render audio */
+    bool                    quit_when_eos;          /*!< When received stream eos, quit thread or just wait for new data */
+    bool                    allow_drop_data;        /*!< Allow drop data when decode or render too slow */
+    bool                    pause_render_only;      /*!< If call `av_render_pause` only pause render thread or pause all thread */
+    bool                    pause_on_first_frame;   /*!< Whether automatically pause when render receive first frame */
+    void                   *ctx;                    /*!< User context */
+    bool                    video_cvt_in_render;    /*!< Convert color in render*/
+    av_render_jitter_cfg_t  audio_jitter;           /*!< Audio jitter buffer setting */
+    uint16_t                video_out_width;        /*!< Video output width, if differ from decoded width scale during color convert */
+    uint16_t                video_out_height;       /*!< Video output height, if differ from decoded height scale during color convert */
+    uint16_t                video_rotate;           /*!< Clockwise rotation degree (0, 90, 180, 270) applied during color convert */
+    bool                    latency_stats;          /*!< Collect per-stage latency histograms, read through `av_render_get_stats` */
+    bool                    audio_coop;             /*!< Run audio decode and render as stages of one cooperative thread "APipe"
+                                                         instead of separate "Adec" and "ARender" threads */
+    av_render_drop_cfg_t    video_drop;             /*!< Video frame drop setting */
+    av_render_catchup_cfg_t audio_catchup;          /*!< Audio catch-up setting */
+    uint8_t                 video_fb_num;           /*!< Decoded video frame buffer number shared by decoder and render thread
+                                                         Buffers are reused with reference count, default 3, minimum 2 */
 } av_render_cfg_t;
 
 /**
@@ -86,6 +175,119 @@ typedef struct {
     int      render_data_size; /*!< Render queue data number */
 } av_render_fifo_stat_t;
 
+/**
+ * @brief  AV render audio jitter buffer statistics
+ */
+typedef struct {
+    uint32_t jitter;       /*!< Estimated arrival jitter (unit ms) */
+    uint32_t target_delay; /*!< Current target playout delay (unit ms) */
+    uint32_t cur_delay;    /*!< Current buffered audio duration (unit ms) */
+    float    stretch;      /*!< Current stretch ratio applied to audio render */
+} av_render_jitter_stat_t;
+
+/**
+ * @brief  AV render audio packet loss concealment statistics
+ */
+typedef struct {
+    uint32_t gap_num;     /*!< Detected audio pts gaps */
+    uint32_t plc_frames;  /*!< Frames concealed by decoder */
+    uint32_t fade_frames; /*!< Frames synthesized by fading out last output */
+} av_render_plc_stat_t;
+
+/**
+ * @brief  AV render pipeline stage for latency statistics
+ */
+typedef enum {
+    AV_RENDER_STAGE_QUEUE,   /*!< Wait in decoder fifo, from enqueue to dequeue */
+    AV_RENDER_STAGE_DECODE,  /*!< Decode one packet, excluding nested convert and render */
+    AV_RENDER_STAGE_CONVERT, /*!< Audio resample or video color convert, excluding nested render */
+    AV_RENDER_STAGE_RENDER,  /*!< Write one frame to audio or video render */
+    AV_RENDER_STAGE_MAX,     /*!< Maximum of stage */
+} av_render_stage_t;
+
+/**
+ * @brief  AV render stream type for latency statistics
+ */
+typedef enum {
+    AV_RENDER_STREAM_AUDIO, /*!< Audio stream */
+    AV_RENDER_STREAM_VIDEO, /*!< Video stream */
+    AV_RENDER_STREAM_MAX,   /*!< Maximum of stream */
+} av_render_stream_t;
+
+/**
+ * @brief  Latency percentiles of one stage
+ *
+ * @note  Percentiles are calculated over a rolling window, older samples decay when window is full
+ *        Values are bucket centers with about 12% resolution
+ */
+typedef struct {
+    uint32_t count; /*!< Samples kept in rolling window */
+    uint32_t p50;   /*!< 50th percentile latency (unit us) */
+    uint32_t p95;   /*!< 95th percentile latency (unit us) */
+    uint32_t p99;   /*!< 99th percentile latency (unit us) */
+    uint32_t max;   /*!< Maximum latency in rolling window (unit us) */
+} av_render_latency_t;
+
+/**
+ * @brief  AV render latency statistics
+ */
+typedef struct {
+    av_render_latency_t stage[AV_RENDER_STREAM_MAX][AV_RENDER_STAGE_MAX]; /*!< Latency indexed by stream and stage */
+} av_render_stats_t;
+
+/**
+ * @brief  AV render video drop statistics
+ */
+typedef struct {
+    uint32_t decoded;      /*!< Frames passed to decoder */
+    uint32_t dropped;      /*!< Single frames dropped */
+    uint32_t skip_to_key;  /*!< Times of skipping to next key frame */
+    uint32_t skipped;      /*!< Frames dropped while waiting for key frame */
+} av_render_drop_stat_t;
+
+/**
+ * @brief  AV render trace record type, also used as bit index of trace mask
+ */
+typedef enum {
+    AV_RENDER_TRACE_ADEC,    /*!< Audio data before decode */
+    AV_RENDER_TRACE_ARENDER, /*!< Audio frame before render */
+    AV_RENDER_TRACE_VDEC,    /*!< Video data before decode */
+    AV_RENDER_TRACE_VRENDER, /*!< Video frame before render */
+    AV_RENDER_TRACE_MAX,
+} av_render_trace_type_t;
+
+/**
+ * @brief  AV render trace output callback
+ *
+ * @param[in]  data  Capture data to be saved or sent
+ * @param[in]  size  Data size
+ * @param[in]  ctx   User context
+ *
+ * @return
+ *       - 0       On success
+ *       - Others  Fail to output, capture stopped
+ */
+typedef int (*av_render_trace_write_cb)(uint8_t *data, int size, void *ctx);
+
+/**
+ * @brief  AV render trace configuration
+ *
+ * @note  Media threads only append records into preallocated ring, record is dropped when ring full
+ *        Thread "AVTrace" drains ring and outputs capture
+ *        Capture layout: "AVTR" version(1 byte), then records each as varint(record length) + record
+ *        Record: type(1 byte), zigzag varint of pts delta, varint of time delta (unit us),
+ *                varint of data size, then payload truncated to `max_payload`
+ *        Deltas are against previous record of same type, first record of each type against 0
+ */
+typedef struct {
+    uint8_t                  mask;        /*!< Bit mask of `av_render_trace_type_t` to capture */
+    uint32_t                 ring_size;   /*!< Ring buffer size, default 64KB */
+    uint32_t                 max_payload; /*!< Max payload bytes kept in each record, 0 to keep record header only */
+    const char              *file_path;   /*!< File to save capture, not used when `write` is set */
+    av_render_trace_write_cb write;       /*!< Custom output such as socket send */
+    void                    *ctx;         /*!< User context for `write` */
+} av_render_trace_cfg_t;
+
 /**
  * @brief  AV render fifo configuration
  */
@@ -177,6 +379,67 @@ int av_render_add_audio_stream(av_render_handle_t render, av_render_audio_info_t
  */
 int av_render_set_fixed_frame_info(av_render_handle_t render, av_render_audio_frame_info_t *frame_info);
 
+/**
+ * @brief  Add extra PCM stream mixed with main audio stream
+ *
+ * @note  Stream data is resampled into fixed frame info and mixed in audio render thread
+ *        Need set 16 bits fixed frame info and audio render fifo size before call this API
+ *        Audio render is opened with fixed frame info and keep opened until reset
+ *
+ * @param[in]   render     AV render handle
+ * @param[in]   info       PCM information of mix stream
+ * @param[in]   gain       Stream gain (1.0 for original volume)
+ * @param[out]  stream_id  Mix stream id (bigger than 0)
+ *
+ * @return
+ *       - 0                            On success
+ *       - ESP_MEDIA_ERR_NOT_SUPPORT    Fixed frame info or audio render fifo not set
+ *       - ESP_MEDIA_ERR_EXCEED_LIMIT   Too many mix streams
+ *       - Others                       Fail to add mix stream
+ */
+int av_render_add_mix_stream(av_render_handle_t render, av_render_audio_frame_info_t *info, float gain, int *stream_id);
+
+/**
+ * @brief  Add PCM data for mix stream
+ *
+ * @note  This API blocks until all data queued into mix fifo
+ *
+ * @param[in]  render      AV render handle
+ * @param[in]  stream_id   Mix stream id
+ * @param[in]  audio_data  PCM data of mix stream
+ *
+ * @return
+ *       - 0       On success
+ *       - Others  Fail to add mix data or stream removed
+ */
+int av_render_add_mix_data(av_render_handle_t render, int stream_id, av_render_audio_data_t *audio_data);
+
+/**
+ * @brief  Set gain for audio stream
+ *
+ * @param[in]  render     AV render handle
+ * @param[in]  stream_id  Mix stream id, 0 for main audio stream
+ * @param[in]  gain       Stream gain (1.0 for original volume, max 8.0)
+ *
+ * @return
+ *       - 0       On success
+ *       - Others  Fail to set stream gain
+ */
+int av_render_set_stream_gain(av_render_handle_t render, int stream_id, float gain);
+
+/**
+ * @brief  Remove mix stream
+ *
+ * @param[in]  render     AV render handle
+ * @param[in]  stream_id  Mix stream id
+ * @param[in]  drain      Wait for queued data played before remove
+ *
+ * @return
+ *       - 0       On success
+ *       - Others  Fail to remove mix stream
+ */
+int av_render_remove_mix_stream(av_render_handle_t render, int stream_id, bool drain);
+
 /**
  * @brief  Configuration for video fifo for AV render
  *
@@ -224,8 +487,9 @@ int av_render_use_data_pool(av_render_handle_t render, av_render_pool_data_free
  * @param[in]  audio_data  Audio data
  *
  * @return
- *       - 0       On success
- *       - Others  Fail to add audio data
+ *       - 0                      On success
+ *       - ESP_MEDIA_ERR_TIMEOUT  Data dropped for deadline reached
+ *       - Others                 Fail to add audio data
  */
 int av_render_add_audio_data(av_render_handle_t render, av_render_audio_data_t *audio_data);
 
@@ -236,8 +500,9 @@ int av_render_add_audio_data(av_render_handle_t render, av_render_audio_data_t *
  * @param[in]  video_data  Video data
  *
  * @return
- *       - 0       On success
- *       - Others  Fail to add video data
+ *       - 0                      On success
+ *       - ESP_MEDIA_ERR_TIMEOUT  Data dropped for deadline reached
+ *       - Others                 Fail to add video data
  */
 int av_render_add_video_data(av_render_handle_t render, av_render_video_data_t *video_data);
 
@@ -367,13 +632,98 @@ int av_render_get_render_pts(av_render_handle_t h, uint32_t *pts);
  */
 int av_render_query(av_render_handle_t h);
 
+/**
+ * @brief  Get audio jitter buffer statistics
+ *
+ * @param[in]   h     AV render handle
+ * @param[out]  stat  Jitter buffer statistics
+ *
+ * @return
+ *       - ESP_MEDIA_ERR_INVALID_ARG    Invalid argument
+ *       - ESP_MEDIA_ERR_WRONG_STATE    Jitter buffer not enabled or no audio stream
+ *       - ESP_MEDIA_ERR_OK             On success
+ */
+int av_render_get_jitter_stat(av_render_handle_t h, av_render_jitter_stat_t *stat);
+
+/**
+ * @brief  Get audio packet loss concealment statistics
+ *
+ * @note  Lost audio frames are detected from pts gaps against decoded frame duration
+ *
+ * @param[in]   h     AV render handle
+ * @param[out]  stat  Packet loss concealment statistics
+ *
+ * @return
+ *       - ESP_MEDIA_ERR_INVALID_ARG    Invalid argument
+ *       - ESP_MEDIA_ERR_WRONG_STATE    No audio stream
+ *       - ESP_MEDIA_ERR_OK             On success
+ */
+int av_render_get_plc_stat(av_render_handle_t h, av_render_plc_stat_t *stat);
+
+/**
+ * @brief  Get video drop statistics
+ *
+ * @param[in]   h     AV render handle
+ * @param[out]  stat  Video drop statistics
+ *
+ * @return
+ *       - ESP_MEDIA_ERR_INVALID_ARG    Invalid argument
+ *       - ESP_MEDIA_ERR_WRONG_STATE    No video stream
+ *       - ESP_MEDIA_ERR_OK             On success
+ */
+int av_render_get_drop_stat(av_render_handle_t h, av_render_drop_stat_t *stat);
+
+/**
+ * @brief  Get per-stage latency statistics
+ *
+ * @note  Only available when `latency_stats` is set in configuration
+ *        Stages without samples report zero count
+ *
+ * @param[in]   h      AV render handle
+ * @param[out]  stats  Latency statistics
+ *
+ * @return
+ *       - ESP_MEDIA_ERR_INVALID_ARG    Invalid argument
+ *       - ESP_MEDIA_ERR_NOT_SUPPORT    Latency statistics not enabled
+ *       - ESP_MEDIA_ERR_OK             On success
+ */
+int av_render_get_stats(av_render_handle_t h, av_render_stats_t *stats);
+
+/**
+ * @brief  Start binary trace capture
+ *
+ * @note  This API is used for debug only, restart capture if already started
+ *
+ * @param[in]  h    AV render handle
+ * @param[in]  cfg  Trace configuration
+ *
+ * @return
+ *       - ESP_MEDIA_ERR_INVALID_ARG  Invalid argument
+ *       - ESP_MEDIA_ERR_NO_MEM       No memory for ring buffer
+ *       - ESP_MEDIA_ERR_FAIL         Fail to open output or create thread
+ *       - ESP_MEDIA_ERR_OK           On success
+ */
+int av_render_trace_start(av_render_handle_t h, av_render_trace_cfg_t *cfg);
+
+/**
+ * @brief  Stop binary trace capture, records left in ring are drained before return
+ *
+ * @param[in]  h  AV render handle
+ *
+ * @return
+ *       - ESP_MEDIA_ERR_INVALID_ARG  Invalid argument
+ *       - ESP_MEDIA_ERR_OK           On success
+ */
+int av_render_trace_stop(av_render_handle_t h);
+
 /**
  * @brief  Dump data for AV render
  *
  * @note  This API is used for debug only
+ *        Capture full data of types in mask into "/sdcard/avtrace{N}.bin" through trace, set mask to 0 to stop
  *
  * @param[in]  h     AV render handle
- * @param[in]  mask  Dump mask
+ * @param[in]  mask  Dump mask, bit index is `av_render_trace_type_t`
  *
  * @return
  *       - ESP_MEDIA_ERR_INVALID_ARG  Invalid argument
@@ -47,6 +47,8 @@ typedef struct {
     audio_render_ref_cb    cb;           /*!< Reference output callback */
     bool                   fixed_clock;  /*!< Fixed clock mode */
     void                  *ctx;          /*!< User context */
+    uint32_t               dma_frames;   /*!< I2S DMA depth in sample frames (dma_desc_num * dma_frame_num),
+                                              bound output latency estimation, 0 to not bound */
 } i2s_render_cfg_t;
 
 /**
@@ -114,6 +114,9 @@ typedef enum {
     AV_RENDER_VIDEO_RAW_TYPE_YUV420,    /*!< YUV420 frame type */
     AV_RENDER_VIDEO_RAW_TYPE_RGB565,    /*!< RGB565 frame type */
     AV_RENDER_VIDEO_RAW_TYPE_RGB565_BE, /*!< RGB565 bigedian frame type */
+    AV_RENDER_VIDEO_RAW_TYPE_NV12,      /*!< NV12 frame type, Y plane followed by interleaved UV plane */
+    AV_RENDER_VIDEO_RAW_TYPE_YUYV,      /*!< YUYV packed frame type */
+    AV_RENDER_VIDEO_RAW_TYPE_RGB888,    /*!< RGB888 frame type, byte order R, G, B */
     AV_RENDER_VIDEO_RAW_TYPE_MAX,       /*!< Maximum of video render frame type */
 } av_render_video_frame_type_t;
 
@@ -164,10 +167,12 @@ typedef struct {
  * @brief  Audio data
  */
 typedef struct {
-    uint32_t pts;  /*!< PTS of audio data */
-    uint8_t *data; /*!< Audio data pointer */
-    uint32_t size; /*!< Audio data size */
-    bool     eos;  /*!< End of stream data*/
+    uint32_t pts;      /*!< PTS of audio data */
+    uint8_t *data;     /*!< Audio data pointer */
+    uint32_t size;     /*!< Audio data size */
+    bool     eos;      /*!< End of stream data*/
+    uint32_t deadline; /*!< Enqueue deadline in milliseconds of `esp_timer_get_time() / 1000`, 0 to wait forever
+                            Data is dropped if decoder fifo has no space before deadline */
 } av_render_audio_data_t;
 
 /**
@@ -179,6 +184,8 @@ typedef struct {
     uint8_t *data;      /*!< Video data pointer */
     uint32_t size;      /*!< Video data size */
     bool     eos;       /*!< End of stream data */
+    uint32_t deadline;  /*!< Enqueue deadline in milliseconds of `esp_timer_get_time() / 1000`, 0 to wait forever
+                             Data is dropped if decoder fifo has no space before deadline */
 } av_render_video_data_t;
 
 /**
@@ -27,6 +27,7 @@
 #include "esp_codec_dev.h"
 #include "esp_log.h"
 #include "esp_ae_sonic.h"
+#include "esp_timer.h"
 
 #define TAG "I2S_RENDER"
 
@@ -44,8 +45,52 @@ typedef struct {
     bool                         sonic_enable;
     char                        *sonic_out;
     int                          sonic_out_size;
+    uint32_t                     dma_frames;
+    media_lib_mutex_handle_t     pos_lock;
+    uint32_t                     written;     /* Sample frames written to device */
+    uint32_t                     played;      /* Sample frames played at anchor time */
+    int64_t                      anchor_time; /* Time when `played` is estimated (unit us) */
 } i2s_render_t;
 
+// Estimate played sample frames at `now`, DMA consume samples at sample rate once data is queued
+static uint32_t get_played_frames(i2s_render_t *i2s, int64_t now)
+{
+    int64_t elapse = (now - i2s->anchor_time) * i2s->info.sample_rate / 1000000;
+    if (elapse >= (int64_t)(i2s->written - i2s->played)) {
+        // Underrun, all written data already played
+        return i2s->written;
+    }
+    return i2s->played + (uint32_t)elapse;
+}
+
+static void update_play_position(i2s_render_t *i2s, uint32_t frames, bool write_done)
+{
+    if (i2s->info.sample_rate == 0) {
+        return;
+    }
+    media_lib_mutex_lock(i2s->pos_lock, MEDIA_LIB_MAX_LOCK_TIME);
+    int64_t now = esp_timer_get_time();
+    i2s->played = get_played_frames(i2s, now);
+    i2s->anchor_time = now;
+    if (write_done) {
+        i2s->written += frames;
+        // Write returns once data enters DMA buffer, queued data can not exceed its depth
+        if (i2s->dma_frames && i2s->written - i2s->played > i2s->dma_frames) {
+            i2s->played = i2s->written - i2s->dma_frames;
+        }
+    }
+    media_lib_mutex_unlock(i2s->pos_lock);
+}
+
+static void reset_play_position(i2s_render_t *i2s)
+{
+    media_lib_mutex_lock(i2s->pos_lock, MEDIA_LIB_MAX_LOCK_TIME);
+    i2s->written = 0;
+    i2s->played = 0;
+    i2s->anchor_time = esp_timer_get_time();
+    media_lib_mutex_unlock(i2s->pos_lock);
+}
+
 static audio_render_handle_t i2s_render_init(void *cfg, int cfg_size)
 {
     i2s_render_cfg_t *i2s_cfg = (i2s_render_cfg_t *)cfg;
@@ -60,11 +105,16 @@ static audio_render_handle_t i2s_render_init(void *cfg, int cfg_size)
     i2s->ref_ctx = i2s_cfg->ctx;
     i2s->fixed_clock = i2s_cfg->fixed_clock;
     i2s->play_handle = i2s_cfg->play_handle;
+    i2s->dma_frames = i2s_cfg->dma_frames;
     if (i2s->play_handle == NULL) {
         ESP_LOGE(TAG, "Play device not exists");
         media_lib_free(i2s);
         return NULL;
     }
+    if (media_lib_mutex_create(&i2s->pos_lock) != 0) {
+        media_lib_free(i2s);
+        return NULL;
+    }
     return i2s;
 }
 
@@ -85,6 +135,7 @@ static int i2s_render_open(audio_render_handle_t render, av_render_audio_frame_i
     if (ret == 0) {
         memcpy(&i2s->info, info, sizeof(av_render_audio_frame_info_t));
     }
+    reset_play_position(i2s);
     return ret;
 }
 
@@ -114,7 +165,9 @@ static int i2s_render_write(audio_render_handle_t render, av_render_audio_frame_
             if (out_samples.out_num == 0) {
                 break;
             }
+            update_play_position(i2s, 0, false);
             ret = esp_codec_dev_write(i2s->play_handle, out_samples.samples, out_samples.out_num * SAMPLE_SIZE(i2s->info));
+            update_play_position(i2s, out_samples.out_num, ret == 0);
             if (ret == 0 && i2s->ref_cb) {
                 i2s->ref_cb(audio_data->data, audio_data->size, i2s->ref_ctx);
             }
@@ -123,7 +176,9 @@ static int i2s_render_write(audio_render_handle_t render, av_render_audio_frame_
             in_samples.samples = audio_data->data + in_samples.consume_num * SAMPLE_SIZE(i2s->info);
         }
     } else {
+        update_play_position(i2s, 0, false);
         int ret = esp_codec_dev_write(i2s->play_handle, audio_data->data, audio_data->size);
+        update_play_position(i2s, audio_data->size / SAMPLE_SIZE(i2s->info), ret == 0);
         if (ret == 0 && i2s->ref_cb) {
             i2s->ref_cb(audio_data->data, audio_data->size, i2s->ref_ctx);
         }
@@ -136,7 +191,15 @@ static int i2s_render_get_latency(audio_render_handle_t render, uint32_t *latenc
     if (render == NULL) {
         return -1;
     }
+    i2s_render_t *i2s = (i2s_render_t *)render;
     *latency = 0;
+    if (i2s->info.sample_rate) {
+        // Latency is duration of data written but not played yet
+        media_lib_mutex_lock(i2s->pos_lock, MEDIA_LIB_MAX_LOCK_TIME);
+        uint32_t queued = i2s->written - get_played_frames(i2s, esp_timer_get_time());
+        media_lib_mutex_unlock(i2s->pos_lock);
+        *latency = (uint32_t)((uint64_t)queued * 1000 / i2s->info.sample_rate);
+    }
     return 0;
 }
 
@@ -192,6 +255,7 @@ static int i2s_render_close(audio_render_handle_t render)
         i2s->sonic_out = NULL;
     }
     i2s->sonic_enable = false;
+    reset_play_position(i2s);
     return 0;
 }
 
@@ -200,6 +264,10 @@ static void i2s_render_deinit(audio_render_handle_t render)
     if (render == NULL) {
         return;
     }
+    i2s_render_t *i2s = (i2s_render_t *)render;
+    if (i2s->pos_lock) {
+        media_lib_mutex_destroy(i2s->pos_lock);
+    }
     media_lib_free(render);
 }
 
@@ -0,0 +1,121 @@
+/**
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2025 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <string.h>
+#include "media_lib_os.h"
+#include "audio_catchup.h"
+
+// Search period in range of 2.5ms to 10ms, cover most speech pitch
+#define CATCHUP_MIN_PERIOD_MS_X10 (25)
+#define CATCHUP_MAX_PERIOD_MS_X10 (100)
+
+static int16_t get_mono(int16_t *in, int channel, int i)
+{
+    if (channel == 2) {
+        return (int16_t)((in[2 * i] + in[2 * i + 1]) >> 1);
+    }
+    return in[i * channel];
+}
+
+// Find period which makes two neighbor segments most similar so that cross-fade cause less artifact
+static int find_period(audio_catchup_t *c, int16_t *in, int min_period, int max_period)
+{
+    int best = min_period;
+    int64_t best_score = INT64_MIN;
+    for (int period = min_period; period <= max_period; period += 2) {
+        int64_t corr = 0, energy = 0;
+        for (int i = 0; i < period; i += 2) {
+            int32_t a = get_mono(in, c->channel, i);
+            int32_t b = get_mono(in, c->channel, i + period);
+            corr += a * b;
+            energy += b * b;
+        }
+        // Normalize by energy of second segment, compare as corr / sqrt(energy) without sqrt
+        int64_t score = energy ? (corr < 0 ? -1 : 1) * (corr / 1024) * (corr / 1024) / (energy / 1024 + 1) : 0;
+        if (score > best_score) {
+            best_score = score;
+            best = period;
+        }
+    }
+    return best;
+}
+
+int audio_catchup_process(audio_catchup_t *c, float speed, int16_t *in, int samples, int16_t **out)
+{
+    *out = in;
+    if (speed <= 1.0f || c->sample_rate == 0) {
+        c->budget = 0;
+        return samples;
+    }
+    c->budget += samples * (1.0f - 1.0f / speed);
+    int min_period = c->sample_rate * CATCHUP_MIN_PERIOD_MS_X10 / 10000;
+    int max_period = c->sample_rate * CATCHUP_MAX_PERIOD_MS_X10 / 10000;
+    if (max_period > samples / 2) {
+        max_period = samples / 2;
+    }
+    if (c->budget < min_period || max_period < min_period) {
+        return samples;
+    }
+    int size = samples * c->channel * sizeof(int16_t);
+    if (c->out_size < size) {
+        int16_t *new_out = media_lib_realloc(c->out, size);
+        if (new_out == NULL) {
+            return samples;
+        }
+        c->out = new_out;
+        c->out_size = size;
+    }
+    int period = find_period(c, in, min_period, max_period);
+    int channel = c->channel;
+    // Cross-fade first period into second one, then keep the rest
+    for (int i = 0; i < period; i++) {
+        for (int ch = 0; ch < channel; ch++) {
+            int32_t a = in[i * channel + ch];
+            int32_t b = in[(i + period) * channel + ch];
+            c->out[i * channel + ch] = (int16_t)((a * (period - i) + b * i) / period);
+        }
+    }
+    memcpy(c->out + period * channel, in + 2 * period * channel, (samples - 2 * period) * channel * sizeof(int16_t));
+    c->budget -= period;
+    c->trimmed += period;
+    *out = c->out;
+    return samples - period;
+}
+
+void audio_catchup_reset(audio_catchup_t *c, int sample_rate, int channel)
+{
+    c->sample_rate = (channel == 1 || channel == 2) ? sample_rate : 0;
+    c->channel = channel;
+    c->budget = 0;
+}
+
+void audio_catchup_deinit(audio_catchup_t *c)
+{
+    if (c->out) {
+        media_lib_free(c->out);
+        c->out = NULL;
+    }
+    c->out_size = 0;
+}
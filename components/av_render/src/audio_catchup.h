@@ -0,0 +1,48 @@
+/**
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2025 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef AUDIO_CATCHUP_H
+#define AUDIO_CATCHUP_H
+
+#include <stdint.h>
+
+// Time compression without pitch change, remove one pitch period with cross-fade when enough time saved
+typedef struct {
+    int      sample_rate;
+    int      channel;
+    float    budget;   // Samples pending to be removed
+    int16_t *out;
+    int      out_size;
+    uint32_t trimmed;  // Total removed samples
+} audio_catchup_t;
+
+// Process 16 bits interleaved PCM, return output sample number, output is `in` when nothing removed
+int audio_catchup_process(audio_catchup_t *c, float speed, int16_t *in, int samples, int16_t **out);
+
+void audio_catchup_reset(audio_catchup_t *c, int sample_rate, int channel);
+
+void audio_catchup_deinit(audio_catchup_t *c);
+
+#endif
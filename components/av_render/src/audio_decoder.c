@@ -42,6 +42,7 @@ typedef struct {
     void                        *ctx;
     uint8_t                     *frame_data;
     int                          frame_size;
+    adec_fb_cb_cfg_t             fb_cb;
 } adec_t;
 
 static esp_audio_type_t get_audio_decoder_type(av_render_audio_codec_t audio_format)
@@ -176,35 +177,58 @@ static int _close_audio_dec(adec_t *adec)
     return -1;
 }
 
+static uint8_t *adec_fetch_output(adec_t *adec)
+{
+    if (adec->fb_cb.fb_fetch) {
+        uint8_t *buffer = adec->fb_cb.fb_fetch(adec->frame_size, adec->fb_cb.ctx);
+        if (buffer) {
+            return buffer;
+        }
+    }
+    return adec->frame_data;
+}
+
+static void adec_return_output(adec_t *adec, uint8_t *buffer, bool drop)
+{
+    if (buffer != adec->frame_data && adec->fb_cb.fb_return) {
+        adec->fb_cb.fb_return(buffer, drop, adec->fb_cb.ctx);
+    }
+}
+
 static int decoder_one_frame(adec_t *adec, uint8_t *data, int size, av_render_audio_frame_t *frame_data)
 {
     esp_audio_dec_in_raw_t raw = {
         .buffer = data,
         .len = size,
     };
-    esp_audio_dec_out_frame_t frame = {
-        .buffer = adec->frame_data,
-        .len = adec->frame_size,
-    };
+    esp_audio_dec_out_frame_t frame = {};
 RETRY:
+    // Output buffer sized by max decoded frame size, may be provided by user to avoid extra copy
+    frame.buffer = adec_fetch_output(adec);
+    frame.len = adec->frame_size;
     frame.decoded_size = 0;
     esp_audio_err_t ret = esp_audio_dec_process(adec->dec_handle, &raw, &frame);
     if (ret == ESP_AUDIO_ERR_BUFF_NOT_ENOUGH) {
+        adec_return_output(adec, frame.buffer, true);
         ESP_LOGI(TAG, "Enlarge PCM buffer to %" PRIu32, frame.needed_size);
         uint8_t *output_fifo = (uint8_t *)media_lib_realloc(adec->frame_data, frame.needed_size);
         if (output_fifo == NULL) {
             return ESP_MEDIA_ERR_NO_MEM;
         }
-        frame.buffer = output_fifo;
-        frame.len = frame.needed_size;
         adec->frame_data = output_fifo;
         adec->frame_size = frame.needed_size;
         goto RETRY;
     }
     if (ret != ESP_AUDIO_ERR_OK) {
+        adec_return_output(adec, frame.buffer, true);
         ESP_LOGE(TAG, "Audio decode error %d", ret);
         return ret;
     }
+    if (size == 0 && frame.decoded_size == 0) {
+        // Decoder can not generate concealment frame
+        adec_return_output(adec, frame.buffer, true);
+        return ESP_MEDIA_ERR_NOT_SUPPORT;
+    }
     if (adec->header_parsed == false && frame.decoded_size > 0) {
         esp_audio_dec_info_t header = {};
         esp_audio_dec_get_info(adec->dec_handle, &header);
@@ -216,11 +240,12 @@ RETRY:
         }
         adec->header_parsed = true;
     }
-    frame_data->data = adec->frame_data;
+    frame_data->data = frame.buffer;
     frame_data->size = frame.decoded_size;
     if (adec->frame_cb) {
         adec->frame_cb(frame_data, adec->ctx);
     }
+    adec_return_output(adec, frame.buffer, false);
     if (raw.consumed < raw.len) {
         raw.buffer += raw.consumed;
         raw.len -= raw.consumed;
@@ -260,6 +285,16 @@ adec_handle_t adec_open(adec_cfg_t *cfg)
     return NULL;
 }
 
+int adec_set_fb_cb(adec_handle_t h, adec_fb_cb_cfg_t *cfg)
+{
+    adec_t *adec = (adec_t *)h;
+    if (adec == NULL || cfg == NULL || cfg->fb_fetch == NULL || cfg->fb_return == NULL) {
+        return ESP_MEDIA_ERR_INVALID_ARG;
+    }
+    adec->fb_cb = *cfg;
+    return ESP_MEDIA_ERR_OK;
+}
+
 int adec_decode(adec_handle_t h, av_render_audio_data_t *data)
 {
     if (h == NULL || data == NULL || (data->size == 0 && data->eos == false)) {
@@ -280,6 +315,22 @@ int adec_decode(adec_handle_t h, av_render_audio_data_t *data)
     return _start_audio_dec(adec, data, &frame_data);
 }
 
+int adec_conceal(adec_handle_t h, uint32_t pts)
+{
+    adec_t *adec = (adec_t *)h;
+    if (adec == NULL) {
+        return ESP_MEDIA_ERR_INVALID_ARG;
+    }
+    // Only OPUS decoder do packet loss concealment when decode without input data
+    if (adec->codec != AV_RENDER_AUDIO_CODEC_OPUS || adec->header_parsed == false) {
+        return ESP_MEDIA_ERR_NOT_SUPPORT;
+    }
+    av_render_audio_frame_t frame_data = {
+        .pts = pts,
+    };
+    return decoder_one_frame(adec, NULL, 0, &frame_data);
+}
+
 int adec_get_frame_info(adec_handle_t h, av_render_audio_frame_info_t *frame_info)
 {
     if (h == NULL || frame_info == NULL) {
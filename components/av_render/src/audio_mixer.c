@@ -0,0 +1,339 @@
+/**
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2025 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <string.h>
+#include "media_lib_os.h"
+#include "media_lib_err.h"
+#include "audio_resample.h"
+#include "audio_mixer.h"
+#include "esp_log.h"
+
+#define TAG "AUD_MIXER"
+
+// Gain stored as Q12 so that boost up to 8x kept in int32 multiply
+#define GAIN_SHIFT    (12)
+#define GAIN_UNITY    (1 << GAIN_SHIFT)
+#define GAIN_MAX      (8.0f)
+// Resample may output some more samples than rate ratio
+#define RESAMPLE_SLACK (32)
+
+typedef struct {
+    bool                         used;
+    av_render_audio_frame_info_t in_info;
+    audio_resample_handle_t      resample;
+    int32_t                      gain;
+    int16_t                     *fifo;
+    uint32_t                     fifo_size;  // Unit int16 value
+    uint32_t                     rd;
+    uint32_t                     wr;
+} audio_mix_stream_t;
+
+struct audio_mixer_t {
+    av_render_audio_frame_info_t out_info;
+    audio_mix_stream_t           streams[AUDIO_MIXER_MAX_STREAMS];
+    int32_t                      main_gain;
+    int                          fifo_ms;
+    media_lib_mutex_handle_t     lock;
+    media_lib_sema_handle_t      space_sema;
+};
+
+static int32_t to_gain(float gain)
+{
+    if (gain < 0.0f) {
+        gain = 0.0f;
+    } else if (gain > GAIN_MAX) {
+        gain = GAIN_MAX;
+    }
+    return (int32_t)(gain * GAIN_UNITY + 0.5f);
+}
+
+static audio_mix_stream_t *get_stream(audio_mixer_t *mixer, int id)
+{
+    if (id <= 0 || id > AUDIO_MIXER_MAX_STREAMS || mixer->streams[id - 1].used == false) {
+        return NULL;
+    }
+    return &mixer->streams[id - 1];
+}
+
+static void fifo_push(audio_mix_stream_t *stream, int16_t *data, int num)
+{
+    for (int i = 0; i < num; i++) {
+        stream->fifo[(stream->wr + i) % stream->fifo_size] = data[i];
+    }
+    stream->wr += num;
+}
+
+static int resample_out(av_render_audio_frame_t *frame, void *ctx)
+{
+    audio_mix_stream_t *stream = (audio_mix_stream_t *)ctx;
+    int num = frame->size / sizeof(int16_t);
+    int space = stream->fifo_size - (stream->wr - stream->rd);
+    if (num > space) {
+        // Only happen when resample output exceed estimate, drop tail rather than overwrite unplayed data
+        num = space;
+    }
+    fifo_push(stream, (int16_t *)frame->data, num);
+    return 0;
+}
+
+static void free_stream(audio_mix_stream_t *stream)
+{
+    if (stream->resample) {
+        audio_resample_close(stream->resample);
+    }
+    if (stream->fifo) {
+        media_lib_free(stream->fifo);
+    }
+    memset(stream, 0, sizeof(audio_mix_stream_t));
+}
+
+audio_mixer_t *audio_mixer_create(av_render_audio_frame_info_t *out_info, int fifo_ms)
+{
+    if (out_info->bits_per_sample != 16 || out_info->channel == 0 || out_info->sample_rate == 0) {
+        ESP_LOGE(TAG, "Only support 16 bits output");
+        return NULL;
+    }
+    audio_mixer_t *mixer = (audio_mixer_t *)media_lib_calloc(1, sizeof(audio_mixer_t));
+    if (mixer == NULL) {
+        return NULL;
+    }
+    mixer->out_info = *out_info;
+    mixer->fifo_ms = fifo_ms;
+    mixer->main_gain = GAIN_UNITY;
+    media_lib_mutex_create(&mixer->lock);
+    media_lib_sema_create(&mixer->space_sema);
+    if (mixer->lock == NULL || mixer->space_sema == NULL) {
+        audio_mixer_destroy(mixer);
+        return NULL;
+    }
+    return mixer;
+}
+
+int audio_mixer_add_stream(audio_mixer_t *mixer, av_render_audio_frame_info_t *in_info, float gain)
+{
+    if (in_info->bits_per_sample != 16) {
+        return ESP_MEDIA_ERR_NOT_SUPPORT;
+    }
+    media_lib_mutex_lock(mixer->lock, MEDIA_LIB_MAX_LOCK_TIME);
+    int ret = ESP_MEDIA_ERR_EXCEED_LIMIT;
+    for (int i = 0; i < AUDIO_MIXER_MAX_STREAMS; i++) {
+        audio_mix_stream_t *stream = &mixer->streams[i];
+        if (stream->used) {
+            continue;
+        }
+        av_render_audio_frame_info_t *out = &mixer->out_info;
+        stream->fifo_size = out->sample_rate * mixer->fifo_ms / 1000 * out->channel;
+        stream->fifo = (int16_t *)media_lib_malloc(stream->fifo_size * sizeof(int16_t));
+        if (stream->fifo == NULL) {
+            ret = ESP_MEDIA_ERR_NO_MEM;
+            break;
+        }
+        if (memcmp(in_info, out, sizeof(av_render_audio_frame_info_t))) {
+            audio_resample_cfg_t cfg = {
+                .input_info = *in_info,
+                .output_info = *out,
+                .resample_cb = resample_out,
+                .ctx = stream,
+            };
+            stream->resample = audio_resample_open(&cfg);
+            if (stream->resample == NULL) {
+                free_stream(stream);
+                ret = ESP_MEDIA_ERR_NOT_SUPPORT;
+                break;
+            }
+        }
+        stream->in_info = *in_info;
+        stream->gain = to_gain(gain);
+        stream->used = true;
+        ret = i + 1;
+        break;
+    }
+    media_lib_mutex_unlock(mixer->lock);
+    return ret;
+}
+
+int audio_mixer_remove_stream(audio_mixer_t *mixer, int id)
+{
+    media_lib_mutex_lock(mixer->lock, MEDIA_LIB_MAX_LOCK_TIME);
+    audio_mix_stream_t *stream = get_stream(mixer, id);
+    if (stream) {
+        free_stream(stream);
+    }
+    media_lib_mutex_unlock(mixer->lock);
+    // Wake writer of removed stream
+    media_lib_sema_unlock(mixer->space_sema);
+    return stream ? ESP_MEDIA_ERR_OK : ESP_MEDIA_ERR_INVALID_ARG;
+}
+
+int audio_mixer_set_gain(audio_mixer_t *mixer, int id, float gain)
+{
+    int ret = ESP_MEDIA_ERR_OK;
+    media_lib_mutex_lock(mixer->lock, MEDIA_LIB_MAX_LOCK_TIME);
+    if (id == AUDIO_MIXER_MAIN_STREAM) {
+        mixer->main_gain = to_gain(gain);
+    } else {
+        audio_mix_stream_t *stream = get_stream(mixer, id);
+        if (stream) {
+            stream->gain = to_gain(gain);
+        } else {
+            ret = ESP_MEDIA_ERR_INVALID_ARG;
+        }
+    }
+    media_lib_mutex_unlock(mixer->lock);
+    return ret;
+}
+
+int audio_mixer_write(audio_mixer_t *mixer, int id, uint8_t *data, int size)
+{
+    media_lib_mutex_lock(mixer->lock, MEDIA_LIB_MAX_LOCK_TIME);
+    int ret = ESP_MEDIA_ERR_OK;
+    do {
+        audio_mix_stream_t *stream = get_stream(mixer, id);
+        if (stream == NULL) {
+            ret = ESP_MEDIA_ERR_INVALID_ARG;
+            break;
+        }
+        av_render_audio_frame_info_t *in = &stream->in_info;
+        av_render_audio_frame_info_t *out = &mixer->out_info;
+        int in_samples = size / (in->channel * sizeof(int16_t));
+        uint32_t need = (uint32_t)((uint64_t)in_samples * out->sample_rate / in->sample_rate + RESAMPLE_SLACK) * out->channel;
+        if (need > stream->fifo_size) {
+            ret = ESP_MEDIA_ERR_INVALID_ARG;
+            break;
+        }
+        if (stream->fifo_size - (stream->wr - stream->rd) < need) {
+            ret = ESP_MEDIA_ERR_EXCEED_LIMIT;
+            break;
+        }
+        if (stream->resample) {
+            av_render_audio_frame_t frame = {
+                .data = data,
+                .size = size,
+            };
+            ret = audio_resample_write(stream->resample, &frame);
+        } else {
+            fifo_push(stream, (int16_t *)data, size / sizeof(int16_t));
+        }
+    } while (0);
+    media_lib_mutex_unlock(mixer->lock);
+    return ret;
+}
+
+void audio_mixer_wait_space(audio_mixer_t *mixer, uint32_t timeout)
+{
+    media_lib_sema_lock(mixer->space_sema, timeout);
+}
+
+void audio_mixer_wakeup(audio_mixer_t *mixer)
+{
+    media_lib_sema_unlock(mixer->space_sema);
+}
+
+int audio_mixer_get_pending(audio_mixer_t *mixer, int id)
+{
+    int pending = 0;
+    media_lib_mutex_lock(mixer->lock, MEDIA_LIB_MAX_LOCK_TIME);
+    for (int i = 0; i < AUDIO_MIXER_MAX_STREAMS; i++) {
+        audio_mix_stream_t *stream = &mixer->streams[i];
+        if (stream->used == false || (id && id != i + 1)) {
+            continue;
+        }
+        int n = (stream->wr - stream->rd) / mixer->out_info.channel;
+        if (n > pending) {
+            pending = n;
+        }
+    }
+    media_lib_mutex_unlock(mixer->lock);
+    return pending;
+}
+
+bool audio_mixer_need_mix(audio_mixer_t *mixer)
+{
+    return mixer->main_gain != GAIN_UNITY || audio_mixer_get_pending(mixer, 0) > 0;
+}
+
+static inline int16_t clip_int16(int32_t v)
+{
+    if (v > 32767) {
+        return 32767;
+    }
+    if (v < -32768) {
+        return -32768;
+    }
+    return (int16_t)v;
+}
+
+void audio_mixer_process(audio_mixer_t *mixer, int16_t *main, int16_t *out, int samples)
+{
+    int num = samples * mixer->out_info.channel;
+    media_lib_mutex_lock(mixer->lock, MEDIA_LIB_MAX_LOCK_TIME);
+    if (main == NULL) {
+        memset(out, 0, num * sizeof(int16_t));
+    } else if (mixer->main_gain != GAIN_UNITY) {
+        for (int i = 0; i < num; i++) {
+            out[i] = clip_int16((main[i] * mixer->main_gain) >> GAIN_SHIFT);
+        }
+    } else if (out != main) {
+        memcpy(out, main, num * sizeof(int16_t));
+    }
+    bool consumed = false;
+    for (int s = 0; s < AUDIO_MIXER_MAX_STREAMS; s++) {
+        audio_mix_stream_t *stream = &mixer->streams[s];
+        if (stream->used == false) {
+            continue;
+        }
+        int n = stream->wr - stream->rd;
+        if (n > num) {
+            n = num;
+        }
+        for (int i = 0; i < n; i++) {
+            int32_t v = stream->fifo[(stream->rd + i) % stream->fifo_size];
+            out[i] = clip_int16(out[i] + ((v * stream->gain) >> GAIN_SHIFT));
+        }
+        stream->rd += n;
+        consumed |= (n > 0);
+    }
+    media_lib_mutex_unlock(mixer->lock);
+    if (consumed) {
+        media_lib_sema_unlock(mixer->space_sema);
+    }
+}
+
+void audio_mixer_destroy(audio_mixer_t *mixer)
+{
+    if (mixer == NULL) {
+        return;
+    }
+    for (int i = 0; i < AUDIO_MIXER_MAX_STREAMS; i++) {
+        free_stream(&mixer->streams[i]);
+    }
+    if (mixer->lock) {
+        media_lib_mutex_destroy(mixer->lock);
+    }
+    if (mixer->space_sema) {
+        media_lib_sema_destroy(mixer->space_sema);
+    }
+    media_lib_free(mixer);
+}
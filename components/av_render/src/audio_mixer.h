@@ -0,0 +1,69 @@
+/**
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2025 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef AUDIO_MIXER_H
+#define AUDIO_MIXER_H
+
+#include <stdbool.h>
+#include "av_render_types.h"
+
+// Mix extra PCM streams into main audio with per stream gain
+// Every stream is resampled into fixed output format and buffered in its own fifo
+// Only 16 bits PCM supported, stream id 0 stands for main stream
+#define AUDIO_MIXER_MAX_STREAMS (4)
+#define AUDIO_MIXER_MAIN_STREAM (0)
+
+typedef struct audio_mixer_t audio_mixer_t;
+
+audio_mixer_t *audio_mixer_create(av_render_audio_frame_info_t *out_info, int fifo_ms);
+
+// Return stream id bigger than 0, negative when fail
+int audio_mixer_add_stream(audio_mixer_t *mixer, av_render_audio_frame_info_t *in_info, float gain);
+
+int audio_mixer_remove_stream(audio_mixer_t *mixer, int id);
+
+int audio_mixer_set_gain(audio_mixer_t *mixer, int id, float gain);
+
+// Resample and queue whole data, return ESP_MEDIA_ERR_EXCEED_LIMIT without consume when fifo space not enough
+int audio_mixer_write(audio_mixer_t *mixer, int id, uint8_t *data, int size);
+
+// Wait for fifo space released by mixing or timeout (unit ms)
+void audio_mixer_wait_space(audio_mixer_t *mixer, uint32_t timeout);
+
+// Wake one writer waiting for fifo space
+void audio_mixer_wakeup(audio_mixer_t *mixer);
+
+// Get pending samples of one stream, or max pending samples of all streams when id is 0
+int audio_mixer_get_pending(audio_mixer_t *mixer, int id);
+
+// Whether frame needs mixing, pending stream data or main gain not unity
+bool audio_mixer_need_mix(audio_mixer_t *mixer);
+
+// Mix main PCM (NULL as silence) with pending streams into out, samples counted per channel
+void audio_mixer_process(audio_mixer_t *mixer, int16_t *main, int16_t *out, int samples);
+
+void audio_mixer_destroy(audio_mixer_t *mixer);
+
+#endif
@@ -58,6 +58,11 @@
 
 #define SAMPLE_SIZE(info) (info.channel * (info.bits_per_sample >> 3))
 
+// Fused converter supports integer decimation only, filter length is taps per phase multiply decimation
+#define FUSED_MAX_DECIMATION (6)
+#define FUSED_TAPS_PER_PHASE (16)
+#define FUSED_COEF_SHIFT     (14)
+
 typedef struct {
     uint8_t *data;
     int      size;
@@ -71,6 +76,19 @@ typedef enum {
     RESAMPLE_OPS_RATE_CVT,
 } resample_ops_t;
 
+typedef struct {
+    bool     enable;
+    uint8_t  src_ch;
+    uint8_t  dst_ch;
+    uint8_t  src_bytes;
+    int      decimation;
+    int      taps;
+    const int16_t *coef;
+    int16_t       *delay;
+    int      pos;
+    int      phase;
+} fused_cvt_t;
+
 typedef struct {
     audio_resample_cfg_t     cfg;
     esp_ae_ch_cvt_handle_t   ch_cvt_handle;
@@ -78,6 +96,7 @@ typedef struct {
     esp_ae_bit_cvt_handle_t  bit_cvt_handle;
     resample_ops_t           ops[3];
     work_buf_t               work_buf[2];
+    fused_cvt_t              fused;
 } resample_t;
 
 static int add_bits_resample(resample_t *resample, audio_resample_cfg_t *cfg, int i)
@@ -149,6 +168,195 @@ static int get_need_size(resample_t *resample, resample_ops_t op, uint32_t *samp
     return 0;
 }
 
+/**
+ * Blackman windowed sinc low pass for each decimation, cutoff at 0.9 of output nyquist
+ * DC gain normalized to 1 in Q14, rounding residual put into center tap
+ * Precalculated to avoid floating point math on audio thread stack
+ */
+static const int16_t fused_coef_2[32] = {
+    0, 1, 1, -14, -17, 45, 78, -86, -235, 89, 559, 64, -1176, -718, 2854, 6746,
+    6748, 2854, -718, -1176, 64, 559, 89, -235, -86, 78, 45, -17, -14, 1, 1, 0,
+};
+
+static const int16_t fused_coef_3[48] = {
+    0, 0, 2, 2, -3, -13, -15, 5, 41, 58, 14, -86, -160, -96, 125, 351,
+    322, -92, -675, -889, -213, 1409, 3378, 4727, 4727, 3378, 1409, -213, -889, -675, -92, 322,
+    351, 125, -96, -160, -86, 14, 58, 41, 5, -15, -13, -3, 2, 2, 0, 0,
+};
+
+static const int16_t fused_coef_4[64] = {
+    0, 0, 1, 1, 2, -1, -5, -11, -12, -4, 14, 35, 45, 30, -15, -75,
+    -119, -107, -21, 119, 250, 284, 158, -123, -458, -670, -568, -42, 877, 1995, 3006, 3607,
+    3605, 3006, 1995, 877, -42, -568, -670, -458, -123, 158, 284, 250, 119, -21, -107, -119,
+    -75, -15, 30, 45, 35, 14, -4, -12, -11, -5, -1, 2, 1, 1, 0, 0,
+};
+
+static const int16_t fused_coef_5[80] = {
+    0, 0, 0, 1, 1, 1, 0, -2, -6, -9, -10, -6, 3, 16, 30, 36,
+    30, 9, -26, -65, -94, -95, -59, 14, 108, 193, 232, 195, 70, -126, -342, -505,
+    -535, -366, 28, 618, 1325, 2027, 2593, 2908, 2908, 2593, 2027, 1325, 618, 28, -366, -535,
+    -505, -342, -126, 70, 195, 232, 193, 108, 14, -59, -95, -94, -65, -26, 9, 30,
+    36, 30, 16, 3, -6, -10, -9, -6, -2, 0, 1, 1, 1, 0, 0, 0,
+};
+
+static const int16_t fused_coef_6[96] = {
+    0, 0, 0, 0, 1, 1, 1, 1, -1, -3, -6, -8, -9, -6, -1, 7,
+    17, 26, 30, 28, 16, -4, -30, -57, -77, -82, -66, -27, 31, 97, 156, 191,
+    184, 128, 22, -120, -271, -395, -453, -409, -240, 58, 469, 953, 1453, 1906, 2249, 2434,
+    2430, 2249, 1906, 1453, 953, 469, 58, -240, -409, -453, -395, -271, -120, 22, 128, 184,
+    191, 156, 97, 31, -27, -66, -82, -77, -57, -30, -4, 16, 28, 30, 26, 17,
+    7, -1, -6, -9, -8, -6, -3, -1, 1, 1, 1, 1, 0, 0, 0, 0,
+};
+
+static const int16_t *fused_coef[FUSED_MAX_DECIMATION + 1] = {
+    NULL, NULL, fused_coef_2, fused_coef_3, fused_coef_4, fused_coef_5, fused_coef_6,
+};
+
+static bool fused_cvt_supported(audio_resample_cfg_t *cfg)
+{
+    av_render_audio_frame_info_t *in = &cfg->input_info;
+    av_render_audio_frame_info_t *out = &cfg->output_info;
+    if (out->bits_per_sample != 16 || (in->bits_per_sample != 16 && in->bits_per_sample != 24 && in->bits_per_sample != 32)) {
+        return false;
+    }
+    if (in->channel == 0 || in->channel > 2 || out->channel == 0 || out->channel > in->channel) {
+        return false;
+    }
+    if (out->sample_rate == 0 || in->sample_rate % out->sample_rate) {
+        return false;
+    }
+    return in->sample_rate / out->sample_rate <= FUSED_MAX_DECIMATION;
+}
+
+static int fused_cvt_open(fused_cvt_t *fused, audio_resample_cfg_t *cfg)
+{
+    fused->src_ch = cfg->input_info.channel;
+    fused->dst_ch = cfg->output_info.channel;
+    fused->src_bytes = cfg->input_info.bits_per_sample >> 3;
+    fused->decimation = cfg->input_info.sample_rate / cfg->output_info.sample_rate;
+    if (fused->decimation > 1) {
+        int taps = FUSED_TAPS_PER_PHASE * fused->decimation;
+        fused->coef = fused_coef[fused->decimation];
+        // Double write history so that filter window is always continuous
+        fused->delay = (int16_t *)media_lib_calloc(1, 2 * taps * fused->dst_ch * sizeof(int16_t));
+        if (fused->delay == NULL) {
+            return ESP_MEDIA_ERR_NO_MEM;
+        }
+        fused->taps = taps;
+    }
+    fused->enable = true;
+    return ESP_MEDIA_ERR_OK;
+}
+
+static void fused_cvt_close(fused_cvt_t *fused)
+{
+    fused->coef = NULL;
+    if (fused->delay) {
+        media_lib_free(fused->delay);
+        fused->delay = NULL;
+    }
+    fused->enable = false;
+}
+
+static inline int32_t fused_read_sample(const uint8_t *p, int bytes)
+{
+    // Read little endian sample and left align to 32 bits
+    if (bytes == 2) {
+        return (int32_t)(((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 24));
+    }
+    if (bytes == 3) {
+        return (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24));
+    }
+    return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+static inline int16_t fused_saturate(int32_t v)
+{
+    if (v > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (v < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)v;
+}
+
+static inline int16_t fused_fir(const int16_t *x, const int16_t *coef, int taps)
+{
+    // Taps always multiple of FUSED_TAPS_PER_PHASE, use two accumulators to shorten dependency chain
+    int32_t acc0 = 0, acc1 = 0;
+    for (int i = 0; i < taps; i += 2) {
+        acc0 += (int32_t)x[i] * coef[i];
+        acc1 += (int32_t)x[i + 1] * coef[i + 1];
+    }
+    return fused_saturate((acc0 + acc1 + (1 << (FUSED_COEF_SHIFT - 1))) >> FUSED_COEF_SHIFT);
+}
+
+static int fused_cvt_process(fused_cvt_t *fused, const uint8_t *in, int sample_num, int16_t *out)
+{
+    int in_step = fused->src_ch * fused->src_bytes;
+    int taps = fused->taps;
+    int16_t *out_start = out;
+    for (int n = 0; n < sample_num; n++, in += in_step) {
+        // Downmix and requantize to 16 bits in one step
+        int16_t s[2];
+        if (fused->src_ch == 2 && fused->dst_ch == 1) {
+            int32_t v = (fused_read_sample(in, fused->src_bytes) >> 1) + (fused_read_sample(in + fused->src_bytes, fused->src_bytes) >> 1);
+            s[0] = fused_saturate(((v >> 15) + 1) >> 1);
+        } else {
+            for (int ch = 0; ch < fused->dst_ch; ch++) {
+                int32_t v = fused_read_sample(in + ch * fused->src_bytes, fused->src_bytes);
+                s[ch] = fused_saturate(((v >> 15) + 1) >> 1);
+            }
+        }
+        if (fused->decimation == 1) {
+            for (int ch = 0; ch < fused->dst_ch; ch++) {
+                *(out++) = s[ch];
+            }
+            continue;
+        }
+        for (int ch = 0; ch < fused->dst_ch; ch++) {
+            int16_t *delay = fused->delay + ch * 2 * taps;
+            delay[fused->pos] = delay[fused->pos + taps] = s[ch];
+        }
+        if (++fused->pos == taps) {
+            fused->pos = 0;
+        }
+        if (++fused->phase < fused->decimation) {
+            continue;
+        }
+        fused->phase = 0;
+        // Only compute kept output samples (polyphase decimation)
+        for (int ch = 0; ch < fused->dst_ch; ch++) {
+            *(out++) = fused_fir(fused->delay + ch * 2 * taps + fused->pos, fused->coef, taps);
+        }
+    }
+    return (int)(out - out_start) / fused->dst_ch;
+}
+
+static int fused_cvt_write(resample_t *resample, av_render_audio_frame_t *data)
+{
+    fused_cvt_t *fused = &resample->fused;
+    int sample_num = data->size / (fused->src_ch * fused->src_bytes);
+    int out_num = (fused->phase + sample_num) / fused->decimation;
+    if (out_num == 0) {
+        // Keep in filter history only
+        fused_cvt_process(fused, data->data, sample_num, NULL);
+        return ESP_MEDIA_ERR_OK;
+    }
+    work_buf_t *out = alloc_work_buf(resample, out_num * fused->dst_ch * sizeof(int16_t));
+    if (out == NULL) {
+        return ESP_MEDIA_ERR_NO_MEM;
+    }
+    out_num = fused_cvt_process(fused, data->data, sample_num, (int16_t *)out->data);
+    release_work_buf(out);
+    av_render_audio_frame_t new_frame = *data;
+    new_frame.data = out->data;
+    new_frame.size = out_num * fused->dst_ch * sizeof(int16_t);
+    resample->cfg.resample_cb(&new_frame, resample->cfg.ctx);
+    return ESP_MEDIA_ERR_OK;
+}
+
 audio_resample_handle_t audio_resample_open(audio_resample_cfg_t *cfg)
 {
     resample_t *resample = (resample_t *)media_lib_calloc(1, sizeof(resample_t));
@@ -156,6 +364,15 @@ audio_resample_handle_t audio_resample_open(audio_resample_cfg_t *cfg)
         if (resample == NULL) {
             break;
         }
+        // Use fused single pass converter for common cases to avoid chained processing
+        if (fused_cvt_supported(cfg) && memcmp(&cfg->input_info, &cfg->output_info, sizeof(av_render_audio_frame_info_t))) {
+            if (fused_cvt_open(&resample->fused, cfg) != ESP_MEDIA_ERR_OK) {
+                ESP_LOGE(TAG, "Fail to open fused converter");
+                break;
+            }
+            resample->cfg = *cfg;
+            return resample;
+        }
         sort_resample_ops(resample, cfg);
         av_render_audio_frame_info_t cur_info = cfg->input_info;
         esp_ae_err_t ret = ESP_AE_ERR_OK;
@@ -217,6 +434,9 @@ audio_resample_handle_t audio_resample_open(audio_resample_cfg_t *cfg)
 int audio_resample_write(audio_resample_handle_t h, av_render_audio_frame_t *data)
 {
     resample_t *resample = (resample_t *)h;
+    if (data->size && resample->fused.enable) {
+        return fused_cvt_write(resample, data);
+    }
     // Bypass or size is 0
     if (data->size == 0 || resample->ops[0] == RESAMPLE_OPS_NONE) {
         resample->cfg.resample_cb(data, resample->cfg.ctx);
@@ -282,6 +502,7 @@ void audio_resample_close(audio_resample_handle_t h)
         esp_ae_rate_cvt_close(resample->rate_cvt_handle);
         resample->rate_cvt_handle = NULL;
     }
+    fused_cvt_close(&resample->fused);
     for (int i = 0; i < ELEMS(resample->work_buf); i++) {
         if (resample->work_buf[i].data) {
             media_lib_free(resample->work_buf[i].data);
@@ -25,6 +25,7 @@
 #include <string.h>
 #include <inttypes.h>
 #include "media_lib_os.h"
+#include "media_lib_atomic.h"
 #include "data_queue.h"
 #include "msg_q.h"
 #include "av_render.h"
@@ -35,6 +36,12 @@
 #include "audio_resample.h"
 #include "esp_timer.h"
 #include "color_convert.h"
+#include "latency_hist.h"
+#include "video_nal.h"
+#include "audio_catchup.h"
+#include "video_fb_pool.h"
+#include "trace_ring.h"
+#include "audio_mixer.h"
 #include "esp_log.h"
 
 #define TAG "AV_RENDER"
@@ -55,6 +62,45 @@
 #define VIDEO_ERR_FRAME_TOLERANCE (5)
 #define AUDIO_ERR_FRAME_TOLERANCE (10)
 
+#define JITTER_DEFAULT_TARGET_DELAY (60)
+#define JITTER_DEFAULT_MIN_DELAY    (20)
+#define JITTER_DEFAULT_MAX_DELAY    (500)
+#define JITTER_DEFAULT_MAX_STRETCH  (0.1f)
+// Delay error (ms) tolerated before start stretching, stop stretching when error within half of it
+#define JITTER_DELAY_TOLERANCE (20)
+// Delay error (ms) which map to stretch ratio 1.0 deviation
+#define JITTER_STRETCH_GAIN (1000)
+// Gap larger than this frame number is treated as stream discontinuity and not concealed
+#define PLC_MAX_FRAMES (10)
+
+// Audio clock includes render output latency, so video only need tolerate render jitter
+#define VIDEO_SYNC_TOLERANCE (200)
+
+#define VIDEO_DEFAULT_DROP_LATE_FRAMES (2)
+#define VIDEO_DEFAULT_SKIP_LATE_FRAMES (8)
+
+#define VIDEO_DEFAULT_FB_NUM (3)
+#define VIDEO_FB_WAIT_MS     (100)
+
+#define CATCHUP_DEFAULT_TARGET_LEVEL (100)
+#define CATCHUP_DEFAULT_HYSTERESIS   (60)
+#define CATCHUP_DEFAULT_SPEED        (1.05f)
+#define CATCHUP_MAX_SPEED            (1.5f)
+
+#define TRACE_DEFAULT_RING_SIZE (64 * 1024)
+#define TRACE_DUMP_RING_SIZE    (256 * 1024)
+#define TRACE_OUT_BATCH_SIZE    (2048)
+#define TRACE_DRAIN_INTERVAL    (20)
+#define TRACE_VERSION           (1)
+
+#define AUDIO_MIX_FIFO_MS    (500)
+#define AUDIO_MIX_CHUNK_SIZE (1024)
+#define AUDIO_MIX_OUT_MS     (20)
+#define AUDIO_MIX_WAIT_MS    (100)
+
+#define COOP_STAGE_NUM    (2)
+#define COOP_IDLE_WAIT_MS (100)
+
 typedef enum {
     AV_RENDER_MSG_NONE,
     AV_RENDER_MSG_PAUSE,
@@ -69,6 +115,24 @@ typedef struct {
     uint32_t             data;
 } av_render_msg_t;
 
+/* Queued item of audio decoder, packet data follows item unless data pool used */
+typedef struct {
+    av_render_audio_data_t data;
+    uint32_t               enqueue_time; /* Enqueue time for latency statistics, 0 when statistics off */
+} av_render_adec_item_t;
+
+/* Queued item of video decoder, packet data follows item unless data pool used */
+typedef struct {
+    av_render_video_data_t data;
+    uint32_t               enqueue_time; /* Enqueue time for latency statistics, 0 when statistics off */
+} av_render_vdec_item_t;
+
+/* Queued item of video render, frame data follows item or stays in pool buffer */
+typedef struct {
+    av_render_video_frame_t frame;
+    video_fb_pool_handle_t  pool; /* Pool owning frame data, NULL when data copied after item */
+} av_render_v_render_item_t;
+
 typedef struct _render_thread_res_t {
     media_lib_thread_handle_t thread;
     msg_q_handle_t            msg_q;
@@ -92,16 +156,45 @@ typedef struct {
     av_render_thread_res_t       thread_res;
     vdec_handle_t                vdec;
     int                          video_err_cnt;
-    av_render_video_frame_t     *fb_frame;
+    video_fb_pool_handle_t       fb_pool;
     av_render_video_frame_type_t dec_out_fmt;
     av_render_video_frame_type_t out_fmt;
     color_convert_table_t       *vid_convert;
     uint8_t                     *vid_convert_out;
     int                          vid_convert_out_size;
+    av_render_video_codec_t      codec;
+    bool                         wait_key;
+    av_render_drop_stat_t        drop_stat;
 } av_render_vdec_res_t;
 
 struct _av_render;
 
+typedef struct {
+    bool     arrived;
+    int32_t  last_transit;
+    uint32_t last_arrive_pts;
+    uint32_t jitter_q4;
+    uint32_t target_delay;
+    uint32_t cur_delay;
+    float    stretch;
+    float    user_speed;
+    bool     speed_changed;
+} av_render_jitter_t;
+
+typedef struct {
+    bool     next_pts_valid;
+    uint32_t next_pts;
+    uint32_t pkt_duration;
+    uint32_t frame_duration;
+    int16_t  last_sample[2];
+    uint8_t *fade_buf;
+    int      fade_buf_size;
+    bool     concealing;
+    uint32_t gap_num;
+    uint32_t plc_frames;
+    uint32_t fade_frames;
+} av_render_plc_t;
+
 typedef struct {
     av_render_thread_res_t       thread_res;
     bool                         audio_packet_reached;
@@ -111,9 +204,20 @@ typedef struct {
     audio_resample_handle_t      resample_handle;
     bool                         need_resample;
     uint32_t                     audio_send_pts;
+    uint32_t                     audio_send_duration;
     bool                         decode_in_sync;
     bool                         audio_is_pcm;
     bool                         a_render_in_sync;
+    av_render_audio_frame_t     *fb_frame;
+    av_render_jitter_t           jitter;
+    av_render_plc_t              plc;
+    audio_catchup_t              catchup;
+    bool                         catchup_active;
+    bool                         render_opened;
+    av_render_audio_frame_info_t render_info;
+    int16_t                     *mix_buf;
+    int                          mix_buf_size;
+    int                          max_frame_size; /* Largest render buffer requested, checked by cooperative decode */
 } av_render_audio_res_t;
 
 typedef struct {
@@ -133,6 +237,34 @@ typedef struct {
     int                          sync_tolerance;
 } av_render_video_res_t;
 
+typedef struct {
+    latency_hist_t hist[AV_RENDER_STREAM_MAX][AV_RENDER_STAGE_MAX];
+    uint32_t       nested[AV_RENDER_STREAM_MAX]; /* Accumulated exclusive time of stages run inside decode */
+} av_render_stats_res_t;
+
+typedef struct {
+    uint32_t start;
+    uint32_t nested;
+} av_render_stage_clock_t;
+
+typedef struct {
+    media_lib_thread_handle_t thread;
+    media_lib_sema_handle_t   wake;
+    av_render_thread_res_t   *stage[COOP_STAGE_NUM]; /* Run order of stages, render drained before decode */
+} av_render_coop_t;
+
+typedef struct {
+    trace_ring_t             *ring;
+    av_render_trace_cfg_t     cfg;
+    FILE                     *fp;
+    media_lib_thread_handle_t thread;
+    media_lib_sema_handle_t   exit_sema;
+    bool                      running; /* Atomic, set after cfg and delta base filled */
+    int                       users;   /* Atomic, producers inside trace_data, trace state kept until it drops to 0 */
+    uint32_t                  last_pts[AV_RENDER_TRACE_MAX];
+    uint32_t                  last_time[AV_RENDER_TRACE_MAX];
+} av_render_trace_t;
+
 typedef struct _av_render {
     av_render_cfg_t cfg;
 
@@ -148,16 +280,13 @@ typedef struct _av_render {
     void                        *event_ctx;
     av_render_pool_data_free     pool_free;
     void                        *pool;
+    av_render_stats_res_t       *stats;
+    av_render_coop_t            *coop;
+    av_render_trace_t           *trace;
+    audio_mixer_t               *mixer;
+    int                          mix_waiters;
 } av_render_t;
 
-typedef enum {
-    AV_RENDER_DUMP_ADEC_DATA,
-    AV_RENDER_DUMP_ARENDER_DATA,
-    AV_RENDER_DUMP_VDEC_DATA,
-    AV_RENDER_DUMP_VRENDER_DATA,
-    AV_RENDER_DUMP_STOP_INDEX,
-} av_render_dump_type_t;
-
 #define BREAK_ON_FAIL(ret) if (ret != 0) {   \
     break;                                   \
 }
@@ -169,7 +298,6 @@ typedef enum {
     return ret;                                       \
 }
 
-static uint8_t render_dump_mask;
 
 static int av_render_get_audio_pts(av_render_t *render, uint32_t *out_pts);
 
@@ -177,47 +305,214 @@ static int av_render_get_video_pts(av_render_t *render, uint32_t *out_pts);
 
 static void render_thread(void *arg);
 
+static int av_render_audio_frame_reached(av_render_audio_frame_t *frame, void *ctx);
+
+static void audio_conceal_gap(av_render_t *render, uint32_t pts);
+
+static void audio_plc_pkt_done(av_render_audio_res_t *a_render, uint32_t pts);
+
+static uint8_t *get_a_render_buffer(av_render_t *render, int size);
+
+static void coop_wakeup(av_render_t *render);
+
 static uint32_t get_cur_time()
 {
     return esp_timer_get_time() / 1000;
 }
 
-static int put_to_adec(data_queue_t *q, av_render_audio_data_t *data, bool use_pool)
+static inline uint32_t stats_now(void)
+{
+    return (uint32_t)esp_timer_get_time();
+}
+
+static inline void stats_stage_begin(av_render_t *render, av_render_stream_t stream, av_render_stage_clock_t *clk)
+{
+    // Always initialize so that compiler can not see clock used uninitialized in stats_stage_end
+    clk->start = 0;
+    clk->nested = 0;
+    if (render->stats) {
+        clk->start = stats_now();
+        clk->nested = render->stats->nested[stream];
+    }
+}
+
+// Record stage time excluding nested stages, `in_decode` means stage run inside decode call chain
+static inline void stats_stage_end(av_render_t *render, av_render_stream_t stream, av_render_stage_t stage,
+                                   av_render_stage_clock_t *clk, bool in_decode)
+{
+    if (render->stats) {
+        av_render_stats_res_t *stats = render->stats;
+        uint32_t elapse = stats_now() - clk->start;
+        uint32_t inner = stats->nested[stream] - clk->nested;
+        elapse = elapse > inner ? elapse - inner : 0;
+        latency_hist_add(&stats->hist[stream][stage], elapse);
+        if (in_decode) {
+            stats->nested[stream] += elapse;
+        }
+    }
+}
+
+static inline void stats_queue_leave(av_render_t *render, av_render_stream_t stream, uint32_t enqueue_time)
+{
+    if (render->stats) {
+        latency_hist_add(&render->stats->hist[stream][AV_RENDER_STAGE_QUEUE], stats_now() - enqueue_time);
+    }
+}
+
+// Get time to wait for decoder fifo, return false if deadline already passed
+static bool get_enqueue_timeout(uint32_t deadline, uint32_t *timeout)
+{
+    *timeout = MEDIA_LIB_MAX_LOCK_TIME;
+    if (deadline == 0) {
+        return true;
+    }
+    int32_t left = (int32_t)(deadline - get_cur_time());
+    if (left <= 0) {
+        return false;
+    }
+    *timeout = (uint32_t)left;
+    return true;
+}
+
+static void jitter_reset(av_render_jitter_t *jitter)
+{
+    jitter->arrived = false;
+    jitter->jitter_q4 = 0;
+    jitter->cur_delay = 0;
+    jitter->target_delay = 0;
+    jitter->stretch = 1.0f;
+    jitter->speed_changed = true;
+}
+
+static void jitter_on_arrive(av_render_t *render, av_render_jitter_t *jitter, uint32_t pts)
+{
+    av_render_jitter_cfg_t *cfg = &render->cfg.audio_jitter;
+    int32_t transit = (int32_t)(get_cur_time() - pts);
+    if (jitter->arrived) {
+        int32_t d = transit - jitter->last_transit;
+        if (d < 0) {
+            d = -d;
+        }
+        // Interarrival jitter estimator same as RFC3550: J += (|D| - J) / 16, kept in Q4
+        jitter->jitter_q4 += d - ((jitter->jitter_q4 + 8) >> 4);
+    }
+    jitter->arrived = true;
+    jitter->last_transit = transit;
+    jitter->last_arrive_pts = pts;
+    // Keep enough delay to absorb about 3 times of measured jitter
+    uint32_t target = cfg->target_delay ? cfg->target_delay : JITTER_DEFAULT_TARGET_DELAY;
+    uint32_t need_delay = 3 * (jitter->jitter_q4 >> 4);
+    if (need_delay > target) {
+        target = need_delay;
+    }
+    uint32_t min_delay = cfg->min_delay ? cfg->min_delay : JITTER_DEFAULT_MIN_DELAY;
+    uint32_t max_delay = cfg->max_delay ? cfg->max_delay : JITTER_DEFAULT_MAX_DELAY;
+    if (target < min_delay) {
+        target = min_delay;
+    }
+    if (target > max_delay) {
+        target = max_delay;
+    }
+    jitter->target_delay = target;
+}
+
+static void jitter_adjust_speed(av_render_t *render, av_render_jitter_t *jitter, uint32_t render_pts)
+{
+    if (jitter->arrived == false) {
+        return;
+    }
+    int32_t delay = (int32_t)(jitter->last_arrive_pts - render_pts);
+    if (delay < 0) {
+        delay = 0;
+    }
+    jitter->cur_delay = (uint32_t)delay;
+    int32_t err = delay - (int32_t)jitter->target_delay;
+    int32_t abs_err = err < 0 ? -err : err;
+    float stretch = jitter->stretch;
+    if (abs_err < JITTER_DELAY_TOLERANCE / 2) {
+        stretch = 1.0f;
+    } else if (abs_err > JITTER_DELAY_TOLERANCE || stretch != 1.0f) {
+        // Speed up when too much data buffered, slow down when near to underflow
+        float max_stretch = render->cfg.audio_jitter.max_stretch;
+        if (max_stretch <= 0.0f) {
+            max_stretch = JITTER_DEFAULT_MAX_STRETCH;
+        }
+        float dev = (float)err / JITTER_STRETCH_GAIN;
+        if (dev > max_stretch) {
+            dev = max_stretch;
+        } else if (dev < -max_stretch) {
+            dev = -max_stretch;
+        }
+        // Quantize to 1% step to avoid too frequent speed change
+        stretch = 1.0f + (int)(dev * 100.0f) / 100.0f;
+    }
+    if (stretch != jitter->stretch || jitter->speed_changed) {
+        jitter->stretch = stretch;
+        jitter->speed_changed = false;
+        audio_render_set_speed(render->cfg.audio_render, stretch * jitter->user_speed);
+    }
+}
+
+static int put_to_adec(data_queue_t *q, av_render_audio_data_t *data, bool use_pool, bool stamp)
 {
-    int head_size = sizeof(av_render_audio_data_t);
+    int head_size = sizeof(av_render_adec_item_t);
     int size = head_size + (use_pool ? 0 : data->size);
-    uint8_t *b = (uint8_t *)data_queue_get_buffer(q, size);
+    uint8_t *b = NULL;
+    uint32_t timeout;
+    if (get_enqueue_timeout(data->deadline, &timeout) == false) {
+        ESP_LOGD(TAG, "Drop late audio pts %d", (int)data->pts);
+        return ESP_MEDIA_ERR_TIMEOUT;
+    }
+    int ret = data_queue_get_buffer_timeout(q, size, (void **)&b, timeout);
+    if (ret == ESP_MEDIA_ERR_TIMEOUT) {
+        ESP_LOGD(TAG, "Drop audio pts %d for fifo full until deadline", (int)data->pts);
+        return ret;
+    }
     if (b == NULL) {
         ESP_LOGE(TAG, "Drop for no enough %d", size);
         return -1;
     }
-    memcpy(b, data, head_size);
+    av_render_adec_item_t *item = (av_render_adec_item_t *)b;
+    item->data = *data;
+    item->enqueue_time = stamp ? stats_now() : 0;
     if (use_pool == false && data->size) {
         memcpy(b + head_size, data->data, data->size);
     }
     return data_queue_send_buffer(q, size);
 }
 
-static int put_to_vdec(data_queue_t *q, av_render_video_data_t *data, bool use_pool)
+static int put_to_vdec(data_queue_t *q, av_render_video_data_t *data, bool use_pool, bool stamp)
 {
-    int head_size = sizeof(av_render_video_data_t);
+    int head_size = sizeof(av_render_vdec_item_t);
     int size = head_size + (use_pool ? 0 : data->size);
-    uint8_t *b = (uint8_t *)data_queue_get_buffer(q, size);
+    uint8_t *b = NULL;
+    uint32_t timeout;
+    if (get_enqueue_timeout(data->deadline, &timeout) == false) {
+        ESP_LOGD(TAG, "Drop late video pts %d", (int)data->pts);
+        return ESP_MEDIA_ERR_TIMEOUT;
+    }
+    int ret = data_queue_get_buffer_timeout(q, size, (void **)&b, timeout);
+    if (ret == ESP_MEDIA_ERR_TIMEOUT) {
+        ESP_LOGD(TAG, "Drop video pts %d for fifo full until deadline", (int)data->pts);
+        return ret;
+    }
     if (b == NULL) {
         return -1;
     }
-    memcpy(b, data, head_size);
+    av_render_vdec_item_t *item = (av_render_vdec_item_t *)b;
+    item->data = *data;
+    item->enqueue_time = stamp ? stats_now() : 0;
     if (use_pool == false && data->size) {
         memcpy(b + head_size, data->data, data->size);
     }
     return data_queue_send_buffer(q, size);
 }
 
-static int put_to_a_render(data_queue_t *q, av_render_audio_frame_t *data)
+static int put_to_a_render(av_render_t *render, data_queue_t *q, av_render_audio_frame_t *data)
 {
     int head_size = sizeof(av_render_audio_frame_t);
     int size = head_size + data->size;
-    uint8_t *b = (uint8_t *)data_queue_get_buffer(q, size);
+    uint8_t *b = get_a_render_buffer(render, size);
     if (b == NULL) {
         return -1;
     }
@@ -225,61 +520,80 @@ static int put_to_a_render(data_queue_t *q, av_render_audio_frame_t *data)
     if (data->size) {
         memcpy(b + head_size, data->data, data->size);
     }
-    return data_queue_send_buffer(q, size);
+    int ret = data_queue_send_buffer(q, size);
+    coop_wakeup(render);
+    return ret;
 }
 
 static int put_to_v_render(data_queue_t *q, av_render_video_frame_t *data)
 {
-    int head_size = sizeof(av_render_video_frame_t);
+    int head_size = sizeof(av_render_v_render_item_t);
     int size = head_size + data->size;
     uint8_t *b = (uint8_t *)data_queue_get_buffer(q, size);
     if (b == NULL) {
         return -1;
     }
-    memcpy(b, data, head_size);
+    av_render_v_render_item_t *item = (av_render_v_render_item_t *)b;
+    item->frame = *data;
+    item->pool = NULL;
     if (data->size) {
         memcpy(b + head_size, data->data, data->size);
     }
     return data_queue_send_buffer(q, size);
 }
 
-static int read_for_adec(data_queue_t *q, av_render_audio_data_t *data, bool use_pool)
+// Only queue frame header and pool it belongs, frame data stay in pool buffer
+static int put_fb_to_v_render(data_queue_t *q, av_render_video_frame_t *data, video_fb_pool_handle_t pool)
+{
+    av_render_v_render_item_t *item = (av_render_v_render_item_t *)data_queue_get_buffer(q, sizeof(av_render_v_render_item_t));
+    if (item == NULL) {
+        return -1;
+    }
+    video_fb_pool_ref(pool, data->data);
+    item->frame = *data;
+    item->pool = pool;
+    return data_queue_send_buffer(q, sizeof(av_render_v_render_item_t));
+}
+
+static int read_for_adec(data_queue_t *q, av_render_audio_data_t *data, bool use_pool, uint32_t *enqueue_time)
 {
     uint8_t *b;
     int size;
     int ret = data_queue_read_lock(q, (void **)&b, &size);
     RETURN_ON_FAIL(ret);
-    av_render_audio_data_t *r = (av_render_audio_data_t *)b;
+    av_render_adec_item_t *item = (av_render_adec_item_t *)b;
+    *enqueue_time = item->enqueue_time;
     if (use_pool) {
-        *data = *r;
+        *data = item->data;
         return ret;
     }
-    int head_size = sizeof(av_render_audio_data_t);
-    if (r->size + head_size != size) {
+    int head_size = sizeof(av_render_adec_item_t);
+    if (item->data.size + head_size != size) {
         ret = -1;
     } else {
-        *data = *r;
+        *data = item->data;
         data->data = b + head_size;
     }
     return ret;
 }
 
-static int read_for_vdec(data_queue_t *q, av_render_video_data_t *data, bool use_pool)
+static int read_for_vdec(data_queue_t *q, av_render_video_data_t *data, bool use_pool, uint32_t *enqueue_time)
 {
     uint8_t *b;
     int size;
     int ret = data_queue_read_lock(q, (void **)&b, &size);
     RETURN_ON_FAIL(ret);
-    av_render_video_data_t *r = (av_render_video_data_t *)b;
+    av_render_vdec_item_t *item = (av_render_vdec_item_t *)b;
+    *enqueue_time = item->enqueue_time;
     if (use_pool) {
-        *data = *r;
+        *data = item->data;
         return ret;
     }
-    int head_size = sizeof(av_render_video_data_t);
-    if (r->size + head_size != size) {
+    int head_size = sizeof(av_render_vdec_item_t);
+    if (item->data.size + head_size != size) {
         ret = -1;
     } else {
-        *data = *r;
+        *data = item->data;
         data->data = b + head_size;
     }
     return ret;
@@ -303,70 +617,232 @@ static int read_for_a_render(data_queue_t *q, av_render_audio_frame_t *data)
     return ret;
 }
 
-static int read_for_v_render(data_queue_t *q, av_render_video_frame_t *data)
+static int read_for_v_render(data_queue_t *q, av_render_video_frame_t *data, video_fb_pool_handle_t *pool)
 {
     uint8_t *b;
     int size;
     int ret = data_queue_read_lock(q, (void **)&b, &size);
     RETURN_ON_FAIL(ret);
-    av_render_video_frame_t *r = (av_render_video_frame_t *)b;
-    if (r->data > b && r->data + r->size == b + size) {
-        *data = *r;
+    av_render_v_render_item_t *item = (av_render_v_render_item_t *)b;
+    int head_size = sizeof(av_render_v_render_item_t);
+    *pool = item->pool;
+    if (item->pool) {
+        *data = item->frame;
         return ret;
     }
-    int head_size = sizeof(av_render_video_frame_t);
-    if (r->size + head_size != size) {
+    if (item->frame.size + head_size != size) {
         ret = -1;
     } else {
-        *data = *r;
+        *data = item->frame;
         data->data = b + head_size;
     }
     return ret;
 }
 
-static void dump_data(av_render_dump_type_t type, uint8_t *data, int size)
+static int trace_put_varint(uint8_t *b, uint32_t v)
 {
-    static FILE *fp[AV_RENDER_DUMP_STOP_INDEX];
-    static uint8_t dump_count = 0;
-    if (type == AV_RENDER_DUMP_STOP_INDEX) {
-        for (int i = 0; i < AV_RENDER_DUMP_STOP_INDEX; i++) {
-            if (fp[i]) {
-                fclose(fp[i]);
-                fp[i] = NULL;
+    int n = 0;
+    while (v >= 0x80) {
+        b[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    b[n++] = (uint8_t)v;
+    return n;
+}
+
+static void trace_record(av_render_trace_t *trace, av_render_trace_type_t type, uint32_t pts, uint8_t *data, int size)
+{
+    uint8_t head[16];
+    int n = 0;
+    head[n++] = (uint8_t)type;
+    int32_t pts_delta = (int32_t)(pts - trace->last_pts[type]);
+    n += trace_put_varint(head + n, (uint32_t)((pts_delta << 1) ^ (pts_delta >> 31)));
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    n += trace_put_varint(head + n, now - trace->last_time[type]);
+    n += trace_put_varint(head + n, (uint32_t)size);
+    int payload = size;
+    if (payload > (int)trace->cfg.max_payload) {
+        payload = trace->cfg.max_payload;
+    }
+    if (payload > trace_ring_max_record(trace->ring) - n) {
+        payload = trace_ring_max_record(trace->ring) - n;
+    }
+    // Each type written by only one thread, delta base kept consistent by updating after written
+    if (trace_ring_write(trace->ring, head, n, data, payload) == 0) {
+        trace->last_pts[type] = pts;
+        trace->last_time[type] = now;
+    }
+}
+
+// Called from media threads, only encode record and append to ring, never block
+static void trace_data(av_render_t *render, av_render_trace_type_t type, uint32_t pts, uint8_t *data, int size)
+{
+    av_render_trace_t *trace = MEDIA_LIB_ATOMIC_LOAD_ACQ(render->trace);
+    if (trace == NULL || MEDIA_LIB_ATOMIC_LOAD_ACQ(trace->running) == false) {
+        return;
+    }
+    // Register as user then check again, pairs with trace_stop which clears running then waits users
+    MEDIA_LIB_ATOMIC_ADD_SC(trace->users, 1);
+    if (MEDIA_LIB_ATOMIC_LOAD_SC(trace->running) && (trace->cfg.mask & (1 << type))) {
+        trace_record(trace, type, pts, data, size);
+    }
+    MEDIA_LIB_ATOMIC_SUB_ACQ_REL(trace->users, 1);
+}
+
+static int trace_output(av_render_trace_t *trace, uint8_t *data, int size)
+{
+    if (size == 0) {
+        return 0;
+    }
+    if (trace->cfg.write) {
+        return trace->cfg.write(data, size, trace->cfg.ctx);
+    }
+    if (trace->fp && fwrite(data, size, 1, trace->fp) != 1) {
+        return -1;
+    }
+    return 0;
+}
+
+static void trace_thread(void *arg)
+{
+    av_render_trace_t *trace = (av_render_trace_t *)arg;
+    int max_record = trace_ring_max_record(trace->ring);
+    // Batch small records to reduce output calls, buffer always fit one record with its length
+    int out_size = TRACE_OUT_BATCH_SIZE + max_record + 8;
+    uint8_t *out = (uint8_t *)media_lib_malloc(out_size);
+    bool output_ok = (out != NULL);
+    int filled = 0;
+    while (out) {
+        int size = trace_ring_read(trace->ring, out + filled + 5, max_record);
+        if (size > 0) {
+            // Move record just after its varint length
+            int n = trace_put_varint(out + filled, (uint32_t)size);
+            memmove(out + filled + n, out + filled + 5, size);
+            filled += n + size;
+            if (filled < TRACE_OUT_BATCH_SIZE) {
+                continue;
             }
         }
-        dump_count++;
-        if (dump_count > 9) {
-            dump_count = 0;
+        if (output_ok && trace_output(trace, out, filled) != 0) {
+            ESP_LOGE(TAG, "Fail to output trace, stop capture");
+            output_ok = false;
+            MEDIA_LIB_ATOMIC_STORE_SC(trace->running, false);
         }
-        return;
+        filled = 0;
+        if (size > 0) {
+            continue;
+        }
+        // Quit only after ring drained
+        if (MEDIA_LIB_ATOMIC_LOAD_ACQ(trace->running) == false) {
+            break;
+        }
+        media_lib_thread_sleep(TRACE_DRAIN_INTERVAL);
     }
-    if ((render_dump_mask & (1 << type)) == 0) {
-        return;
+    if (out) {
+        media_lib_free(out);
     }
-    if (size == 0) {
+    ESP_LOGI(TAG, "Trace stopped dropped %" PRIu32, trace_ring_get_dropped(trace->ring));
+    if (trace->fp) {
+        fclose(trace->fp);
+        trace->fp = NULL;
+    }
+    media_lib_sema_unlock(trace->exit_sema);
+    media_lib_thread_destroy(NULL);
+}
+
+static void trace_stop(av_render_t *render)
+{
+    av_render_trace_t *trace = render->trace;
+    if (trace == NULL || trace->thread == NULL) {
         return;
     }
-    if (fp[type] == NULL) {
-        char *pre_name[] = { "ad", "ar", "vd", "vr" };
-        char file_name[20];
-        snprintf(file_name, sizeof(file_name), "/sdcard/%s%d.bin", pre_name[type], dump_count);
-        fp[type] = fopen(file_name, "wb");
-        if (fp[type]) {
-            ESP_LOGI(TAG, "dump to %s", file_name);
+    MEDIA_LIB_ATOMIC_STORE_SC(trace->running, false);
+    media_lib_sema_lock(trace->exit_sema, MEDIA_LIB_MAX_LOCK_TIME);
+    trace->thread = NULL;
+    // Producer already passed running check may still read cfg and delta base, wait before they are rewritten
+    while (MEDIA_LIB_ATOMIC_LOAD_SC(trace->users)) {
+        media_lib_thread_sleep(1);
+    }
+}
+
+static int trace_start(av_render_t *render, av_render_trace_cfg_t *cfg)
+{
+    trace_stop(render);
+    av_render_trace_t *trace = render->trace;
+    if (trace == NULL) {
+        trace = (av_render_trace_t *)media_lib_calloc(1, sizeof(av_render_trace_t));
+        if (trace == NULL) {
+            return ESP_MEDIA_ERR_NO_MEM;
         }
+        MEDIA_LIB_ATOMIC_STORE_REL(render->trace, trace);
     }
-    if (fp[type]) {
-        fwrite(data, size, 1, fp[type]);
+    if (trace->exit_sema == NULL) {
+        media_lib_sema_create(&trace->exit_sema);
+        if (trace->exit_sema == NULL) {
+            return ESP_MEDIA_ERR_NO_MEM;
+        }
+    }
+    // Media threads may still access ring, allocate once and keep until render closed
+    if (trace->ring == NULL) {
+        trace->ring = trace_ring_create(cfg->ring_size ? cfg->ring_size : TRACE_DEFAULT_RING_SIZE);
+        if (trace->ring == NULL) {
+            return ESP_MEDIA_ERR_NO_MEM;
+        }
+    }
+    trace->cfg = *cfg;
+    trace->cfg.file_path = NULL;
+    if (cfg->write == NULL) {
+        if (cfg->file_path == NULL || (trace->fp = fopen(cfg->file_path, "wb")) == NULL) {
+            ESP_LOGE(TAG, "Fail to open trace file %s", cfg->file_path ? cfg->file_path : "");
+            return ESP_MEDIA_ERR_FAIL;
+        }
+    }
+    uint8_t magic[] = { 'A', 'V', 'T', 'R', TRACE_VERSION };
+    if (trace_output(trace, magic, sizeof(magic)) != 0) {
+        if (trace->fp) {
+            fclose(trace->fp);
+            trace->fp = NULL;
+        }
+        return ESP_MEDIA_ERR_FAIL;
+    }
+    memset(trace->last_pts, 0, sizeof(trace->last_pts));
+    memset(trace->last_time, 0, sizeof(trace->last_time));
+    // Publish after cfg and delta base filled so that producers see them consistent
+    MEDIA_LIB_ATOMIC_STORE_REL(trace->running, true);
+    int ret = media_lib_thread_create_from_scheduler(&trace->thread, "AVTrace", trace_thread, trace);
+    if (ret != 0) {
+        MEDIA_LIB_ATOMIC_STORE_SC(trace->running, false);
+        while (MEDIA_LIB_ATOMIC_LOAD_SC(trace->users)) {
+            media_lib_thread_sleep(1);
+        }
+        trace->thread = NULL;
+        if (trace->fp) {
+            fclose(trace->fp);
+            trace->fp = NULL;
+        }
+        ESP_LOGE(TAG, "Fail to create trace thread");
+        return ESP_MEDIA_ERR_FAIL;
     }
+    ESP_LOGI(TAG, "Trace started mask %x", cfg->mask);
+    return ESP_MEDIA_ERR_OK;
 }
 
 static int decode_audio(av_render_adec_res_t *adec_res, av_render_audio_data_t *data)
 {
     int ret = 0;
     if (data->size || data->eos) {
-        dump_data(AV_RENDER_DUMP_ADEC_DATA, data->data, data->size);
+        av_render_t *render = adec_res->thread_res.render;
+        trace_data(render, AV_RENDER_TRACE_ADEC, data->pts, data->data, data->size);
+        if (data->size) {
+            audio_conceal_gap(render, data->pts);
+        }
+        av_render_stage_clock_t clk;
+        stats_stage_begin(render, AV_RENDER_STREAM_AUDIO, &clk);
         ret = adec_decode(adec_res->adec, data);
+        stats_stage_end(render, AV_RENDER_STREAM_AUDIO, AV_RENDER_STAGE_DECODE, &clk, false);
+        if (ret == 0 && data->size) {
+            audio_plc_pkt_done(render->a_render_res, data->pts);
+        }
         if (ret != 0) {
             av_render_t *render = adec_res->thread_res.render;
             adec_res->audio_err_cnt++;
@@ -388,8 +864,10 @@ static int adec_body(av_render_thread_res_t *res, bool drop)
 {
     av_render_audio_data_t data;
     av_render_adec_res_t *adec_res = (av_render_adec_res_t *)res;
-    int ret = read_for_adec(res->data_q, &data, res->use_pool);
+    uint32_t enqueue_time = 0;
+    int ret = read_for_adec(res->data_q, &data, res->use_pool, &enqueue_time);
     RETURN_ON_FAIL(ret);
+    stats_queue_leave(res->render, AV_RENDER_STREAM_AUDIO, enqueue_time);
     // EOS data may not contain size
     if (drop == false) {
         ret = decode_audio(adec_res, &data);
@@ -422,29 +900,81 @@ static int get_video_sync_time(av_render_t *render, av_render_video_res_t *v_ren
     return ret;
 }
 
-static int video_sync_control_before_decode(av_render_t *render, uint32_t video_pts, int q_num, bool *skip)
+static av_render_drop_action_t video_default_drop_policy(av_render_drop_info_t *info, void *ctx)
+{
+    av_render_drop_cfg_t *cfg = (av_render_drop_cfg_t *)ctx;
+    // Key frame referenced by following frames is needed to recover decoding, never drop it
+    // Intra-only frame (MJPEG) has no dependency, drop it like other non-reference frames
+    if (info->key_frame && info->reference) {
+        return AV_RENDER_DROP_NONE;
+    }
+    int frame_duration = 1000 / info->fps;
+    int drop_late = cfg->drop_late_frames ? cfg->drop_late_frames : VIDEO_DEFAULT_DROP_LATE_FRAMES;
+    int skip_late = cfg->skip_late_frames ? cfg->skip_late_frames : VIDEO_DEFAULT_SKIP_LATE_FRAMES;
+    if (info->late >= skip_late * frame_duration && info->key_frame == false) {
+        return AV_RENDER_DROP_TO_KEY;
+    }
+    // Drop reference frame will corrupt picture until next key frame, only drop non-reference one
+    if (info->late >= drop_late * frame_duration && info->reference == false) {
+        return AV_RENDER_DROP_FRAME;
+    }
+    return AV_RENDER_DROP_NONE;
+}
+
+static int video_drop_before_decode(av_render_t *render, av_render_video_data_t *data, int q_num, bool *skip)
 {
     av_render_video_res_t *v_render = render->v_render_res;
-    if (render->cfg.allow_drop_data == false) {
+    av_render_vdec_res_t *vdec_res = render->vdec_res;
+    if (render->cfg.allow_drop_data == false || data->size == 0) {
         return 0;
     }
-    // No need sync, return directly
-    if (render->cfg.sync_mode == AV_RENDER_SYNC_NONE) {
-        if (q_num >= 2) {
+    video_nal_info_t nal_info;
+    video_nal_parse(vdec_res->codec, data->data, data->size, &nal_info);
+    if (data->key_frame && nal_info.key_frame == false) {
+        // Key frame flagged by caller but not detected by parser, keep it as referenced
+        nal_info.key_frame = true;
+        nal_info.reference = true;
+    }
+    if (vdec_res->wait_key) {
+        if (nal_info.key_frame == false) {
+            vdec_res->drop_stat.skipped++;
             *skip = true;
+            return 0;
         }
-        return 0;
+        vdec_res->wait_key = false;
     }
-    uint32_t now, ref_time;
-    int ret = get_video_sync_time(render, v_render, &now, &ref_time);
-    RETURN_ON_FAIL(ret);
-    if (v_render->sent_frame_num) {
+    int fps = v_render->video_frame_info.fps;
+    if (fps == 0) {
+        fps = 20;
+    }
+    av_render_drop_info_t info = {
+        .pts = data->pts,
+        .q_num = q_num,
+        .fps = fps,
+        .key_frame = nal_info.key_frame,
+        .reference = nal_info.reference,
+    };
+    if (render->cfg.sync_mode == AV_RENDER_SYNC_NONE) {
+        info.late = q_num * 1000 / fps;
+    } else if (v_render->sent_frame_num) {
         // Do not skip data until first frame decoded
-        // TODO currently set 100 as tolerance
-        if (video_pts + 100 < now) {
-            printf("D %d < %d\n", (int)video_pts, (int)now);
-            *skip = true;
-        }
+        uint32_t now, ref_time;
+        int ret = get_video_sync_time(render, v_render, &now, &ref_time);
+        RETURN_ON_FAIL(ret);
+        info.late = (int32_t)(now - data->pts);
+    }
+    av_render_drop_cfg_t *drop_cfg = &render->cfg.video_drop;
+    av_render_drop_action_t action = drop_cfg->policy ? drop_cfg->policy(&info, drop_cfg->policy_ctx) :
+                                                        video_default_drop_policy(&info, drop_cfg);
+    if (action == AV_RENDER_DROP_FRAME) {
+        vdec_res->drop_stat.dropped++;
+        *skip = true;
+    } else if (action == AV_RENDER_DROP_TO_KEY) {
+        ESP_LOGD(TAG, "Video late %d ms skip to next key frame", (int)info.late);
+        vdec_res->drop_stat.skip_to_key++;
+        vdec_res->drop_stat.skipped++;
+        vdec_res->wait_key = true;
+        *skip = true;
     }
     return 0;
 }
@@ -479,8 +1009,11 @@ static int decode_video(av_render_vdec_res_t *vdec_res, av_render_video_data_t *
     }
     int ret = 0;
     if (data->size || data->eos) {
-        dump_data(AV_RENDER_DUMP_VDEC_DATA, data->data, data->size);
+        trace_data(render, AV_RENDER_TRACE_VDEC, data->pts, data->data, data->size);
+        av_render_stage_clock_t clk;
+        stats_stage_begin(render, AV_RENDER_STREAM_VIDEO, &clk);
         int ret = vdec_decode(vdec_res->vdec, data);
+        stats_stage_end(render, AV_RENDER_STREAM_VIDEO, AV_RENDER_STAGE_DECODE, &clk, false);
         if (ret != 0) {
             vdec_res->video_err_cnt++;
             if (vdec_res->video_err_cnt == AUDIO_ERR_FRAME_TOLERANCE) {
@@ -501,15 +1034,18 @@ static int vdec_body(av_render_thread_res_t *res, bool drop)
 {
     av_render_video_data_t data;
     av_render_vdec_res_t *vdec_res = (av_render_vdec_res_t *)res;
-    int ret = read_for_vdec(res->data_q, &data, vdec_res->thread_res.render->pool_free != NULL);
+    uint32_t enqueue_time = 0;
+    int ret = read_for_vdec(res->data_q, &data, vdec_res->thread_res.render->pool_free != NULL, &enqueue_time);
     RETURN_ON_FAIL(ret);
+    stats_queue_leave(res->render, AV_RENDER_STREAM_VIDEO, enqueue_time);
     int q_num = 0, q_size = 0;
     data_queue_query(res->data_q, &q_num, &q_size);
     // EOS data may not contain size
     if (data.size || data.eos) {
         bool skip = false;
-        video_sync_control_before_decode(res->render, data.pts, q_num, &skip);
+        video_drop_before_decode(res->render, &data, q_num, &skip);
         if (drop == false && (skip == false || data.eos)) {
+            vdec_res->drop_stat.decoded++;
             decode_video(vdec_res, &data);
         }
     }
@@ -593,6 +1129,123 @@ static int video_sync_control_before_render(av_render_t *render, uint32_t video_
     return 0;
 }
 
+static av_render_audio_frame_info_t *get_audio_render_info(av_render_audio_res_t *a_render)
+{
+    return a_render->resample_handle ? &a_render->out_frame_info : &a_render->audio_frame_info;
+}
+
+static int catchup_get_level(av_render_audio_res_t *a_render, av_render_audio_frame_info_t *info)
+{
+    int q_num = 0, q_size = 0;
+    if (a_render->thread_res.data_q == NULL) {
+        return 0;
+    }
+    data_queue_query(a_render->thread_res.data_q, &q_num, &q_size);
+    int sample_size = info->channel * info->bits_per_sample >> 3;
+    if (sample_size == 0 || info->sample_rate == 0) {
+        return 0;
+    }
+    // Queued size also counts frame headers, it is small compared to PCM payload
+    return (int)((uint64_t)q_size * 1000 / sample_size / info->sample_rate);
+}
+
+static void catchup_adjust(av_render_t *render, av_render_audio_frame_t *audio_frame)
+{
+    av_render_audio_res_t *a_render = render->a_render_res;
+    av_render_catchup_cfg_t *cfg = &render->cfg.audio_catchup;
+    av_render_audio_frame_info_t *info = get_audio_render_info(a_render);
+    if (info->bits_per_sample != 16 || audio_frame->size == 0) {
+        return;
+    }
+    audio_catchup_t *catchup = &a_render->catchup;
+    if (catchup->sample_rate != info->sample_rate || catchup->channel != info->channel) {
+        audio_catchup_reset(catchup, info->sample_rate, info->channel);
+        a_render->catchup_active = false;
+    }
+    int target = cfg->target_level ? cfg->target_level : CATCHUP_DEFAULT_TARGET_LEVEL;
+    int hysteresis = cfg->hysteresis ? cfg->hysteresis : CATCHUP_DEFAULT_HYSTERESIS;
+    int level = catchup_get_level(a_render, info);
+    if (a_render->catchup_active == false && level > target + hysteresis) {
+        ESP_LOGI(TAG, "Audio catch-up start level %dms", level);
+        a_render->catchup_active = true;
+    } else if (a_render->catchup_active && level <= target) {
+        ESP_LOGI(TAG, "Audio catch-up stop level %dms trimmed %" PRIu32, level, catchup->trimmed);
+        a_render->catchup_active = false;
+    }
+    float speed = 1.0f;
+    if (a_render->catchup_active) {
+        speed = cfg->speed > 1.0f ? cfg->speed : CATCHUP_DEFAULT_SPEED;
+        if (speed > CATCHUP_MAX_SPEED) {
+            speed = CATCHUP_MAX_SPEED;
+        }
+    }
+    int sample_size = info->channel * sizeof(int16_t);
+    int16_t *out = NULL;
+    int samples = audio_catchup_process(catchup, speed, (int16_t *)audio_frame->data, audio_frame->size / sample_size, &out);
+    audio_frame->data = (uint8_t *)out;
+    audio_frame->size = samples * sample_size;
+}
+
+static int16_t *get_mix_buffer(av_render_audio_res_t *a_render, int size)
+{
+    if (a_render->mix_buf_size < size) {
+        int16_t *buf = (int16_t *)media_lib_realloc(a_render->mix_buf, size);
+        if (buf == NULL) {
+            return NULL;
+        }
+        a_render->mix_buf = buf;
+        a_render->mix_buf_size = size;
+    }
+    return a_render->mix_buf;
+}
+
+// Mix pending extra streams into main frame, output to private buffer as frame data may be owned by decoder
+static void audio_mix_frame(av_render_t *render, av_render_audio_frame_t *frame)
+{
+    av_render_audio_res_t *a_render = render->a_render_res;
+    av_render_audio_frame_info_t *info = get_audio_render_info(a_render);
+    if (frame->size == 0 || memcmp(info, &render->aud_fix_info, sizeof(av_render_audio_frame_info_t)) ||
+        audio_mixer_need_mix(render->mixer) == false) {
+        return;
+    }
+    int16_t *out = get_mix_buffer(a_render, frame->size);
+    if (out == NULL) {
+        return;
+    }
+    audio_mixer_process(render->mixer, (int16_t *)frame->data, out, frame->size / (info->channel * sizeof(int16_t)));
+    frame->data = (uint8_t *)out;
+}
+
+static bool audio_mix_pending(av_render_t *render)
+{
+    return render->mixer && render->a_render_res && render->a_render_res->render_opened &&
+           audio_mixer_get_pending(render->mixer, 0) > 0;
+}
+
+// Play extra streams alone when main stream has no data, keep main timeline untouched
+static int audio_mix_output(av_render_t *render)
+{
+    av_render_audio_res_t *a_render = render->a_render_res;
+    av_render_audio_frame_info_t *info = &render->aud_fix_info;
+    int samples = info->sample_rate * AUDIO_MIX_OUT_MS / 1000;
+    int pending = audio_mixer_get_pending(render->mixer, 0);
+    if (pending < samples) {
+        samples = pending;
+    }
+    int size = samples * info->channel * sizeof(int16_t);
+    int16_t *out = get_mix_buffer(a_render, size);
+    if (out == NULL) {
+        return ESP_MEDIA_ERR_NO_MEM;
+    }
+    audio_mixer_process(render->mixer, NULL, out, samples);
+    av_render_audio_frame_t frame = {
+        .pts = a_render->audio_send_pts,
+        .data = (uint8_t *)out,
+        .size = size,
+    };
+    return audio_render_write(render->cfg.audio_render, &frame);
+}
+
 static int _render_write_audio(av_render_thread_res_t *res, av_render_audio_frame_t *audio_frame)
 {
     if (res->render->a_render_res->audio_rendered == false) {
@@ -608,15 +1261,37 @@ static int _render_write_audio(av_render_thread_res_t *res, av_render_audio_fram
     if (res->paused) {
         return 0;
     }
-    // Update send pts
-    res->render->a_render_res->audio_send_pts = audio_frame->pts;
+    // Update send pts, duration is added after written so that playing position keeps correct during blocking write
+    av_render_audio_res_t *a_render = res->render->a_render_res;
+    a_render->audio_send_pts = audio_frame->pts;
+    a_render->audio_send_duration = 0;
     int ret = 0;
+    av_render_audio_frame_t out_frame;
     if (res->flushing == false) {
+        // Frame may be owned by decoder, write processed copy instead of modify it
+        out_frame = *audio_frame;
+        audio_frame = &out_frame;
+        if (res->render->cfg.audio_jitter.enable) {
+            jitter_adjust_speed(res->render, &res->render->a_render_res->jitter, audio_frame->pts);
+        } else if (res->render->cfg.audio_catchup.enable) {
+            catchup_adjust(res->render, audio_frame);
+        }
+        if (res->render->mixer) {
+            audio_mix_frame(res->render, audio_frame);
+        }
+        av_render_stage_clock_t clk;
+        stats_stage_begin(res->render, AV_RENDER_STREAM_AUDIO, &clk);
         ret = audio_render_write(res->render->cfg.audio_render, audio_frame);
+        stats_stage_end(res->render, AV_RENDER_STREAM_AUDIO, AV_RENDER_STAGE_RENDER, &clk, res->thread == NULL);
         if (ret != 0) {
             ESP_LOGE(TAG, "Fail to render audio ret %d", ret);
             return ret;
         }
+        av_render_audio_frame_info_t *info = get_audio_render_info(a_render);
+        int sample_size = info->channel * info->bits_per_sample >> 3;
+        if (sample_size && info->sample_rate) {
+            a_render->audio_send_duration = (uint32_t)((uint64_t)audio_frame->size * 1000 / sample_size / info->sample_rate);
+        }
     }
     if (audio_frame->eos) {
         if (res->render->event_cb) {
@@ -663,7 +1338,10 @@ static int _render_write_video(av_render_thread_res_t *res, av_render_video_fram
                 video_sync_control_before_render(res->render, video_frame->pts, &skip);
             }
             if (1 || skip == false) {
+                av_render_stage_clock_t clk;
+                stats_stage_begin(res->render, AV_RENDER_STREAM_VIDEO, &clk);
                 ret = video_render_write(res->render->cfg.video_render, video_frame);
+                stats_stage_end(res->render, AV_RENDER_STREAM_VIDEO, AV_RENDER_STAGE_RENDER, &clk, res->thread == NULL);
             }
             if (ret != 0) {
                 ESP_LOGE(TAG, "Fail to render video ret %d", ret);
@@ -681,6 +1359,14 @@ static int _render_write_video(av_render_thread_res_t *res, av_render_video_fram
 
 static int a_render_body(av_render_thread_res_t *res, bool drop)
 {
+    // Main stream idle, output mixed streams so that they can play without main audio
+    if (drop == false && res->flushing == false && data_queue_have_data(res->data_q) == false &&
+        audio_mix_pending(res->render)) {
+        if (audio_mix_output(res->render) != 0) {
+            ESP_LOGE(TAG, "Fail to render mixed audio");
+        }
+        return 0;
+    }
     av_render_audio_frame_t data;
     int ret = read_for_a_render(res->data_q, &data);
     RETURN_ON_FAIL(ret);
@@ -704,37 +1390,66 @@ static int a_render_body(av_render_thread_res_t *res, bool drop)
     return 0;
 }
 
+static int video_convert_frame(av_render_t *render, av_render_vdec_res_t *vdec_res, av_render_video_frame_t *frame)
+{
+    // Convert into display frame buffer directly to avoid extra full frame copy
+    av_render_frame_buffer_t frame_buffer = { 0 };
+    uint8_t *out = NULL;
+    if (video_render_get_frame_buffer(render->cfg.video_render, &frame_buffer) == 0 &&
+        frame_buffer.size >= vdec_res->vid_convert_out_size) {
+        out = frame_buffer.data;
+    } else {
+        if (vdec_res->vid_convert_out == NULL) {
+            vdec_res->vid_convert_out = media_lib_malloc(vdec_res->vid_convert_out_size);
+            if (vdec_res->vid_convert_out == NULL) {
+                ESP_LOGE(TAG, "Fail to allocate video convert output");
+                return ESP_MEDIA_ERR_NO_MEM;
+            }
+        }
+        out = vdec_res->vid_convert_out;
+    }
+    av_render_stage_clock_t clk;
+    stats_stage_begin(render, AV_RENDER_STREAM_VIDEO, &clk);
+    int ret = convert_color(vdec_res->vid_convert, frame->data, frame->size, out, vdec_res->vid_convert_out_size);
+    stats_stage_end(render, AV_RENDER_STREAM_VIDEO, AV_RENDER_STAGE_CONVERT, &clk,
+                    render->v_render_res->thread_res.thread == NULL);
+    frame->data = out;
+    frame->size = vdec_res->vid_convert_out_size;
+    return ret;
+}
+
 static int v_render_body(av_render_thread_res_t *res, bool drop)
 {
     av_render_video_frame_t data;
-    int ret = read_for_v_render(res->data_q, &data);
+    video_fb_pool_handle_t pool = NULL;
+    int ret = read_for_v_render(res->data_q, &data, &pool);
     RETURN_ON_FAIL(ret);
+    uint8_t *fb = data.data;
     if (drop == false && (data.size || data.eos)) {
         av_render_vdec_res_t *vdec_res = res->render->vdec_res;
         if (vdec_res && vdec_res->vid_convert) {
-            // Do color convert firstly
-            ret = convert_color(vdec_res->vid_convert,
-                 data.data, data.size, 
-                 vdec_res->vid_convert_out, vdec_res->vid_convert_out_size);
-            data.data = vdec_res->vid_convert_out;
-            data.size = vdec_res->vid_convert_out_size;
-        }
-        ret = _render_write_video(res, &data);
+            ret = video_convert_frame(res->render, vdec_res, &data);
+        }
+        if (ret == 0) {
+            ret = _render_write_video(res, &data);
+        }
         if (ret != 0) {
             ESP_LOGE(TAG, "Fail to render video");
         }
     }
-    if (res->paused) {
+    if (res->paused && drop == false) {
         data_queue_peek_unlock(res->data_q);
     } else {
+        // Release reference hold by queue, buffer can be reused by decoder
+        video_fb_pool_unref(pool, fb);
         data_queue_read_unlock(res->data_q);
     }
     return 0;
 }
 
-static int create_thread_res(av_render_thread_res_t *res, const char *name,
-                             int (*body)(av_render_thread_res_t *res, bool drop),
-                             int buffer_size, int wait_bits)
+static int create_queue_res(av_render_thread_res_t *res, const char *name,
+                            int (*body)(av_render_thread_res_t *res, bool drop),
+                            int buffer_size, int wait_bits, bool spsc, data_queue_mem_t mem)
 {
     do {
         if (res->msg_q == NULL) {
@@ -745,20 +1460,35 @@ static int create_thread_res(av_render_thread_res_t *res, const char *name,
         }
         res->name = name;
         if (res->data_q == NULL) {
-            res->data_q = data_queue_init(buffer_size);
+            // Use lock-free mode when queue only have one consumer
+            data_queue_cfg_t q_cfg = {
+                .size = buffer_size,
+                .mem = mem,
+                .spsc = spsc,
+            };
+            res->data_q = data_queue_init_with_cfg(&q_cfg);
         }
         if (res->data_q == NULL) {
             break;
         }
+        data_queue_enable_stats(res->data_q, name);
         res->wait_bits = wait_bits;
         res->render_body = body;
-        int ret = media_lib_thread_create_from_scheduler(&res->thread, name, render_thread, res);
-        BREAK_ON_FAIL(ret);
         return 0;
     } while (0);
     return -1;
 }
 
+static int create_thread_res(av_render_thread_res_t *res, const char *name,
+                             int (*body)(av_render_thread_res_t *res, bool drop),
+                             int buffer_size, int wait_bits, bool spsc, data_queue_mem_t mem)
+{
+    int ret = create_queue_res(res, name, body, buffer_size, wait_bits, spsc, mem);
+    RETURN_ON_FAIL(ret);
+    ret = media_lib_thread_create_from_scheduler(&res->thread, name, render_thread, res);
+    return ret == 0 ? 0 : -1;
+}
+
 static void destroy_thread_res(av_render_thread_res_t *res)
 {
     if (res->msg_q) {
@@ -777,6 +1507,7 @@ static int send_msg_to_thread(av_render_thread_res_t *res, int head_size, av_ren
     int ret = -1;
     if (res->msg_q) {
         ret = msg_q_send(res->msg_q, msg, sizeof(av_render_msg_t));
+        coop_wakeup(res->render);
     }
     // Try to wakeup wait data_queue when fifo enough
     if (res->data_q) {
@@ -865,6 +1596,171 @@ static void render_thread(void *arg)
     media_lib_thread_destroy(NULL);
 }
 
+static void coop_wakeup(av_render_t *render)
+{
+    if (render && render->coop) {
+        media_lib_sema_unlock(render->coop->wake);
+    }
+}
+
+// Decode stage must not run when render can not take its output, keep packets in decoder fifo as threaded mode does
+static bool coop_render_blocked(av_render_thread_res_t *res)
+{
+    av_render_t *render = res->render;
+    av_render_audio_res_t *a_render = render->a_render_res;
+    if (render->adec_res == NULL || res != &render->adec_res->thread_res || a_render == NULL ||
+        a_render->thread_res.data_q == NULL) {
+        return false;
+    }
+    if (a_render->thread_res.paused) {
+        return true;
+    }
+    return data_queue_get_available(a_render->thread_res.data_q) < a_render->max_frame_size;
+}
+
+// Handle pending messages then run stage body once, return 1 if processed data, -1 if stage quit
+static int coop_run_stage(av_render_thread_res_t *res)
+{
+    av_render_msg_t msg = { 0 };
+    while (msg_q_recv(res->msg_q, &msg, sizeof(av_render_msg_t), true) == 0) {
+        ESP_LOGI(TAG, "%s got msg:%s", res->name, msg_to_str(msg.type));
+        if (msg.type == AV_RENDER_MSG_CLOSE) {
+            return -1;
+        }
+        if (msg.type == AV_RENDER_MSG_FLUSH) {
+            render_consume_all(res);
+            _SET_BITS(res->render->event_group, res->wait_bits << FLUSH_SHIFT_BITS);
+            res->flushing = false;
+        } else if (msg.type == AV_RENDER_MSG_PAUSE) {
+            res->paused = true;
+        } else if (msg.type == AV_RENDER_MSG_RESUME) {
+            ESP_LOGI(TAG, "%s resumed", res->name);
+            res->paused = false;
+        }
+    }
+    bool has_data = data_queue_have_data(res->data_q);
+    if (has_data == false && res == &res->render->a_render_res->thread_res) {
+        has_data = audio_mix_pending(res->render);
+    }
+    if (res->paused || has_data == false || coop_render_blocked(res)) {
+        return 0;
+    }
+    int ret = res->render_body(res, false);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "Stage %s process fail %d", res->name, ret);
+        return -1;
+    }
+    return 1;
+}
+
+static void coop_thread(void *arg)
+{
+    av_render_t *render = (av_render_t *)arg;
+    av_render_coop_t *coop = render->coop;
+    while (1) {
+        bool busy = false;
+        bool running = true;
+        for (int i = 0; i < COOP_STAGE_NUM && running; i++) {
+            av_render_thread_res_t *res = coop->stage[i];
+            if (res == NULL) {
+                continue;
+            }
+            int ret = coop_run_stage(res);
+            if (ret > 0) {
+                busy = true;
+            } else if (ret < 0) {
+                coop->stage[i] = NULL;
+                running = false;
+                for (int j = 0; j < COOP_STAGE_NUM; j++) {
+                    if (coop->stage[j]) {
+                        running = true;
+                    }
+                }
+                // Clear thread before notify so that new stage can restart it
+                if (running == false) {
+                    coop->thread = NULL;
+                }
+                res->thread = NULL;
+                ESP_LOGI(TAG, "Stage %s exited", res->name);
+                render_consume_all(res);
+                _SET_BITS(render->event_group, res->wait_bits);
+            }
+        }
+        if (running == false) {
+            break;
+        }
+        if (busy == false) {
+            media_lib_sema_lock(coop->wake, COOP_IDLE_WAIT_MS);
+        }
+    }
+    ESP_LOGI(TAG, "Thread APipe exited");
+    media_lib_thread_destroy(NULL);
+}
+
+static int coop_attach_stage(av_render_t *render, av_render_thread_res_t *res)
+{
+    if (render->coop == NULL) {
+        av_render_coop_t *coop = (av_render_coop_t *)media_lib_calloc(1, sizeof(av_render_coop_t));
+        if (coop == NULL) {
+            return ESP_MEDIA_ERR_NO_MEM;
+        }
+        if (media_lib_sema_create(&coop->wake) != 0) {
+            media_lib_free(coop);
+            return ESP_MEDIA_ERR_NO_MEM;
+        }
+        render->coop = coop;
+    }
+    av_render_coop_t *coop = render->coop;
+    // Render stage run firstly so that decoded data is consumed before decode more
+    coop->stage[res->wait_bits == A_RENDER_CLOSED_BITS ? 0 : 1] = res;
+    if (coop->thread == NULL) {
+        int ret = media_lib_thread_create_from_scheduler(&coop->thread, "APipe", coop_thread, render);
+        if (ret != 0) {
+            coop->stage[res->wait_bits == A_RENDER_CLOSED_BITS ? 0 : 1] = NULL;
+            return ESP_MEDIA_ERR_FAIL;
+        }
+    }
+    res->thread = coop->thread;
+    coop_wakeup(render);
+    return 0;
+}
+
+// Audio decoder and render run as stages of one thread in cooperative mode
+static int create_audio_thread_res(av_render_t *render, av_render_thread_res_t *res, const char *name,
+                                   int (*body)(av_render_thread_res_t *res, bool drop),
+                                   int buffer_size, int wait_bits, bool spsc)
+{
+    if (render->cfg.audio_coop == false) {
+        return create_thread_res(res, name, body, buffer_size, wait_bits, spsc, DATA_QUEUE_MEM_INTERNAL);
+    }
+    int ret = create_queue_res(res, name, body, buffer_size, wait_bits, spsc, DATA_QUEUE_MEM_INTERNAL);
+    RETURN_ON_FAIL(ret);
+    return coop_attach_stage(render, res);
+}
+
+static uint8_t *get_a_render_buffer(av_render_t *render, int size)
+{
+    av_render_audio_res_t *a_render = render->a_render_res;
+    av_render_thread_res_t *res = &a_render->thread_res;
+    if (size > a_render->max_frame_size) {
+        a_render->max_frame_size = size;
+    }
+    // Block until render thread consume data, also used when producer is not cooperative thread
+    if (render->coop == NULL || a_render->decode_in_sync) {
+        return (uint8_t *)data_queue_get_buffer(res->data_q, size);
+    }
+    // Cannot block inside cooperative thread, drain render stage instead until space enough
+    uint8_t *b = NULL;
+    while (data_queue_get_buffer_timeout(res->data_q, size, (void **)&b, 0) != 0 || b == NULL) {
+        if (res->paused || res->flushing || data_queue_have_data(res->data_q) == false) {
+            ESP_LOGW(TAG, "Audio render fifo full, drop %d bytes", size);
+            return NULL;
+        }
+        a_render_body(res, false);
+    }
+    return b;
+}
+
 static bool audio_need_decode_in_sync(av_render_t *render, av_render_audio_info_t *audio_info)
 {
     if (audio_info->codec == AV_RENDER_AUDIO_CODEC_PCM || render->cfg.audio_raw_fifo_size == 0) {
@@ -902,29 +1798,168 @@ static bool audio_need_resample(av_render_audio_res_t *a_render)
     if (0 != memcmp(&a_render->out_frame_info, &a_render->audio_frame_info, sizeof(av_render_audio_frame_info_t))) {
         return true;
     }
-    return false;
+    return false;
+}
+
+static bool video_need_render_in_sync(av_render_t *render)
+{
+    if (render->cfg.video_render_fifo_size == 0) {
+        return true;
+    }
+    return false;
+}
+
+int audio_render_frame_reached(av_render_audio_frame_t *frame, void *ctx)
+{
+    av_render_audio_res_t *a_render = (av_render_audio_res_t *)ctx;
+    int ret = -1;
+    trace_data(a_render->thread_res.render, AV_RENDER_TRACE_ARENDER, frame->pts, frame->data, frame->size);
+    if (a_render->audio_packet_reached) {
+        // Write to audio render queue or write to audio render directly
+        if (a_render->fb_frame && frame->data == a_render->fb_frame->data) {
+            // Decoded into render queue directly, only update frame information
+            memcpy(a_render->fb_frame, frame, sizeof(av_render_audio_frame_t));
+            ret = 0;
+        } else if (a_render->thread_res.thread) {
+            ret = put_to_a_render(a_render->thread_res.render, a_render->thread_res.data_q, frame);
+        } else {
+            ret = _render_write_audio(&a_render->thread_res, frame);
+        }
+    }
+    return ret;
+}
+
+static void audio_plc_on_frame(av_render_audio_res_t *a_render, av_render_audio_frame_t *frame)
+{
+    av_render_audio_frame_info_t *info = &a_render->audio_frame_info;
+    int sample_size = info->channel * info->bits_per_sample / 8;
+    if (frame->size == 0 || sample_size == 0 || info->sample_rate == 0) {
+        return;
+    }
+    av_render_plc_t *plc = &a_render->plc;
+    plc->pkt_duration += (uint32_t)((uint64_t)frame->size * 1000 / sample_size / info->sample_rate);
+    // Keep last sample so that fade can start from it to avoid click
+    if (info->bits_per_sample == 16 && info->channel <= 2 && frame->size >= sample_size) {
+        memcpy(plc->last_sample, frame->data + frame->size - sample_size, sample_size);
+    }
+}
+
+static void audio_plc_pkt_done(av_render_audio_res_t *a_render, uint32_t pts)
+{
+    if (a_render == NULL) {
+        return;
+    }
+    av_render_plc_t *plc = &a_render->plc;
+    if (plc->pkt_duration) {
+        plc->frame_duration = plc->pkt_duration;
+        plc->next_pts = pts + plc->pkt_duration;
+        plc->next_pts_valid = true;
+    }
+    plc->pkt_duration = 0;
+}
+
+static void audio_plc_reset(av_render_audio_res_t *a_render)
+{
+    av_render_plc_t *plc = &a_render->plc;
+    plc->next_pts_valid = false;
+    plc->pkt_duration = 0;
+    plc->concealing = false;
+    memset(plc->last_sample, 0, sizeof(plc->last_sample));
+}
+
+static int audio_fade_frame(av_render_t *render, uint32_t pts, uint32_t duration)
+{
+    av_render_audio_res_t *a_render = render->a_render_res;
+    av_render_audio_frame_info_t *info = &a_render->audio_frame_info;
+    av_render_plc_t *plc = &a_render->plc;
+    int sample_size = info->channel * info->bits_per_sample / 8;
+    int samples = (int)((uint64_t)duration * info->sample_rate / 1000);
+    int size = samples * sample_size;
+    if (size == 0) {
+        return ESP_MEDIA_ERR_INVALID_ARG;
+    }
+    if (size > plc->fade_buf_size) {
+        uint8_t *fade_buf = (uint8_t *)media_lib_realloc(plc->fade_buf, size);
+        if (fade_buf == NULL) {
+            return ESP_MEDIA_ERR_NO_MEM;
+        }
+        plc->fade_buf = fade_buf;
+        plc->fade_buf_size = size;
+    }
+    memset(plc->fade_buf, 0, size);
+    // Fade out from last sample for first concealed frame, following frames keep silent
+    if (plc->concealing == false && info->bits_per_sample == 16 && info->channel <= 2) {
+        int16_t *pcm = (int16_t *)plc->fade_buf;
+        for (int i = 0; i < samples; i++) {
+            for (int ch = 0; ch < info->channel; ch++) {
+                *(pcm++) = (int16_t)((int32_t)plc->last_sample[ch] * (samples - i) / samples);
+            }
+        }
+        memset(plc->last_sample, 0, sizeof(plc->last_sample));
+    }
+    av_render_audio_frame_t frame = {
+        .pts = pts,
+        .data = plc->fade_buf,
+        .size = size,
+    };
+    return av_render_audio_frame_reached(&frame, render);
+}
+
+static void audio_conceal_gap(av_render_t *render, uint32_t pts)
+{
+    av_render_audio_res_t *a_render = render->a_render_res;
+    if (a_render == NULL) {
+        return;
+    }
+    av_render_plc_t *plc = &a_render->plc;
+    plc->pkt_duration = 0;
+    if (plc->next_pts_valid == false || a_render->audio_packet_reached == false || plc->frame_duration == 0) {
+        return;
+    }
+    int32_t gap = (int32_t)(pts - plc->next_pts);
+    // Ignore reordered packet and small pts jitter within half frame
+    if (gap * 2 < (int32_t)plc->frame_duration) {
+        return;
+    }
+    plc->gap_num++;
+    uint32_t lost = ((uint32_t)gap + plc->frame_duration / 2) / plc->frame_duration;
+    if (lost > PLC_MAX_FRAMES) {
+        ESP_LOGW(TAG, "Audio pts jump from %" PRIu32 " to %" PRIu32 ", skip concealment", plc->next_pts, pts);
+        return;
+    }
+    av_render_adec_res_t *adec_res = render->adec_res;
+    uint32_t lost_pts = plc->next_pts;
+    plc->concealing = false;
+    for (uint32_t i = 0; i < lost; i++) {
+        int ret = ESP_MEDIA_ERR_NOT_SUPPORT;
+        if (a_render->audio_is_pcm == false && adec_res && adec_res->adec) {
+            ret = adec_conceal(adec_res->adec, lost_pts);
+        }
+        if (ret == ESP_MEDIA_ERR_OK) {
+            plc->plc_frames++;
+        } else if (audio_fade_frame(render, lost_pts, plc->frame_duration) == ESP_MEDIA_ERR_OK) {
+            plc->fade_frames++;
+            plc->concealing = true;
+        }
+        lost_pts += plc->frame_duration;
+    }
+    plc->concealing = false;
+    plc->pkt_duration = 0;
 }
 
-static bool video_need_render_in_sync(av_render_t *render)
+// Keep audio render open when format not changed, reopen device cost hundreds of milliseconds
+static int audio_open_render(av_render_t *render, av_render_audio_frame_info_t *info)
 {
-    if (render->cfg.video_render_fifo_size == 0) {
-        return true;
+    av_render_audio_res_t *a_render = render->a_render_res;
+    if (a_render->render_opened && memcmp(&a_render->render_info, info, sizeof(av_render_audio_frame_info_t)) == 0) {
+        return 0;
     }
-    return false;
-}
-
-int audio_render_frame_reached(av_render_audio_frame_t *frame, void *ctx)
-{
-    av_render_audio_res_t *a_render = (av_render_audio_res_t *)ctx;
-    int ret = -1;
-    dump_data(AV_RENDER_DUMP_ARENDER_DATA, frame->data, frame->size);
-    if (a_render->audio_packet_reached) {
-        // Write to audio render queue or write to audio render directly
-        if (a_render->thread_res.thread) {
-            ret = put_to_a_render(a_render->thread_res.data_q, frame);
-        } else {
-            ret = _render_write_audio(&a_render->thread_res, frame);
-        }
+    audio_render_close(render->cfg.audio_render);
+    a_render->render_opened = false;
+    int ret = audio_render_open(render->cfg.audio_render, info);
+    if (ret == 0) {
+        a_render->render_opened = true;
+        a_render->render_info = *info;
     }
     return ret;
 }
@@ -952,11 +1987,10 @@ static int av_render_audio_frame_reached(av_render_audio_frame_t *frame, void *c
             }
         }
         // Reopen audio render using new frame information
-        audio_render_close(render->cfg.audio_render);
         ESP_LOGI(TAG, "Get need resample %d in:%d out:%d", a_render->need_resample,
                  (int)a_render->audio_frame_info.sample_rate, (int)a_render->out_frame_info.sample_rate);
         if (a_render->need_resample && audio_need_resample(a_render)) {
-            ret = audio_render_open(render->cfg.audio_render, &a_render->out_frame_info);
+            ret = audio_open_render(render, &a_render->out_frame_info);
             audio_resample_cfg_t resample_cfg = {
                 .input_info = a_render->audio_frame_info,
                 .output_info = a_render->out_frame_info,
@@ -973,7 +2007,7 @@ static int av_render_audio_frame_reached(av_render_audio_frame_t *frame, void *c
                 audio_resample_close(a_render->resample_handle);
                 a_render->resample_handle = NULL;
             }
-            ret = audio_render_open(render->cfg.audio_render, &a_render->audio_frame_info);
+            ret = audio_open_render(render, &a_render->audio_frame_info);
         }
         if (ret != 0) {
             ESP_LOGE(TAG, "Fail to create audio render");
@@ -983,8 +2017,8 @@ static int av_render_audio_frame_reached(av_render_audio_frame_t *frame, void *c
         a_render->a_render_in_sync = true;
         a_render->thread_res.render = render;
         if (audio_need_render_in_sync(render) == false && a_render->thread_res.thread == NULL) {
-            ret = create_thread_res(&a_render->thread_res, "ARender", a_render_body, render->cfg.audio_render_fifo_size,
-                                    A_RENDER_CLOSED_BITS);
+            ret = create_audio_thread_res(render, &a_render->thread_res, "ARender", a_render_body,
+                                          render->cfg.audio_render_fifo_size, A_RENDER_CLOSED_BITS, false);
             if (ret != 0) {
                 ESP_LOGE(TAG, "Fail to create audio render thread resource");
             } else {
@@ -992,15 +2026,60 @@ static int av_render_audio_frame_reached(av_render_audio_frame_t *frame, void *c
             }
         }
     }
+    audio_plc_on_frame(a_render, frame);
     if (a_render->resample_handle) {
         // write to resample
+        av_render_stage_clock_t clk;
+        stats_stage_begin(render, AV_RENDER_STREAM_AUDIO, &clk);
         ret = audio_resample_write(a_render->resample_handle, frame);
+        stats_stage_end(render, AV_RENDER_STREAM_AUDIO, AV_RENDER_STAGE_CONVERT, &clk, true);
     } else {
         ret = audio_render_frame_reached(frame, a_render);
     }
     return ret;
 }
 
+static uint8_t *av_render_fetch_aud_fb(int size, void *ctx)
+{
+    av_render_t *render = (av_render_t *)ctx;
+    av_render_audio_res_t *a_render = render->a_render_res;
+    // Only decode into render queue when decoded frame is put into it without resample
+    if (a_render == NULL || size == 0 || a_render->audio_packet_reached == false || a_render->resample_handle ||
+        a_render->thread_res.thread == NULL) {
+        return NULL;
+    }
+    size += sizeof(av_render_audio_frame_t);
+    uint8_t *b = get_a_render_buffer(render, size);
+    if (b == NULL) {
+        return NULL;
+    }
+    a_render->fb_frame = (av_render_audio_frame_t *)b;
+    a_render->fb_frame->data = b + sizeof(av_render_audio_frame_t);
+    a_render->fb_frame->size = 0;
+    return a_render->fb_frame->data;
+}
+
+static int av_render_release_aud_fb(uint8_t *addr, bool drop, void *ctx)
+{
+    av_render_t *render = (av_render_t *)ctx;
+    av_render_audio_res_t *a_render = render->a_render_res;
+    if (a_render == NULL) {
+        return 0;
+    }
+    if (a_render->fb_frame == NULL || addr != a_render->fb_frame->data) {
+        ESP_LOGE(TAG, "Release wrong data");
+        return ESP_MEDIA_ERR_INVALID_ARG;
+    }
+    uint32_t size = 0;
+    if (drop == false) {
+        size = sizeof(av_render_audio_frame_t) + a_render->fb_frame->size;
+    }
+    a_render->fb_frame = NULL;
+    int ret = data_queue_send_buffer(a_render->thread_res.data_q, size);
+    coop_wakeup(render);
+    return ret;
+}
+
 static void convert_to_audio_frame(av_render_audio_info_t *audio_info, av_render_audio_frame_info_t *frame_info)
 {
     frame_info->bits_per_sample = audio_info->bits_per_sample;
@@ -1016,35 +2095,43 @@ static uint8_t *av_render_fetch_vid_fb(int align, int size, void *ctx)
         return NULL;
     }
     av_render_vdec_res_t *vdec_res = render->vdec_res;
-    size = sizeof(av_render_video_frame_t) + size + align;
-    uint8_t *b = (uint8_t *)data_queue_get_buffer(v_render->thread_res.data_q, size);
-    if (b == NULL) {
-        return NULL;
+    // Pool sized by decoded resolution, recreate only when frame grows, old one freed after render release all
+    if (vdec_res->fb_pool && video_fb_pool_get_size(vdec_res->fb_pool) < size) {
+        video_fb_pool_destroy(vdec_res->fb_pool);
+        vdec_res->fb_pool = NULL;
+    }
+    if (vdec_res->fb_pool == NULL) {
+        int num = render->cfg.video_fb_num ? render->cfg.video_fb_num : VIDEO_DEFAULT_FB_NUM;
+        if (num < 2) {
+            num = 2;
+        }
+        vdec_res->fb_pool = video_fb_pool_create(num, size, (uint8_t)align);
+        if (vdec_res->fb_pool == NULL) {
+            ESP_LOGE(TAG, "No memory for %d video frame buffers size %d", num, size);
+            return NULL;
+        }
+        ESP_LOGI(TAG, "Create %d video frame buffers size %d align %d", num, size, align);
+    }
+    uint8_t *data = NULL;
+    while ((data = video_fb_pool_acquire(vdec_res->fb_pool, VIDEO_FB_WAIT_MS)) == NULL) {
+        // All buffers hold by render, stop waiting when render quit
+        if (v_render->thread_res.thread == NULL) {
+            break;
+        }
     }
-    vdec_res->fb_frame = (av_render_video_frame_t *)b;
-    b += sizeof(av_render_video_frame_t);
-    align -= 1;
-    vdec_res->fb_frame->data = (uint8_t *)(((uint32_t)b + align) & (~align));
-    vdec_res->fb_frame->size = 0;
-    return vdec_res->fb_frame->data;
+    return data;
 }
 
 static int av_render_release_vid_fb(uint8_t *addr, bool drop, void *ctx)
 {
     av_render_t *render = (av_render_t *)ctx;
-    av_render_video_res_t *v_render = render->v_render_res;
-    if (v_render == NULL) {
-        return 0;
-    }
     av_render_vdec_res_t *vdec_res = render->vdec_res;
-    if (vdec_res->fb_frame == NULL || addr != vdec_res->fb_frame->data) {
+    // Release reference of decoder, frame still hold by render queue if sent
+    if (vdec_res == NULL || video_fb_pool_unref(vdec_res->fb_pool, addr) == false) {
         ESP_LOGE(TAG, "Release wrong data");
+        return ESP_MEDIA_ERR_INVALID_ARG;
     }
-    uint32_t size = 0;
-    if (drop == false) {
-        size = vdec_res->fb_frame->size + (uint32_t)(addr - (uint8_t *)vdec_res->fb_frame);
-    }
-    return data_queue_send_buffer(v_render->thread_res.data_q, size);
+    return 0;
 }
 
 static int av_render_video_frame_reached(av_render_video_frame_t *frame, void *ctx)
@@ -1056,7 +2143,7 @@ static int av_render_video_frame_reached(av_render_video_frame_t *frame, void *c
     }
     av_render_vdec_res_t *vdec_res = render->vdec_res;
     int ret = 0;
-    dump_data(AV_RENDER_DUMP_VRENDER_DATA, frame->data, frame->size);
+    trace_data(render, AV_RENDER_TRACE_VRENDER, frame->pts, frame->data, frame->size);
     // Open video render when first packet reached
     if (v_render->video_packet_reached == false) {
         if (v_render->video_is_raw == false) {
@@ -1070,12 +2157,26 @@ static int av_render_video_frame_reached(av_render_video_frame_t *frame, void *c
                 ESP_LOGE(TAG, "Fail to get video frame information");
                 return ret;
             }
-            if (vdec_res->dec_out_fmt != vdec_res->out_fmt) {
+            // Scale to output size in color convert when decoded size not match
+            int out_width = v_render->video_frame_info.width;
+            int out_height = v_render->video_frame_info.height;
+            if (render->cfg.video_out_width && render->cfg.video_out_height) {
+                out_width = render->cfg.video_out_width;
+                out_height = render->cfg.video_out_height;
+            }
+            bool need_scale = (out_width != v_render->video_frame_info.width || out_height != v_render->video_frame_info.height);
+            int rotate = render->cfg.video_rotate;
+            if (vdec_res->dec_out_fmt != vdec_res->out_fmt || need_scale || rotate) {
                 color_convert_cfg_t convert_cfg = {
                     .from = vdec_res->dec_out_fmt,
                     .to = vdec_res->out_fmt,
                     .width = v_render->video_frame_info.width,
                     .height = v_render->video_frame_info.height,
+                    .out_width = out_width,
+                    .out_height = out_height,
+                    // Rotate or format only conversion has nothing to interpolate
+                    .scale = need_scale ? COLOR_CONVERT_SCALE_BILINEAR : COLOR_CONVERT_SCALE_NEAREST,
+                    .rotate = rotate,
                 };
                 vdec_res->vid_convert = init_convert_table(&convert_cfg);
                 if (vdec_res->vid_convert == NULL) {
@@ -1084,18 +2185,15 @@ static int av_render_video_frame_reached(av_render_video_frame_t *frame, void *c
                 }
             }
             if (vdec_res && vdec_res->vid_convert) {
-                // Delay to malloc video convert output size
-                int image_size = convert_table_get_image_size(vdec_res->out_fmt,
-                        v_render->video_frame_info.width, 
-                        v_render->video_frame_info.height);
-                uint8_t* vid_cvt_out = media_lib_realloc(vdec_res->vid_convert_out, image_size);
-                if (vid_cvt_out == NULL) {
-                    ESP_LOGE(TAG, "Fail to allocate video convert output");
-                    return ESP_MEDIA_ERR_NO_MEM;
+                // Convert output allocated when first used, not needed if render provide frame buffer
+                if (vdec_res->vid_convert_out) {
+                    media_lib_free(vdec_res->vid_convert_out);
+                    vdec_res->vid_convert_out = NULL;
                 }
-                vdec_res->vid_convert_out = vid_cvt_out;
-                vdec_res->vid_convert_out_size = image_size;
+                vdec_res->vid_convert_out_size = convert_table_get_image_size(vdec_res->out_fmt, out_width, out_height);
                 v_render->video_frame_info.type = vdec_res->out_fmt;
+                v_render->video_frame_info.width = (rotate == 90 || rotate == 270) ? out_height : out_width;
+                v_render->video_frame_info.height = (rotate == 90 || rotate == 270) ? out_width : out_height;
             }
             if (v_render->video_frame_info.fps == 0) {
                 v_render->video_frame_info.fps = old_fps;
@@ -1110,12 +2208,11 @@ static int av_render_video_frame_reached(av_render_video_frame_t *frame, void *c
         }
         v_render->video_packet_reached = true;
         v_render->v_render_in_sync = true;
-        // Tolerance for 3 frame later
-        v_render->sync_tolerance = 600;
+        v_render->sync_tolerance = VIDEO_SYNC_TOLERANCE;
         v_render->thread_res.render = render;
         if (v_render->use_fb == false && video_need_render_in_sync(render) == false && v_render->thread_res.thread == NULL) {
             ret = create_thread_res(&v_render->thread_res, "VRender", v_render_body, render->cfg.video_render_fifo_size,
-                                    V_RENDER_CLOSED_BITS);
+                                    V_RENDER_CLOSED_BITS, false, DATA_QUEUE_MEM_PSRAM);
             if (ret != 0) {
                 ESP_LOGE(TAG, "Fail to create video render thread resource");
             } else {
@@ -1127,27 +2224,20 @@ static int av_render_video_frame_reached(av_render_video_frame_t *frame, void *c
     if (v_render->video_packet_reached) {
         // Write to video render queue or write to video render directly
         if (v_render->thread_res.thread) {
-            if (v_render->use_fb) {
-                // Update frame information only
-                if (vdec_res->fb_frame) {
-                    uint8_t *frame_data = vdec_res->fb_frame->data;
-                    memcpy(vdec_res->fb_frame, frame, sizeof(av_render_video_frame_t));
-                    vdec_res->fb_frame->data = frame_data;
-                }
+            if (v_render->use_fb && vdec_res && video_fb_pool_contains(vdec_res->fb_pool, frame->data)) {
+                // Pass buffer reference only, decoder and render work on different buffers without copy
+                ret = put_fb_to_v_render(v_render->thread_res.data_q, frame, vdec_res->fb_pool);
             } else {
                 ret = put_to_v_render(v_render->thread_res.data_q, frame);
             }
         } else {
             av_render_vdec_res_t *vdec_res = render->vdec_res;
             if (vdec_res && vdec_res->vid_convert) {
-                // Do color convert firstly
-                ret = convert_color(vdec_res->vid_convert,
-                    frame->data, frame->size,
-                    vdec_res->vid_convert_out, vdec_res->vid_convert_out_size);
-                frame->data = vdec_res->vid_convert_out;
-                frame->size = vdec_res->vid_convert_out_size;
+                ret = video_convert_frame(render, vdec_res, frame);
+            }
+            if (ret == 0) {
+                ret = _render_write_video(&v_render->thread_res, frame);
             }
-            ret = _render_write_video(&v_render->thread_res, frame);
         }
     }
     return ret;
@@ -1202,6 +2292,13 @@ av_render_handle_t av_render_open(av_render_cfg_t *cfg)
         BREAK_ON_FAIL(ret);
         ret = media_lib_event_group_create(&render->event_group);
         BREAK_ON_FAIL(ret);
+        if (cfg->latency_stats) {
+            render->stats = (av_render_stats_res_t *)media_lib_calloc(1, sizeof(av_render_stats_res_t));
+            if (render->stats == NULL) {
+                ESP_LOGE(TAG, "No memory for latency statistics");
+                break;
+            }
+        }
         return render;
     } while (0);
     av_render_close(render);
@@ -1255,7 +2352,10 @@ int av_render_add_audio_stream(av_render_handle_t h, av_render_audio_info_t *aud
                 ret = ESP_MEDIA_ERR_NO_MEM;
                 break;
             }
+            render->a_render_res->jitter.user_speed = 1.0f;
         }
+        jitter_reset(&render->a_render_res->jitter);
+        audio_plc_reset(render->a_render_res);
         if (render->aud_fix_info.sample_rate) {
             memcpy(&render->a_render_res->out_frame_info, &render->aud_fix_info, sizeof(av_render_audio_frame_info_t));
             render->a_render_res->need_resample = true;
@@ -1268,7 +2368,7 @@ int av_render_add_audio_stream(av_render_handle_t h, av_render_audio_info_t *aud
                 av_render_msg_t msg = {
                     .type = AV_RENDER_MSG_CLOSE,
                 };
-                ret = send_msg_to_thread(&adec_res->thread_res, sizeof(av_render_audio_data_t), &msg);
+                ret = send_msg_to_thread(&adec_res->thread_res, sizeof(av_render_adec_item_t), &msg);
                 _WAIT_BITS(render->event_group, adec_res->thread_res.wait_bits);
             }
             adec_close(adec_res->adec);
@@ -1303,12 +2403,19 @@ int av_render_add_audio_stream(av_render_handle_t h, av_render_audio_info_t *aud
                 ret = ESP_MEDIA_ERR_FAIL;
                 break;
             }
+            // Decode into audio render queue directly to avoid extra PCM copy
+            adec_fb_cb_cfg_t fb_cfg = {
+                .fb_fetch = av_render_fetch_aud_fb,
+                .fb_return = av_render_release_aud_fb,
+                .ctx = render,
+            };
+            adec_set_fb_cb(adec_res->adec, &fb_cfg);
             adec_res->thread_res.render = render;
             adec_res->thread_res.use_pool = (render->pool_free != NULL);
             // Create thread for audio decoder
             if (audio_need_decode_in_sync(render, audio_info) == false) {
-                ret = create_thread_res(&adec_res->thread_res, "Adec", adec_body, render->cfg.audio_raw_fifo_size,
-                                        ADEC_CLOSED_BITS);
+                ret = create_audio_thread_res(render, &adec_res->thread_res, "Adec", adec_body,
+                                              render->cfg.audio_raw_fifo_size, ADEC_CLOSED_BITS, true);
                 if (ret != 0) {
                     ESP_LOGE(TAG, "Fail to create thread for ADec");
                     ret = ESP_MEDIA_ERR_FAIL;
@@ -1357,6 +2464,193 @@ int av_render_set_fixed_frame_info(av_render_handle_t h, av_render_audio_frame_i
     return ret;
 }
 
+static void audio_mix_wakeup(av_render_t *render)
+{
+    av_render_thread_res_t *res = &render->a_render_res->thread_res;
+    if (render->coop) {
+        coop_wakeup(render);
+        return;
+    }
+    // Render thread may block on empty fifo, send empty frame to let it output mixed data
+    int q_num = 0, q_size = 0;
+    data_queue_query(res->data_q, &q_num, &q_size);
+    if (q_num == 0) {
+        int head_size = sizeof(av_render_audio_frame_t);
+        uint8_t *b = (uint8_t *)data_queue_get_buffer(res->data_q, head_size);
+        if (b) {
+            memset(b, 0, head_size);
+            data_queue_send_buffer(res->data_q, head_size);
+        }
+    }
+}
+
+static int audio_mix_prepare(av_render_t *render)
+{
+    if (render->a_render_res == NULL) {
+        render->a_render_res = (av_render_audio_res_t *)media_lib_calloc(1, sizeof(av_render_audio_res_t));
+        RETURN_ON_NULL(render->a_render_res, ESP_MEDIA_ERR_NO_MEM);
+        render->a_render_res->jitter.user_speed = 1.0f;
+    }
+    av_render_audio_res_t *a_render = render->a_render_res;
+    // Open device with fixed format directly, main stream if added later reuse it without reopen
+    int ret = audio_open_render(render, &render->aud_fix_info);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "Fail to open audio render for mixing");
+        return ret;
+    }
+    a_render->thread_res.render = render;
+    if (a_render->thread_res.thread == NULL) {
+        ret = create_audio_thread_res(render, &a_render->thread_res, "ARender", a_render_body,
+                                      render->cfg.audio_render_fifo_size, A_RENDER_CLOSED_BITS, false);
+        if (ret != 0) {
+            ESP_LOGE(TAG, "Fail to create audio render thread resource");
+        }
+    }
+    return ret;
+}
+
+// Called with api_lock held, mixer is kept alive until waiter count drops back
+static void mix_wait_space(av_render_t *render)
+{
+    audio_mixer_t *mixer = render->mixer;
+    render->mix_waiters++;
+    media_lib_mutex_unlock(render->api_lock);
+    audio_mixer_wait_space(mixer, AUDIO_MIX_WAIT_MS);
+    media_lib_mutex_lock(render->api_lock, MEDIA_LIB_MAX_LOCK_TIME);
+    render->mix_waiters--;
+}
+
+static void mix_destroy(av_render_t *render)
+{
+    media_lib_mutex_lock(render->api_lock, MEDIA_LIB_MAX_LOCK_TIME);
+    audio_mixer_t *mixer = render->mixer;
+    render->mixer = NULL;
+    // Wake writers still waiting for space, they see no mixer and quit
+    while (mixer && render->mix_waiters > 0) {
+        audio_mixer_wakeup(mixer);
+        media_lib_mutex_unlock(render->api_lock);
+        media_lib_thread_sleep(5);
+        media_lib_mutex_lock(render->api_lock, MEDIA_LIB_MAX_LOCK_TIME);
+    }
+    media_lib_mutex_unlock(render->api_lock);
+    audio_mixer_destroy(mixer);
+}
+
+int av_render_add_mix_stream(av_render_handle_t h, av_render_audio_frame_info_t *info, float gain, int *stream_id)
+{
+    av_render_t *render = (av_render_t *)h;
+    if (render == NULL || info == NULL || stream_id == NULL) {
+        return ESP_MEDIA_ERR_INVALID_ARG;
+    }
+    media_lib_mutex_lock(render->api_lock, MEDIA_LIB_MAX_LOCK_TIME);
+    int ret = 0;
+    do {
+        // Mixing happens in render thread on fixed output format
+        if (render->cfg.audio_render == NULL || render->aud_fix_info.sample_rate == 0 ||
+            render->aud_fix_info.bits_per_sample != 16 || audio_need_render_in_sync(render)) {
+            ESP_LOGE(TAG, "Mix stream need 16 bits fixed frame info and audio render fifo");
+            ret = ESP_MEDIA_ERR_NOT_SUPPORT;
+            break;
+        }
+        if (render->mixer == NULL) {
+            render->mixer = audio_mixer_create(&render->aud_fix_info, AUDIO_MIX_FIFO_MS);
+            if (render->mixer == NULL) {
+                ret = ESP_MEDIA_ERR_NO_MEM;
+                break;
+            }
+        }
+        ret = audio_mix_prepare(render);
+        if (ret != 0) {
+            break;
+        }
+        ret = audio_mixer_add_stream(render->mixer, info, gain);
+        if (ret > 0) {
+            *stream_id = ret;
+            ret = 0;
+        }
+    } while (0);
+    media_lib_mutex_unlock(render->api_lock);
+    return ret;
+}
+
+int av_render_add_mix_data(av_render_handle_t h, int stream_id, av_render_audio_data_t *audio_data)
+{
+    av_render_t *render = (av_render_t *)h;
+    if (render == NULL || audio_data == NULL || stream_id <= AUDIO_MIXER_MAIN_STREAM) {
+        return ESP_MEDIA_ERR_INVALID_ARG;
+    }
+    int ret = 0;
+    int offset = 0;
+    while (offset < audio_data->size) {
+        int size = audio_data->size - offset;
+        if (size > AUDIO_MIX_CHUNK_SIZE) {
+            size = AUDIO_MIX_CHUNK_SIZE;
+        }
+        media_lib_mutex_lock(render->api_lock, MEDIA_LIB_MAX_LOCK_TIME);
+        if (render->mixer == NULL || render->a_render_res == NULL) {
+            ret = ESP_MEDIA_ERR_WRONG_STATE;
+        } else {
+            ret = audio_mixer_write(render->mixer, stream_id, audio_data->data + offset, size);
+            audio_mix_wakeup(render);
+        }
+        if (ret == ESP_MEDIA_ERR_EXCEED_LIMIT) {
+            // Lock released during wait so that reset can remove stream to stop waiting
+            mix_wait_space(render);
+            media_lib_mutex_unlock(render->api_lock);
+            continue;
+        }
+        media_lib_mutex_unlock(render->api_lock);
+        if (ret != 0) {
+            break;
+        }
+        offset += size;
+    }
+    return ret;
+}
+
+int av_render_set_stream_gain(av_render_handle_t h, int stream_id, float gain)
+{
+    av_render_t *render = (av_render_t *)h;
+    if (render == NULL) {
+        return ESP_MEDIA_ERR_INVALID_ARG;
+    }
+    media_lib_mutex_lock(render->api_lock, MEDIA_LIB_MAX_LOCK_TIME);
+    int ret = ESP_MEDIA_ERR_WRONG_STATE;
+    if (render->mixer == NULL && stream_id == AUDIO_MIXER_MAIN_STREAM && render->aud_fix_info.sample_rate &&
+        render->aud_fix_info.bits_per_sample == 16) {
+        // Main gain applied by mixer, create it on demand
+        render->mixer = audio_mixer_create(&render->aud_fix_info, AUDIO_MIX_FIFO_MS);
+    }
+    if (render->mixer) {
+        ret = audio_mixer_set_gain(render->mixer, stream_id, gain);
+    }
+    media_lib_mutex_unlock(render->api_lock);
+    return ret;
+}
+
+int av_render_remove_mix_stream(av_render_handle_t h, int stream_id, bool drain)
+{
+    av_render_t *render = (av_render_t *)h;
+    if (render == NULL || stream_id <= AUDIO_MIXER_MAIN_STREAM) {
+        return ESP_MEDIA_ERR_INVALID_ARG;
+    }
+    media_lib_mutex_lock(render->api_lock, MEDIA_LIB_MAX_LOCK_TIME);
+    // Wait until queued data fully played, stop when render is not running
+    while (drain && render->mixer && audio_mixer_get_pending(render->mixer, stream_id) > 0) {
+        if (render->a_render_res == NULL || render->a_render_res->thread_res.thread == NULL ||
+            render->a_render_res->thread_res.paused) {
+            break;
+        }
+        mix_wait_space(render);
+    }
+    int ret = ESP_MEDIA_ERR_WRONG_STATE;
+    if (render->mixer) {
+        ret = audio_mixer_remove_stream(render->mixer, stream_id);
+    }
+    media_lib_mutex_unlock(render->api_lock);
+    return ret;
+}
+
 static bool get_support_output_format(av_render_t *render, av_render_video_info_t *video_info, vdec_cfg_t *cfg)
 {
     av_render_video_frame_type_t out_type;
@@ -1427,7 +2721,7 @@ int av_render_add_video_stream(av_render_handle_t h, av_render_video_info_t *vid
                 av_render_msg_t msg = {
                     .type = AV_RENDER_MSG_CLOSE,
                 };
-                ret = send_msg_to_thread(&vdec_res->thread_res, sizeof(av_render_video_data_t), &msg);
+                ret = send_msg_to_thread(&vdec_res->thread_res, sizeof(av_render_vdec_item_t), &msg);
                 if (ret == 0) {
                     _WAIT_BITS(render->event_group, vdec_res->thread_res.wait_bits);
                 }
@@ -1474,15 +2768,19 @@ int av_render_add_video_stream(av_render_handle_t h, av_render_video_info_t *vid
             }
             vdec_res->thread_res.render = render;
             vdec_res->thread_res.use_pool = (render->pool_free != NULL);
+            vdec_res->codec = video_info->codec;
+            vdec_res->wait_key = false;
             v_render->thread_res.render = render;
             // When use FB pre create render resource
             if (v_render->use_fb && video_need_render_in_sync(render) == false && v_render->thread_res.thread == NULL) {
                 ret = create_thread_res(&v_render->thread_res, "VRender", v_render_body, render->cfg.video_render_fifo_size,
-                                        V_RENDER_CLOSED_BITS);
+                                        V_RENDER_CLOSED_BITS, false, DATA_QUEUE_MEM_PSRAM);
                 if (ret != 0) {
                     ESP_LOGE(TAG, "Fail to create video render thread resource");
                 } else {
                     v_render->v_render_in_sync = false;
+                    // Queued frames hold pool reference, release them through render body when consume
+                    v_render->thread_res.use_pool = true;
                     vdec_fb_cb_cfg_t vdec_cfg = {
                         .fb_fetch = av_render_fetch_vid_fb,
                         .fb_return = av_render_release_vid_fb,
@@ -1496,7 +2794,7 @@ int av_render_add_video_stream(av_render_handle_t h, av_render_video_info_t *vid
             // Create thread for audio decoder
             if (video_need_decode_in_sync(render, video_info) == false) {
                 ret = create_thread_res(&vdec_res->thread_res, "Vdec", vdec_body, render->cfg.video_raw_fifo_size,
-                                        VDEC_CLOSED_BITS);
+                                        VDEC_CLOSED_BITS, false, DATA_QUEUE_MEM_PSRAM);
                 if (ret != 0) {
                     ESP_LOGE(TAG, "Fail to create thread for VDec");
                     break;
@@ -1541,6 +2839,9 @@ int av_render_add_audio_data(av_render_handle_t h, av_render_audio_data_t *audio
             ret = ESP_MEDIA_ERR_WRONG_STATE;
             break;
         }
+        if (render->cfg.audio_jitter.enable && audio_data->size) {
+            jitter_on_arrive(render, &a_render->jitter, audio_data->pts);
+        }
         // If no need decode, notify raw data reached directly
         if (a_render->audio_is_pcm) {
             av_render_audio_frame_t audio_frame = {
@@ -1549,7 +2850,14 @@ int av_render_add_audio_data(av_render_handle_t h, av_render_audio_data_t *audio
                 .size = audio_data->size,
                 .eos = audio_data->eos,
             };
+            trace_data(render, AV_RENDER_TRACE_ADEC, audio_data->pts, audio_data->data, audio_data->size);
+            if (audio_data->size) {
+                audio_conceal_gap(render, audio_data->pts);
+            }
             ret = av_render_audio_frame_reached(&audio_frame, render);
+            if (ret == 0 && audio_data->size) {
+                audio_plc_pkt_done(a_render, audio_data->pts);
+            }
             break;
         }
         if (render->adec_res->adec == NULL) {
@@ -1560,7 +2868,8 @@ int av_render_add_audio_data(av_render_handle_t h, av_render_audio_data_t *audio
         // If decode async send to decode queue
         if (adec->thread_res.thread) {
             media_lib_mutex_unlock(render->api_lock);
-            ret = put_to_adec(adec->thread_res.data_q, audio_data, adec->thread_res.use_pool);
+            ret = put_to_adec(adec->thread_res.data_q, audio_data, adec->thread_res.use_pool, render->stats != NULL);
+            coop_wakeup(render);
             if (ret != 0) {
                 if (render->pool_free && audio_data->data) {
                     render->pool_free(audio_data->data, render->pool);
@@ -1614,7 +2923,7 @@ int av_render_add_video_data(av_render_handle_t h, av_render_video_data_t *video
         // If decode async send to decode queue
         if (vdec->thread_res.thread) {
             media_lib_mutex_unlock(render->api_lock);
-            ret = put_to_vdec(vdec->thread_res.data_q, video_data, vdec->thread_res.use_pool);
+            ret = put_to_vdec(vdec->thread_res.data_q, video_data, vdec->thread_res.use_pool, render->stats != NULL);
             if (ret != 0) {
                 if (render->pool_free && video_data->data) {
                     render->pool_free(video_data->data, render->pool);
@@ -1640,7 +2949,7 @@ bool av_render_audio_fifo_enough(av_render_handle_t h, av_render_audio_data_t *a
     }
     media_lib_mutex_lock(render->api_lock, MEDIA_LIB_MAX_LOCK_TIME);
     av_render_audio_res_t *a_render = render->a_render_res;
-    int need_size = sizeof(av_render_audio_data_t) + audio_data->size;
+    int need_size = sizeof(av_render_adec_item_t) + audio_data->size;
     bool enough = false;
     do {
         if (a_render == NULL) {
@@ -1674,7 +2983,7 @@ bool av_render_video_fifo_enough(av_render_handle_t h, av_render_video_data_t *v
     }
     media_lib_mutex_lock(render->api_lock, MEDIA_LIB_MAX_LOCK_TIME);
     av_render_video_res_t *v_render = render->v_render_res;
-    int need_size = sizeof(av_render_video_data_t) + video_data->size;
+    int need_size = sizeof(av_render_vdec_item_t) + video_data->size;
     bool enough = false;
     do {
         if (v_render == NULL) {
@@ -1749,32 +3058,32 @@ int render_pause(av_render_t *render, bool pause)
         // Only pause decoder when pause only render not set or render thread not exists
         if (render->cfg.pause_render_only == false || (render->a_render_res && render->a_render_res->thread_res.thread == NULL)) {
             if (render->adec_res && render->adec_res->thread_res.thread) {
-                send_msg_to_thread(&render->adec_res->thread_res, sizeof(av_render_audio_data_t), &msg);
+                send_msg_to_thread(&render->adec_res->thread_res, sizeof(av_render_adec_item_t), &msg);
             }
         }
         if (render->cfg.pause_render_only == false || (render->v_render_res && render->v_render_res->thread_res.thread == NULL)) {
             if (render->vdec_res && render->vdec_res->thread_res.thread) {
-                send_msg_to_thread(&render->vdec_res->thread_res, sizeof(av_render_video_data_t), &msg);
+                send_msg_to_thread(&render->vdec_res->thread_res, sizeof(av_render_vdec_item_t), &msg);
             }
         }
         if (render->a_render_res && render->a_render_res->thread_res.thread) {
             send_msg_to_thread(&render->a_render_res->thread_res, sizeof(av_render_audio_frame_t), &msg);
         }
         if (render->v_render_res && render->v_render_res->thread_res.thread) {
-            send_msg_to_thread(&render->v_render_res->thread_res, sizeof(av_render_video_frame_t), &msg);
+            send_msg_to_thread(&render->v_render_res->thread_res, sizeof(av_render_v_render_item_t), &msg);
         }
     } else {
         if (render->a_render_res && render->a_render_res->thread_res.thread) {
             send_msg_to_thread(&render->a_render_res->thread_res, sizeof(av_render_audio_frame_t), &msg);
         }
         if (render->v_render_res && render->v_render_res->thread_res.thread) {
-            send_msg_to_thread(&render->v_render_res->thread_res, sizeof(av_render_video_frame_t), &msg);
+            send_msg_to_thread(&render->v_render_res->thread_res, sizeof(av_render_v_render_item_t), &msg);
         }
         if (render->adec_res && render->adec_res->thread_res.thread) {
-            send_msg_to_thread(&render->adec_res->thread_res, sizeof(av_render_audio_data_t), &msg);
+            send_msg_to_thread(&render->adec_res->thread_res, sizeof(av_render_adec_item_t), &msg);
         }
         if (render->vdec_res && render->vdec_res->thread_res.thread) {
-            send_msg_to_thread(&render->vdec_res->thread_res, sizeof(av_render_video_data_t), &msg);
+            send_msg_to_thread(&render->vdec_res->thread_res, sizeof(av_render_vdec_item_t), &msg);
         }
     }
     printf("Pause set to %d\n", pause);
@@ -1794,7 +3103,7 @@ static int render_flush(av_render_t *render)
             render->a_render_res->thread_res.flushing = true;
             render_consume_all(&render->a_render_res->thread_res);
         }
-        send_msg_to_thread(&render->adec_res->thread_res, sizeof(av_render_audio_data_t), &msg);
+        send_msg_to_thread(&render->adec_res->thread_res, sizeof(av_render_adec_item_t), &msg);
         wait_bits = render->adec_res->thread_res.wait_bits << FLUSH_SHIFT_BITS;
         _WAIT_BITS(render->event_group, wait_bits);
         printf("Wait for %x finished\n", wait_bits);
@@ -1805,7 +3114,7 @@ static int render_flush(av_render_t *render)
             render->v_render_res->thread_res.flushing = true;
             render_consume_all(&render->v_render_res->thread_res);
         }
-        send_msg_to_thread(&render->vdec_res->thread_res, sizeof(av_render_video_data_t), &msg);
+        send_msg_to_thread(&render->vdec_res->thread_res, sizeof(av_render_vdec_item_t), &msg);
         wait_bits = render->vdec_res->thread_res.wait_bits << FLUSH_SHIFT_BITS;
         _WAIT_BITS(render->event_group, wait_bits);
         printf("Wait for %x finished\n", wait_bits);
@@ -1818,7 +3127,7 @@ static int render_flush(av_render_t *render)
     }
     if (render->v_render_res && render->v_render_res->thread_res.thread) {
         render->v_render_res->thread_res.flushing = true;
-        send_msg_to_thread(&render->v_render_res->thread_res, sizeof(av_render_video_frame_t), &msg);
+        send_msg_to_thread(&render->v_render_res->thread_res, sizeof(av_render_v_render_item_t), &msg);
         wait_bits = render->v_render_res->thread_res.wait_bits << FLUSH_SHIFT_BITS;
     }
     _WAIT_BITS(render->event_group, wait_bits);
@@ -1827,8 +3136,13 @@ static int render_flush(av_render_t *render)
         render->v_render_res->video_rendered = false;
         render->v_render_res->sent_frame_num = 0;
     }
+    if (render->vdec_res) {
+        render->vdec_res->wait_key = false;
+    }
     if (render->a_render_res) {
         render->a_render_res->audio_rendered = false;
+        jitter_reset(&render->a_render_res->jitter);
+        audio_plc_reset(render->a_render_res);
     }
     return 0;
 }
@@ -1843,7 +3157,14 @@ int av_render_set_speed(av_render_handle_t h, float speed)
         return 0;
     }
     media_lib_mutex_lock(render->api_lock, MEDIA_LIB_MAX_LOCK_TIME);
-    int ret = audio_render_set_speed(render->cfg.audio_render, speed);
+    int ret = 0;
+    if (render->cfg.audio_jitter.enable && render->a_render_res) {
+        // Combine with jitter stretch ratio and apply in audio render context
+        render->a_render_res->jitter.user_speed = speed;
+        render->a_render_res->jitter.speed_changed = true;
+    } else {
+        ret = audio_render_set_speed(render->cfg.audio_render, speed);
+    }
     media_lib_mutex_unlock(render->api_lock);
     return ret;
 }
@@ -1890,7 +3211,8 @@ static int av_render_get_audio_pts(av_render_t *render, uint32_t *out_pts)
 {
     av_render_audio_res_t *a_render = render->a_render_res;
     if (a_render && a_render->audio_packet_reached) {
-        uint32_t audio_pts = a_render->audio_send_pts;
+        // Playing position is end of written data minus data queued in render
+        uint32_t audio_pts = a_render->audio_send_pts + a_render->audio_send_duration;
         uint32_t latency = 0;
         int ret = audio_render_get_latency(render->cfg.audio_render, &latency);
         if (ret == 0) {
@@ -1961,6 +3283,21 @@ int av_render_query(av_render_handle_t h)
                  render->a_render_res->thread_res.flushing, render->a_render_res->thread_res.paused);
         ESP_LOGI(TAG, "Audio render pts %" PRIu32 " use resample %d",
                  render->a_render_res->audio_send_pts, render->a_render_res->need_resample);
+        av_render_plc_t *plc = &render->a_render_res->plc;
+        ESP_LOGI(TAG, "Audio gaps %" PRIu32 " concealed frames plc:%" PRIu32 " fade:%" PRIu32,
+                 plc->gap_num, plc->plc_frames, plc->fade_frames);
+        if (render->cfg.audio_jitter.enable) {
+            av_render_jitter_t *jitter = &render->a_render_res->jitter;
+            ESP_LOGI(TAG, "Audio jitter %" PRIu32 "ms delay %" PRIu32 "/%" PRIu32 "ms stretch %.2f",
+                     jitter->jitter_q4 >> 4, jitter->cur_delay, jitter->target_delay, jitter->stretch);
+        }
+        if (render->cfg.audio_catchup.enable) {
+            ESP_LOGI(TAG, "Audio catch-up active %d trimmed %" PRIu32 " samples",
+                     render->a_render_res->catchup_active, render->a_render_res->catchup.trimmed);
+        }
+        if (render->mixer) {
+            ESP_LOGI(TAG, "Audio mix pending %d samples", audio_mixer_get_pending(render->mixer, 0));
+        }
     }
     if (render->vdec_res) {
         data_queue_t *q = render->vdec_res->thread_res.data_q;
@@ -1969,6 +3306,9 @@ int av_render_query(av_render_handle_t h)
             data_queue_query(q, &q_num, &q_size);
         }
         ESP_LOGI(TAG, "Video decoder fifo size %d items %d err:%d", q_size, q_num, render->vdec_res->video_err_cnt);
+        av_render_drop_stat_t *drop = &render->vdec_res->drop_stat;
+        ESP_LOGI(TAG, "Video decoded %" PRIu32 " dropped %" PRIu32 " skip to key %" PRIu32 " skipped %" PRIu32,
+                 drop->decoded, drop->dropped, drop->skip_to_key, drop->skipped);
         ESP_LOGI(TAG, "Video decoder status flashing: %d paused: %d",
                  render->vdec_res->thread_res.flushing, render->vdec_res->thread_res.paused);
     }
@@ -1983,17 +3323,146 @@ int av_render_query(av_render_handle_t h)
                  render->v_render_res->thread_res.flushing, render->v_render_res->thread_res.paused);
         ESP_LOGI(TAG, "Video render pts %" PRIu32, render->v_render_res->video_send_pts);
     }
+    if (render->stats) {
+        const char *stream_name[] = { "Audio", "Video" };
+        const char *stage_name[] = { "queue", "decode", "convert", "render" };
+        for (int i = 0; i < AV_RENDER_STREAM_MAX; i++) {
+            for (int j = 0; j < AV_RENDER_STAGE_MAX; j++) {
+                latency_hist_t *hist = &render->stats->hist[i][j];
+                if (hist->total == 0) {
+                    continue;
+                }
+                ESP_LOGI(TAG, "%s %s latency p50:%" PRIu32 " p95:%" PRIu32 " p99:%" PRIu32 " max:%" PRIu32 "us",
+                         stream_name[i], stage_name[j], latency_hist_percentile(hist, 50),
+                         latency_hist_percentile(hist, 95), latency_hist_percentile(hist, 99), latency_hist_max(hist));
+            }
+        }
+    }
     media_lib_mutex_unlock(render->api_lock);
     return 0;
 }
 
+int av_render_get_jitter_stat(av_render_handle_t h, av_render_jitter_stat_t *stat)
+{
+    av_render_t *render = (av_render_t *)h;
+    if (render == NULL || stat == NULL) {
+        return ESP_MEDIA_ERR_INVALID_ARG;
+    }
+    media_lib_mutex_lock(render->api_lock, MEDIA_LIB_MAX_LOCK_TIME);
+    int ret = ESP_MEDIA_ERR_WRONG_STATE;
+    if (render->cfg.audio_jitter.enable && render->a_render_res) {
+        av_render_jitter_t *jitter = &render->a_render_res->jitter;
+        stat->jitter = jitter->jitter_q4 >> 4;
+        stat->target_delay = jitter->target_delay;
+        stat->cur_delay = jitter->cur_delay;
+        stat->stretch = jitter->stretch;
+        ret = ESP_MEDIA_ERR_OK;
+    }
+    media_lib_mutex_unlock(render->api_lock);
+    return ret;
+}
+
+int av_render_get_plc_stat(av_render_handle_t h, av_render_plc_stat_t *stat)
+{
+    av_render_t *render = (av_render_t *)h;
+    if (render == NULL || stat == NULL) {
+        return ESP_MEDIA_ERR_INVALID_ARG;
+    }
+    media_lib_mutex_lock(render->api_lock, MEDIA_LIB_MAX_LOCK_TIME);
+    int ret = ESP_MEDIA_ERR_WRONG_STATE;
+    if (render->a_render_res) {
+        av_render_plc_t *plc = &render->a_render_res->plc;
+        stat->gap_num = plc->gap_num;
+        stat->plc_frames = plc->plc_frames;
+        stat->fade_frames = plc->fade_frames;
+        ret = ESP_MEDIA_ERR_OK;
+    }
+    media_lib_mutex_unlock(render->api_lock);
+    return ret;
+}
+
+int av_render_get_drop_stat(av_render_handle_t h, av_render_drop_stat_t *stat)
+{
+    av_render_t *render = (av_render_t *)h;
+    if (render == NULL || stat == NULL) {
+        return ESP_MEDIA_ERR_INVALID_ARG;
+    }
+    media_lib_mutex_lock(render->api_lock, MEDIA_LIB_MAX_LOCK_TIME);
+    int ret = ESP_MEDIA_ERR_WRONG_STATE;
+    if (render->vdec_res) {
+        *stat = render->vdec_res->drop_stat;
+        ret = ESP_MEDIA_ERR_OK;
+    }
+    media_lib_mutex_unlock(render->api_lock);
+    return ret;
+}
+
+int av_render_get_stats(av_render_handle_t h, av_render_stats_t *stats)
+{
+    av_render_t *render = (av_render_t *)h;
+    if (render == NULL || stats == NULL) {
+        return ESP_MEDIA_ERR_INVALID_ARG;
+    }
+    if (render->stats == NULL) {
+        return ESP_MEDIA_ERR_NOT_SUPPORT;
+    }
+    // Histograms are updated by worker threads without lock, snapshot may mix samples of adjacent frames
+    for (int i = 0; i < AV_RENDER_STREAM_MAX; i++) {
+        for (int j = 0; j < AV_RENDER_STAGE_MAX; j++) {
+            latency_hist_t *hist = &render->stats->hist[i][j];
+            av_render_latency_t *latency = &stats->stage[i][j];
+            latency->count = hist->total;
+            latency->p50 = latency_hist_percentile(hist, 50);
+            latency->p95 = latency_hist_percentile(hist, 95);
+            latency->p99 = latency_hist_percentile(hist, 99);
+            latency->max = latency_hist_max(hist);
+        }
+    }
+    return ESP_MEDIA_ERR_OK;
+}
+
+int av_render_trace_start(av_render_handle_t h, av_render_trace_cfg_t *cfg)
+{
+    av_render_t *render = (av_render_t *)h;
+    if (render == NULL || cfg == NULL) {
+        return ESP_MEDIA_ERR_INVALID_ARG;
+    }
+    media_lib_mutex_lock(render->api_lock, MEDIA_LIB_MAX_LOCK_TIME);
+    int ret = trace_start(render, cfg);
+    media_lib_mutex_unlock(render->api_lock);
+    return ret;
+}
+
+int av_render_trace_stop(av_render_handle_t h)
+{
+    av_render_t *render = (av_render_t *)h;
+    if (render == NULL) {
+        return ESP_MEDIA_ERR_INVALID_ARG;
+    }
+    media_lib_mutex_lock(render->api_lock, MEDIA_LIB_MAX_LOCK_TIME);
+    trace_stop(render);
+    media_lib_mutex_unlock(render->api_lock);
+    return ESP_MEDIA_ERR_OK;
+}
+
 void av_render_dump(av_render_handle_t h, uint8_t mask)
 {
-    render_dump_mask = mask;
+    static uint8_t dump_count = 0;
     ESP_LOGI(TAG, "Dump mask set to %x", mask);
     if (mask == 0) {
-        dump_data(AV_RENDER_DUMP_STOP_INDEX, NULL, 0);
+        av_render_trace_stop(h);
+        return;
     }
+    char file_name[32];
+    snprintf(file_name, sizeof(file_name), "/sdcard/avtrace%d.bin", dump_count);
+    dump_count = (dump_count + 1) % 10;
+    av_render_trace_cfg_t cfg = {
+        .mask = mask,
+        .ring_size = TRACE_DUMP_RING_SIZE,
+        .max_payload = TRACE_DUMP_RING_SIZE,
+        .file_path = file_name,
+    };
+    av_render_trace_start(h, &cfg);
 }
 
 int av_render_get_render_pts(av_render_handle_t h, uint32_t *out_pts)
@@ -2042,11 +3511,11 @@ int av_render_reset(av_render_handle_t h)
     // Wait for all thread to quit
     if (render->adec_res && render->adec_res->thread_res.thread) {
         wait_bits |= render->adec_res->thread_res.wait_bits;
-        send_msg_to_thread(&render->adec_res->thread_res, sizeof(av_render_audio_data_t), &msg);
+        send_msg_to_thread(&render->adec_res->thread_res, sizeof(av_render_adec_item_t), &msg);
     }
     if (render->vdec_res && render->vdec_res->thread_res.thread) {
         wait_bits |= render->vdec_res->thread_res.wait_bits;
-        send_msg_to_thread(&render->vdec_res->thread_res, sizeof(av_render_video_data_t), &msg);
+        send_msg_to_thread(&render->vdec_res->thread_res, sizeof(av_render_vdec_item_t), &msg);
     }
     if (render->a_render_res && render->a_render_res->thread_res.thread) {
         wait_bits |= render->a_render_res->thread_res.wait_bits;
@@ -2054,7 +3523,7 @@ int av_render_reset(av_render_handle_t h)
     }
     if (render->v_render_res && render->v_render_res->thread_res.thread) {
         wait_bits |= render->v_render_res->thread_res.wait_bits;
-        send_msg_to_thread(&render->v_render_res->thread_res, sizeof(av_render_video_frame_t), &msg);
+        send_msg_to_thread(&render->v_render_res->thread_res, sizeof(av_render_v_render_item_t), &msg);
     }
 
     if (render->adec_res && render->adec_res->thread_res.thread) {
@@ -2065,7 +3534,6 @@ int av_render_reset(av_render_handle_t h)
         media_lib_event_group_clr_bits(render->event_group, wait_bits);
     }
     ESP_LOGI(TAG, "Close done");
-    dump_data(AV_RENDER_DUMP_STOP_INDEX, NULL, 0);
     // Close decoder
     if (render->adec_res) {
         if (render->adec_res->adec) {
@@ -2090,10 +3558,18 @@ int av_render_reset(av_render_handle_t h)
             media_lib_free(vdec_res->vid_convert_out);
             vdec_res->vid_convert_out = NULL;
         }
+        video_fb_pool_destroy(vdec_res->fb_pool);
+        vdec_res->fb_pool = NULL;
         destroy_thread_res(&render->vdec_res->thread_res);
         media_lib_free(render->vdec_res);
         render->vdec_res = NULL;
     }
+    // Remove mixed streams, writers waiting for space get error
+    if (render->mixer) {
+        for (int i = 1; i <= AUDIO_MIXER_MAX_STREAMS; i++) {
+            audio_mixer_remove_stream(render->mixer, i);
+        }
+    }
     // close render resource
     if (render->a_render_res) {
         destroy_thread_res(&render->a_render_res->thread_res);
@@ -2101,6 +3577,13 @@ int av_render_reset(av_render_handle_t h)
             audio_resample_close(render->a_render_res->resample_handle);
             render->a_render_res->resample_handle = NULL;
         }
+        audio_catchup_deinit(&render->a_render_res->catchup);
+        if (render->a_render_res->mix_buf) {
+            media_lib_free(render->a_render_res->mix_buf);
+        }
+        if (render->a_render_res->plc.fade_buf) {
+            media_lib_free(render->a_render_res->plc.fade_buf);
+        }
         media_lib_free(render->a_render_res);
         render->a_render_res = NULL;
     }
@@ -2127,12 +3610,28 @@ int av_render_close(av_render_handle_t h)
         return ESP_MEDIA_ERR_INVALID_ARG;
     }
     av_render_reset(h);
+    mix_destroy(render);
+    if (render->trace) {
+        trace_stop(render);
+        trace_ring_destroy(render->trace->ring);
+        if (render->trace->exit_sema) {
+            media_lib_sema_destroy(render->trace->exit_sema);
+        }
+        media_lib_free(render->trace);
+    }
     if (render->event_group) {
         media_lib_event_group_destroy(render->event_group);
     }
     if (render->api_lock) {
         media_lib_mutex_destroy(render->api_lock);
     }
+    if (render->stats) {
+        media_lib_free(render->stats);
+    }
+    if (render->coop) {
+        media_lib_sema_destroy(render->coop->wake);
+        media_lib_free(render->coop);
+    }
     media_lib_free(render);
     return ESP_MEDIA_ERR_OK;
 }
@@ -34,83 +34,133 @@ extern void i420_to_rgb565le(uint8_t *in_image, uint8_t *out_image, int16_t widt
 #define COLOR_LIMIT(a) (a > 255 ? 255 : a < 0 ? 0 \
                                               : a)
 
-#define YUV2RO(C, D, E) COLOR_LIMIT((298 * (C) + 409 * (E) + 128) >> 8)
-#define YUV2GO(C, D, E) COLOR_LIMIT((298 * (C)-100 * (D)-208 * (E) + 128) >> 8)
-#define YUV2BO(C, D, E) COLOR_LIMIT((298 * (C) + 516 * (D) + 128) >> 8)
+// BT.601 limited range coefficients in Q8
+#define YUV_Y_COEF  (298)
+#define YUV_RV_COEF (409)
+#define YUV_GU_COEF (100)
+#define YUV_GV_COEF (208)
+#define YUV_BU_COEF (516)
+
 #define RGB565(r, g, b) (((((r) << 6) | (g)) << 5) | (b))
 
+// Table indexed by Y(6bits) U(5bits) V(5bits)
+#define YUV_TABLE_SIZE (64 * 32 * 32 * sizeof(uint16_t))
+
+// 128KB table does not fit in ESP32-S3 data cache, calculate per pixel instead
+#if CONFIG_IDF_TARGET_ESP32S3
+#define YUV_TABLE_DEFAULT (false)
+#else
+#define YUV_TABLE_DEFAULT (true)
+#endif
+
 typedef struct {
-    uint8_t                     *table;
     av_render_video_frame_type_t from;
     av_render_video_frame_type_t to;
     int                          width;
     int                          height;
+    int                          crop_x;
+    int                          crop_y;
+    int                          crop_width;
+    int                          crop_height;
+    int                          out_width;
+    int                          out_height;
+    color_convert_scale_t        scale;
+    int                          rotate;
+    bool                         direct;
+    uint16_t                    *table;
+    int32_t                     *x_pos;
 } color_convert_t;
 
-static int get_table_size(av_render_video_frame_type_t from, av_render_video_frame_type_t to)
+static inline uint16_t yuv_to_rgb565(int y, int rv, int guv, int bu)
 {
-    if (from == AV_RENDER_VIDEO_RAW_TYPE_YUV420 && to == AV_RENDER_VIDEO_RAW_TYPE_RGB565_BE) {
-        return 256 * 256 * 2;
-    }
-    if (from == AV_RENDER_VIDEO_RAW_TYPE_YUV420 && to == AV_RENDER_VIDEO_RAW_TYPE_RGB565) {
-        return 256 * 256 * 2;
-    }
-    return 0;
+    int c = YUV_Y_COEF * (y - 16);
+    int r = (c + rv) >> 8;
+    int g = (c + guv) >> 8;
+    int b = (c + bu) >> 8;
+    r = COLOR_LIMIT(r);
+    g = COLOR_LIMIT(g);
+    b = COLOR_LIMIT(b);
+    return (uint16_t)RGB565(r >> 3, g >> 2, b >> 3);
 }
 
-static int init_table(color_convert_t *convert)
+/**
+ * @brief  Convert two lines sharing same chroma line
+ *
+ * @note  Chroma terms are calculated once and reused for 4 pixels, no lookup table needed
+ *        `swap` and `step` are constant on normal call site so that compiler generate separate loop for LE and BE
+ *        `step` is distance in pixels between output columns, not 1 when output is rotated
+ */
+static inline void yuv420_line_pair_to_rgb565(const uint8_t *y0, const uint8_t *y1, const uint8_t *u, const uint8_t *v,
+                                              uint16_t *d0, uint16_t *d1, int width, int step, bool swap)
 {
-    uint16_t *table16 = (uint16_t *)convert->table;
-    if (convert->from == AV_RENDER_VIDEO_RAW_TYPE_YUV420 && convert->to == AV_RENDER_VIDEO_RAW_TYPE_RGB565_BE) {
-        for (int u0 = 0; u0 < 32; u0++) {
-            for (int v0 = 0; v0 < 32; v0++) {
-                for (int y0 = 0; y0 < 64; y0++) {
-                    int idx = (y0 << 10) + (u0 << 5) + v0;
-                    int y = (y0 << 2) + (y0 & 0x3);
-                    int u = (u0 << 3) + (y0 & 0x7);
-                    int v = (v0 << 3) + (v0 & 0x7);
-                    y -= 16;
-                    u -= 128;
-                    v -= 128;
-                    uint16_t r = (YUV2RO(y, u, v) >> 3) & 0x1f;
-                    uint16_t g = (YUV2GO(y, u, v) >> 2) & 0x3f;
-                    uint16_t b = (YUV2BO(y, u, v) >> 3) & 0x1f;
-                    table16[idx] = RGB565(r, g, b);
-                    table16[idx] = (table16[idx] >> 8) | (table16[idx] << 8);
-                }
-            }
+    int j = 0;
+    for (; j + 1 < width; j += 2) {
+        int cu = *(u++) - 128;
+        int cv = *(v++) - 128;
+        int rv = YUV_RV_COEF * cv + 128;
+        int guv = 128 - YUV_GU_COEF * cu - YUV_GV_COEF * cv;
+        int bu = YUV_BU_COEF * cu + 128;
+        uint16_t p00 = yuv_to_rgb565(y0[j], rv, guv, bu);
+        uint16_t p01 = yuv_to_rgb565(y0[j + 1], rv, guv, bu);
+        uint16_t p10 = yuv_to_rgb565(y1[j], rv, guv, bu);
+        uint16_t p11 = yuv_to_rgb565(y1[j + 1], rv, guv, bu);
+        if (swap) {
+            p00 = __builtin_bswap16(p00);
+            p01 = __builtin_bswap16(p01);
+            p10 = __builtin_bswap16(p10);
+            p11 = __builtin_bswap16(p11);
         }
+        d0[j * step] = p00;
+        d0[(j + 1) * step] = p01;
+        d1[j * step] = p10;
+        d1[(j + 1) * step] = p11;
     }
-    if (convert->from == AV_RENDER_VIDEO_RAW_TYPE_YUV420 && convert->to == AV_RENDER_VIDEO_RAW_TYPE_RGB565) {
+    if (j < width) {
+        // Last column of odd width
+        int cu = *u - 128;
+        int cv = *v - 128;
+        int rv = YUV_RV_COEF * cv + 128;
+        int guv = 128 - YUV_GU_COEF * cu - YUV_GV_COEF * cv;
+        int bu = YUV_BU_COEF * cu + 128;
+        uint16_t p0 = yuv_to_rgb565(y0[j], rv, guv, bu);
+        uint16_t p1 = yuv_to_rgb565(y1[j], rv, guv, bu);
+        d0[j * step] = swap ? __builtin_bswap16(p0) : p0;
+        d1[j * step] = swap ? __builtin_bswap16(p1) : p1;
+    }
+}
+
+static void init_table(color_convert_t *convert)
+{
+    bool swap = (convert->to == AV_RENDER_VIDEO_RAW_TYPE_RGB565_BE);
+    for (int y0 = 0; y0 < 64; y0++) {
         for (int u0 = 0; u0 < 32; u0++) {
             for (int v0 = 0; v0 < 32; v0++) {
-                for (int y0 = 0; y0 < 64; y0++) {
-                    int idx = (y0 << 10) + (u0 << 5) + v0;
-                    int y = (y0 << 2) + (y0 & 0x3);
-                    int u = (u0 << 3) + (y0 & 0x7);
-                    int v = (v0 << 3) + (v0 & 0x7);
-                    y -= 16;
-                    u -= 128;
-                    v -= 128;
-                    uint16_t r = (YUV2RO(y, u, v) >> 3) & 0x1f;
-                    uint16_t g = (YUV2GO(y, u, v) >> 2) & 0x3f;
-                    uint16_t b = (YUV2BO(y, u, v) >> 3) & 0x1f;
-                    table16[idx] = RGB565(r, g, b);
-                }
+                // Use middle of quantized range
+                int cu = (u0 << 3) + 4 - 128;
+                int cv = (v0 << 3) + 4 - 128;
+                int rv = YUV_RV_COEF * cv + 128;
+                int guv = 128 - YUV_GU_COEF * cu - YUV_GV_COEF * cv;
+                int bu = YUV_BU_COEF * cu + 128;
+                uint16_t p = yuv_to_rgb565((y0 << 2) + 2, rv, guv, bu);
+                convert->table[(y0 << 10) + (u0 << 5) + v0] = swap ? __builtin_bswap16(p) : p;
             }
         }
     }
-    return 0;
 }
 
 int convert_table_get_image_size(av_render_video_frame_type_t fmt, int width, int height)
 {
     switch (fmt) {
         case AV_RENDER_VIDEO_RAW_TYPE_YUV420:
-            return width * height * 3 / 2;
+        case AV_RENDER_VIDEO_RAW_TYPE_NV12:
+            // Chroma plane round up for odd size
+            return width * height + ((width + 1) >> 1) * ((height + 1) >> 1) * 2;
         case AV_RENDER_VIDEO_RAW_TYPE_RGB565:
         case AV_RENDER_VIDEO_RAW_TYPE_RGB565_BE:
+        case AV_RENDER_VIDEO_RAW_TYPE_YUYV:
             return width * height * 2;
+        case AV_RENDER_VIDEO_RAW_TYPE_RGB888:
+            return width * height * 3;
         default:
             ESP_LOGE(TAG, "Not supported format %d", fmt);
             break;
@@ -118,6 +168,34 @@ int convert_table_get_image_size(av_render_video_frame_type_t fmt, int width, in
     return 0;
 }
 
+static bool convert_supported(av_render_video_frame_type_t from, av_render_video_frame_type_t to)
+{
+    switch (from) {
+        case AV_RENDER_VIDEO_RAW_TYPE_YUV420:
+        case AV_RENDER_VIDEO_RAW_TYPE_NV12:
+        case AV_RENDER_VIDEO_RAW_TYPE_YUYV:
+        case AV_RENDER_VIDEO_RAW_TYPE_RGB888:
+        case AV_RENDER_VIDEO_RAW_TYPE_RGB565:
+        case AV_RENDER_VIDEO_RAW_TYPE_RGB565_BE:
+            break;
+        default:
+            return false;
+    }
+    return (to == AV_RENDER_VIDEO_RAW_TYPE_RGB565 || to == AV_RENDER_VIDEO_RAW_TYPE_RGB565_BE ||
+            to == AV_RENDER_VIDEO_RAW_TYPE_RGB888);
+}
+
+static inline int32_t get_scale_pos(color_convert_t *convert, int i, int src_len, int dst_len)
+{
+    // Map destination pixel center to source position in Q16
+    int32_t pos = (int32_t)(((int64_t)(2 * i + 1) * src_len << 16) / (2 * dst_len));
+    if (convert->scale == COLOR_CONVERT_SCALE_BILINEAR) {
+        pos -= (1 << 15);
+        return pos < 0 ? 0 : pos;
+    }
+    return pos & ~0xFFFF;
+}
+
 color_convert_table_t init_convert_table(color_convert_cfg_t *cfg)
 {
     color_convert_t *convert = (color_convert_t *)calloc(1, sizeof(color_convert_t));
@@ -125,56 +203,268 @@ color_convert_table_t init_convert_table(color_convert_cfg_t *cfg)
         if (convert == NULL) {
             break;
         }
+        if (convert_supported(cfg->from, cfg->to) == false) {
+            ESP_LOGE(TAG, "Not support convert from %d to %d", cfg->from, cfg->to);
+            break;
+        }
         convert->from = cfg->from;
         convert->to = cfg->to;
         convert->width = cfg->width;
         convert->height = cfg->height;
-#if CONFIG_IDF_TARGET_ESP32P4
-        if (convert->from == AV_RENDER_VIDEO_RAW_TYPE_YUV420 && convert->to == AV_RENDER_VIDEO_RAW_TYPE_RGB565) {
-            return (color_convert_table_t)convert;
+        convert->crop_x = cfg->crop_x;
+        convert->crop_y = cfg->crop_y;
+        convert->crop_width = cfg->crop_width ? cfg->crop_width : cfg->width - cfg->crop_x;
+        convert->crop_height = cfg->crop_height ? cfg->crop_height : cfg->height - cfg->crop_y;
+        convert->out_width = cfg->out_width ? cfg->out_width : convert->crop_width;
+        convert->out_height = cfg->out_height ? cfg->out_height : convert->crop_height;
+        convert->scale = cfg->scale;
+        convert->rotate = cfg->rotate;
+        if (convert->rotate != 0 && convert->rotate != 90 && convert->rotate != 180 && convert->rotate != 270) {
+            ESP_LOGE(TAG, "Not support rotate %d", convert->rotate);
+            break;
+        }
+        if (convert->crop_x < 0 || convert->crop_y < 0 || convert->crop_width <= 0 || convert->crop_height <= 0 ||
+            convert->crop_x + convert->crop_width > cfg->width || convert->crop_y + convert->crop_height > cfg->height ||
+            convert->out_width <= 0 || convert->out_height <= 0) {
+            ESP_LOGE(TAG, "Bad crop or output setting");
+            break;
         }
+        // Full frame YUV420 to RGB565 without scale use line pair converter, rotation done when writing output
+        if (convert->from == AV_RENDER_VIDEO_RAW_TYPE_YUV420 && convert->to != AV_RENDER_VIDEO_RAW_TYPE_RGB888 &&
+            convert->crop_width == cfg->width && convert->crop_height == cfg->height &&
+            convert->out_width == cfg->width && convert->out_height == cfg->height) {
+            convert->direct = true;
+            if (convert->rotate) {
+                return (color_convert_table_t)convert;
+            }
+#if CONFIG_IDF_TARGET_ESP32P4
+            if (convert->to == AV_RENDER_VIDEO_RAW_TYPE_RGB565) {
+                return (color_convert_table_t)convert;
+            }
 #endif
-        int table_size = get_table_size(cfg->from, cfg->to);
-        if (table_size) {
-            convert->table = (uint8_t *)malloc(table_size);
-            if (convert->table == NULL) {
-                break;
+            if (YUV_TABLE_DEFAULT && cfg->no_table == false) {
+                convert->table = (uint16_t *)malloc(YUV_TABLE_SIZE);
+                if (convert->table == NULL) {
+                    break;
+                }
+                init_table(convert);
             }
+            return (color_convert_table_t)convert;
+        }
+        convert->x_pos = (int32_t *)malloc(convert->out_width * sizeof(int32_t));
+        if (convert->x_pos == NULL) {
+            break;
+        }
+        for (int i = 0; i < convert->out_width; i++) {
+            convert->x_pos[i] = get_scale_pos(convert, i, convert->crop_width, convert->out_width);
         }
-        init_table(convert);
         return (color_convert_table_t)convert;
     } while (0);
     deinit_convert_table(convert);
     return NULL;
 }
 
-static void yuv420_to_rgb565(color_convert_t *convert, uint8_t *src, uint8_t *dst)
+static void yuv420_to_rgb565_table(color_convert_t *convert, uint8_t *src, uint8_t *dst)
 {
+    int width = convert->width;
+    int uv_width = (width + 1) >> 1;
     uint8_t *y_plane = src;
-    uint8_t *u_plane = src + (convert->width * convert->height);
-    uint8_t *v_plane = src + (convert->width * convert->height * 5 / 4);
-    int y_pos = 0, u_pos = 0, rgb_idx = 0;
+    uint8_t *u_plane = src + width * convert->height;
+    uint8_t *v_plane = u_plane + uv_width * ((convert->height + 1) >> 1);
     uint16_t *rgb565 = (uint16_t *)dst;
-    uint16_t *table16 = (uint16_t *)convert->table;
+    uint16_t *table16 = convert->table;
     for (int i = 0; i < convert->height; i++) {
-        for (int j = 0; j < convert->width; j += 2) {
-            int y = y_plane[y_pos];
-            int u = u_plane[u_pos];
-            int v = v_plane[u_pos];
-            int y_idx = (y >> 2) << 10;
-            int uv_idx = ((u >> 3) << 5) + (v >> 3);
+        for (int j = 0; j < width; j += 2) {
+            int uv_idx = ((u_plane[j >> 1] >> 3) << 5) + (v_plane[j >> 1] >> 3);
+            rgb565[j] = table16[((y_plane[j] >> 2) << 10) + uv_idx];
+            if (j + 1 < width) {
+                rgb565[j + 1] = table16[((y_plane[j + 1] >> 2) << 10) + uv_idx];
+            }
+        }
+        y_plane += width;
+        rgb565 += width;
+        // Chroma line shared by two lines
+        if (i & 1) {
+            u_plane += uv_width;
+            v_plane += uv_width;
+        }
+    }
+}
 
-            rgb565[rgb_idx++] = table16[y_idx + uv_idx];
+/**
+ * @brief  Get output layout for rotation
+ *
+ * @note  Output pixel (i, j) is written to base + i * row_step + j * col_step (in pixels)
+ */
+static void get_rotate_layout(color_convert_t *convert, int *base, int *row_step, int *col_step)
+{
+    int ow = convert->out_width;
+    int oh = convert->out_height;
+    switch (convert->rotate) {
+        case 90:
+            *base = oh - 1;
+            *row_step = -1;
+            *col_step = oh;
+            break;
+        case 180:
+            *base = ow * oh - 1;
+            *row_step = -ow;
+            *col_step = -1;
+            break;
+        case 270:
+            *base = (ow - 1) * oh;
+            *row_step = 1;
+            *col_step = -oh;
+            break;
+        default:
+            *base = 0;
+            *row_step = ow;
+            *col_step = 1;
+            break;
+    }
+}
 
-            y = y_plane[y_pos + 1];
-            y_idx = (y >> 2) << 10;
-            rgb565[rgb_idx++] = table16[y_idx + uv_idx];
-            y_pos += 2;
-            u_pos++;
+static void yuv420_to_rgb565(color_convert_t *convert, uint8_t *src, uint8_t *dst, bool swap)
+{
+    int width = convert->width;
+    int uv_width = (width + 1) >> 1;
+    uint8_t *y_plane = src;
+    uint8_t *u_plane = src + width * convert->height;
+    uint8_t *v_plane = u_plane + uv_width * ((convert->height + 1) >> 1);
+    int base, row_step, col_step;
+    get_rotate_layout(convert, &base, &row_step, &col_step);
+    uint16_t *rgb565 = (uint16_t *)dst + base;
+    for (int i = 0; i < convert->height; i += 2) {
+        // Last line of odd height convert with itself as pair
+        bool pair = (i + 1 < convert->height);
+        uint8_t *y_next = pair ? y_plane + width : y_plane;
+        uint16_t *d_next = pair ? rgb565 + row_step : rgb565;
+        if (col_step != 1) {
+            yuv420_line_pair_to_rgb565(y_plane, y_next, u_plane, v_plane, rgb565, d_next, width, col_step, swap);
+        } else if (swap) {
+            yuv420_line_pair_to_rgb565(y_plane, y_next, u_plane, v_plane, rgb565, d_next, width, 1, true);
+        } else {
+            yuv420_line_pair_to_rgb565(y_plane, y_next, u_plane, v_plane, rgb565, d_next, width, 1, false);
         }
-        // odd line not increase
-        if ((i & 1) == 0) {
-            u_pos -= convert->width >> 1;
+        y_plane += width * 2;
+        rgb565 += row_step * 2;
+        u_plane += uv_width;
+        v_plane += uv_width;
+    }
+}
+
+static inline int lerp_q8(int a, int b, int f)
+{
+    return a + (((b - a) * f + 128) >> 8);
+}
+
+static inline void rgb565_unpack(uint16_t p, bool swap, int *r, int *g, int *b)
+{
+    if (swap) {
+        p = __builtin_bswap16(p);
+    }
+    *r = ((p >> 11) & 0x1F) * 255 / 31;
+    *g = ((p >> 5) & 0x3F) * 255 / 63;
+    *b = (p & 0x1F) * 255 / 31;
+}
+
+static inline void get_rgb(color_convert_t *convert, uint8_t *src, int x0, int x1, int fx, int y0, int y1, int fy,
+                           int *r, int *g, int *b)
+{
+    int w = convert->width;
+    int h = convert->height;
+    int uv_w = (w + 1) >> 1;
+    switch (convert->from) {
+        case AV_RENDER_VIDEO_RAW_TYPE_RGB888: {
+            uint8_t *p00 = src + (y0 * w + x0) * 3, *p01 = src + (y0 * w + x1) * 3;
+            uint8_t *p10 = src + (y1 * w + x0) * 3, *p11 = src + (y1 * w + x1) * 3;
+            *r = lerp_q8(lerp_q8(p00[0], p01[0], fx), lerp_q8(p10[0], p11[0], fx), fy);
+            *g = lerp_q8(lerp_q8(p00[1], p01[1], fx), lerp_q8(p10[1], p11[1], fx), fy);
+            *b = lerp_q8(lerp_q8(p00[2], p01[2], fx), lerp_q8(p10[2], p11[2], fx), fy);
+            return;
+        }
+        case AV_RENDER_VIDEO_RAW_TYPE_RGB565:
+        case AV_RENDER_VIDEO_RAW_TYPE_RGB565_BE: {
+            // Low bit depth source, nearest sample is enough
+            uint16_t *p = (uint16_t *)src + (fy < 128 ? y0 : y1) * w + (fx < 128 ? x0 : x1);
+            rgb565_unpack(*p, convert->from == AV_RENDER_VIDEO_RAW_TYPE_RGB565_BE, r, g, b);
+            return;
+        }
+        default:
+            break;
+    }
+    // YUV source: interpolate luma, chroma take nearest sample on its own grid
+    int y00, y01, y10, y11, u, v;
+    int cx = x0 >> 1, cy = y0 >> 1;
+    if (convert->from == AV_RENDER_VIDEO_RAW_TYPE_YUYV) {
+        uint8_t *l0 = src + y0 * w * 2, *l1 = src + y1 * w * 2;
+        y00 = l0[x0 * 2];
+        y01 = l0[x1 * 2];
+        y10 = l1[x0 * 2];
+        y11 = l1[x1 * 2];
+        u = l0[cx * 4 + 1];
+        v = l0[cx * 4 + 3];
+    } else {
+        uint8_t *l0 = src + y0 * w, *l1 = src + y1 * w;
+        y00 = l0[x0];
+        y01 = l0[x1];
+        y10 = l1[x0];
+        y11 = l1[x1];
+        if (convert->from == AV_RENDER_VIDEO_RAW_TYPE_NV12) {
+            uint8_t *uv = src + w * h + cy * uv_w * 2 + cx * 2;
+            u = uv[0];
+            v = uv[1];
+        } else {
+            u = src[w * h + cy * uv_w + cx];
+            v = src[w * h + uv_w * ((h + 1) >> 1) + cy * uv_w + cx];
+        }
+    }
+    int y = lerp_q8(lerp_q8(y00, y01, fx), lerp_q8(y10, y11, fx), fy);
+    int c = YUV_Y_COEF * (y - 16);
+    u -= 128;
+    v -= 128;
+    *r = (c + YUV_RV_COEF * v + 128) >> 8;
+    *g = (c - YUV_GU_COEF * u - YUV_GV_COEF * v + 128) >> 8;
+    *b = (c + YUV_BU_COEF * u + 128) >> 8;
+    *r = COLOR_LIMIT(*r);
+    *g = COLOR_LIMIT(*g);
+    *b = COLOR_LIMIT(*b);
+}
+
+static void convert_scale(color_convert_t *convert, uint8_t *src, uint8_t *dst)
+{
+    int max_x = convert->crop_x + convert->crop_width - 1;
+    int max_y = convert->crop_y + convert->crop_height - 1;
+    int ow = convert->out_width;
+    int oh = convert->out_height;
+    int bpp = (convert->to == AV_RENDER_VIDEO_RAW_TYPE_RGB888) ? 3 : 2;
+    // Rotation done in same pass
+    int base, row_step, col_step;
+    get_rotate_layout(convert, &base, &row_step, &col_step);
+    col_step *= bpp;
+    for (int i = 0; i < oh; i++) {
+        int32_t pos = get_scale_pos(convert, i, convert->crop_height, oh);
+        int y0 = convert->crop_y + (pos >> 16);
+        int y1 = y0 < max_y ? y0 + 1 : y0;
+        int fy = (pos >> 8) & 0xFF;
+        uint8_t *out = dst + (base + i * row_step) * bpp;
+        for (int j = 0; j < ow; j++, out += col_step) {
+            int x0 = convert->crop_x + (convert->x_pos[j] >> 16);
+            int x1 = x0 < max_x ? x0 + 1 : x0;
+            int fx = (convert->x_pos[j] >> 8) & 0xFF;
+            int r, g, b;
+            get_rgb(convert, src, x0, x1, fx, y0, y1, fy, &r, &g, &b);
+            if (bpp == 3) {
+                out[0] = (uint8_t)r;
+                out[1] = (uint8_t)g;
+                out[2] = (uint8_t)b;
+            } else {
+                uint16_t p = (uint16_t)RGB565(r >> 3, g >> 2, b >> 3);
+                if (convert->to == AV_RENDER_VIDEO_RAW_TYPE_RGB565_BE) {
+                    p = __builtin_bswap16(p);
+                }
+                *(uint16_t *)out = p;
+            }
         }
     }
 }
@@ -182,36 +472,31 @@ static void yuv420_to_rgb565(color_convert_t *convert, uint8_t *src, uint8_t *ds
 int convert_color(color_convert_table_t table, uint8_t *src, int src_size, uint8_t *dst, int dst_size)
 {
     color_convert_t *convert = (color_convert_t *)table;
-    if (convert->from == AV_RENDER_VIDEO_RAW_TYPE_YUV420 && convert->to == AV_RENDER_VIDEO_RAW_TYPE_RGB565) {
+    if (convert == NULL) {
+        return -1;
+    }
+    int src_need = convert_table_get_image_size(convert->from, convert->width, convert->height);
+    int dst_need = convert_table_get_image_size(convert->to, convert->out_width, convert->out_height);
+    if (src_size < src_need || dst_size < dst_need) {
+        ESP_LOGE(TAG, "size dismatch");
+        return -1;
+    }
+    if (convert->direct) {
 #if CONFIG_IDF_TARGET_ESP32P4
-        i420_to_rgb565le(src, dst, convert->width, convert->height);
-        return 0;
+        if (convert->to == AV_RENDER_VIDEO_RAW_TYPE_RGB565 && convert->rotate == 0) {
+            i420_to_rgb565le(src, dst, convert->width, convert->height);
+            return 0;
+        }
 #endif
+        if (convert->table) {
+            yuv420_to_rgb565_table(convert, src, dst);
+        } else {
+            yuv420_to_rgb565(convert, src, dst, convert->to == AV_RENDER_VIDEO_RAW_TYPE_RGB565_BE);
+        }
+        return 0;
     }
-    
-    switch (convert->from) {
-        case AV_RENDER_VIDEO_RAW_TYPE_YUV420: {
-            int src_need = convert->width * convert->height * 3 / 2;
-            int dst_need = convert->width * convert->height * 2;
-            if (src_size != src_need || dst_size < dst_need) {
-                ESP_LOGE(TAG, "size dismatch");
-                return -1;
-            }
-            switch (convert->to) {
-                case AV_RENDER_VIDEO_RAW_TYPE_RGB565:
-                case AV_RENDER_VIDEO_RAW_TYPE_RGB565_BE:
-                    yuv420_to_rgb565(convert, src, dst);
-                    break;
-                default:
-                    ESP_LOGE(TAG, "Bad format to %d", convert->to);
-                    return -1;
-            }
-        } break;
-        default:
-            ESP_LOGE(TAG, "Bad format from %d", convert->from);
-            *(int *)0 = 0;
-            return -1;
-    }
+    // Crop, scale and color convert in one pass
+    convert_scale(convert, src, dst);
     return 0;
 }
 
@@ -219,9 +504,11 @@ void deinit_convert_table(color_convert_table_t t)
 {
     color_convert_t *convert = (color_convert_t *)t;
     if (convert) {
+        if (convert->x_pos) {
+            free(convert->x_pos);
+        }
         if (convert->table) {
             free(convert->table);
-            convert->table = NULL;
         }
         free(convert);
     }
@@ -29,11 +29,25 @@
 
 typedef void *color_convert_table_t;
 
+typedef enum {
+    COLOR_CONVERT_SCALE_NEAREST,
+    COLOR_CONVERT_SCALE_BILINEAR,
+} color_convert_scale_t;
+
 typedef struct {
     av_render_video_frame_type_t from;
     av_render_video_frame_type_t to;
     int                          width;
     int                          height;
+    int                          crop_x;      // Crop region in source, crop size 0 means to the frame end
+    int                          crop_y;
+    int                          crop_width;
+    int                          crop_height;
+    int                          out_width;   // Output size, 0 means same as crop size
+    int                          out_height;
+    color_convert_scale_t        scale;
+    int                          rotate;      // Clockwise rotation degree applied to output: 0, 90, 180, 270
+    bool                         no_table;    // Calculate YUV420 to RGB565 per pixel instead of using 128KB lookup table, always on ESP32-S3
 } color_convert_cfg_t;
 
 int convert_table_get_image_size(av_render_video_frame_type_t fmt, int width, int height);
@@ -0,0 +1,99 @@
+/**
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2025 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <string.h>
+#include "latency_hist.h"
+
+static int value_to_bucket(uint32_t v)
+{
+    if (v < (1 << LATENCY_HIST_SUB_BITS)) {
+        return (int)v;
+    }
+    int msb = 31 - __builtin_clz(v);
+    int sub = (v >> (msb - LATENCY_HIST_SUB_BITS)) & ((1 << LATENCY_HIST_SUB_BITS) - 1);
+    int idx = ((msb - LATENCY_HIST_SUB_BITS + 1) << LATENCY_HIST_SUB_BITS) + sub;
+    return idx < LATENCY_HIST_BUCKETS ? idx : LATENCY_HIST_BUCKETS - 1;
+}
+
+static uint32_t bucket_to_value(int idx)
+{
+    if (idx < (1 << LATENCY_HIST_SUB_BITS)) {
+        return (uint32_t)idx;
+    }
+    int shift = (idx >> LATENCY_HIST_SUB_BITS) - 1;
+    int sub = idx & ((1 << LATENCY_HIST_SUB_BITS) - 1);
+    uint32_t low = (uint32_t)((1 << LATENCY_HIST_SUB_BITS) + sub) << shift;
+    // Report center of bucket
+    return low + ((1u << shift) >> 1);
+}
+
+void latency_hist_add(latency_hist_t *hist, uint32_t us)
+{
+    if (hist->total >= LATENCY_HIST_WINDOW) {
+        uint16_t total = 0;
+        for (int i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+            hist->count[i] >>= 1;
+            total += hist->count[i];
+        }
+        hist->total = total;
+    }
+    hist->count[value_to_bucket(us)]++;
+    hist->total++;
+}
+
+uint32_t latency_hist_percentile(latency_hist_t *hist, int percent)
+{
+    uint32_t total = hist->total;
+    if (total == 0) {
+        return 0;
+    }
+    uint32_t target = (total * percent + 99) / 100;
+    if (target == 0) {
+        target = 1;
+    }
+    uint32_t acc = 0;
+    for (int i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        acc += hist->count[i];
+        if (acc >= target) {
+            return bucket_to_value(i);
+        }
+    }
+    return bucket_to_value(LATENCY_HIST_BUCKETS - 1);
+}
+
+uint32_t latency_hist_max(latency_hist_t *hist)
+{
+    for (int i = LATENCY_HIST_BUCKETS - 1; i >= 0; i--) {
+        if (hist->count[i]) {
+            return bucket_to_value(i);
+        }
+    }
+    return 0;
+}
+
+void latency_hist_reset(latency_hist_t *hist)
+{
+    memset(hist, 0, sizeof(latency_hist_t));
+}
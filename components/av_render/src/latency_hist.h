@@ -0,0 +1,51 @@
+/**
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2025 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef LATENCY_HIST_H
+#define LATENCY_HIST_H
+
+#include <stdint.h>
+
+// Log-linear buckets, 4 sub-buckets per power of two, covering 0us to about 16s
+#define LATENCY_HIST_SUB_BITS    (2)
+#define LATENCY_HIST_BUCKETS     (96)
+// Halve all counts once window is full so that old samples decay
+#define LATENCY_HIST_WINDOW      (1024)
+
+typedef struct {
+    uint16_t count[LATENCY_HIST_BUCKETS];
+    uint16_t total;
+} latency_hist_t;
+
+void latency_hist_add(latency_hist_t *hist, uint32_t us);
+
+// Get latency value (unit us) at percent (0-100) of samples in window
+uint32_t latency_hist_percentile(latency_hist_t *hist, int percent);
+
+uint32_t latency_hist_max(latency_hist_t *hist);
+
+void latency_hist_reset(latency_hist_t *hist);
+
+#endif
@@ -0,0 +1,152 @@
+/**
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2025 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <string.h>
+#include "media_lib_os.h"
+#include "media_lib_atomic.h"
+#include "trace_ring.h"
+
+// Slot header word: low 24 bits slot size include header, high bits flags
+#define SLOT_SIZE_MASK  (0xFFFFFF)
+#define SLOT_COMMITTED  (1u << 31)
+#define SLOT_PADDING    (1u << 30)
+#define SLOT_HEAD_SIZE  (sizeof(uint32_t))
+#define SLOT_ALIGN(n)   (((n) + 3) & ~3)
+
+struct trace_ring_t {
+    uint8_t *buffer;
+    uint32_t size;
+    uint32_t head;  // Reserved position, increase only
+    uint32_t tail;  // Read position, only changed by consumer
+    uint32_t dropped;
+};
+
+static inline uint32_t *slot_head(trace_ring_t *ring, uint32_t pos)
+{
+    return (uint32_t *)(ring->buffer + (pos & (ring->size - 1)));
+}
+
+trace_ring_t *trace_ring_create(uint32_t size)
+{
+    uint32_t ring_size = 1024;
+    while (ring_size < size && ring_size < SLOT_SIZE_MASK) {
+        ring_size <<= 1;
+    }
+    trace_ring_t *ring = (trace_ring_t *)media_lib_calloc(1, sizeof(trace_ring_t));
+    if (ring == NULL) {
+        return NULL;
+    }
+    // Header words must start cleared so that unwritten slot not treat as committed
+    ring->buffer = (uint8_t *)media_lib_calloc(1, ring_size);
+    if (ring->buffer == NULL) {
+        media_lib_free(ring);
+        return NULL;
+    }
+    ring->size = ring_size;
+    return ring;
+}
+
+int trace_ring_max_record(trace_ring_t *ring)
+{
+    // Keep record small compared to ring so that reserve not fail due to padding
+    return ring->size / 4 - SLOT_HEAD_SIZE;
+}
+
+int trace_ring_write(trace_ring_t *ring, const void *head, int head_size, const void *payload, int payload_size)
+{
+    uint32_t len = SLOT_ALIGN(SLOT_HEAD_SIZE + head_size + payload_size);
+    if (head_size + payload_size > trace_ring_max_record(ring)) {
+        return -1;
+    }
+    uint32_t pos, pad, next;
+    do {
+        pos = MEDIA_LIB_ATOMIC_LOAD_ACQ(ring->head);
+        uint32_t offset = pos & (ring->size - 1);
+        // Record never wraps, skip rest of ring with padding slot
+        pad = (offset + len > ring->size) ? ring->size - offset : 0;
+        next = pos + pad + len;
+        if (next - MEDIA_LIB_ATOMIC_LOAD_ACQ(ring->tail) > ring->size) {
+            MEDIA_LIB_ATOMIC_ADD_RELAXED(ring->dropped, 1);
+            return -1;
+        }
+    } while (!MEDIA_LIB_ATOMIC_CAS_ACQ_REL(ring->head, pos, next));
+    if (pad) {
+        MEDIA_LIB_ATOMIC_STORE_REL(*slot_head(ring, pos), pad | SLOT_PADDING | SLOT_COMMITTED);
+        pos += pad;
+    }
+    uint8_t *data = (uint8_t *)slot_head(ring, pos) + SLOT_HEAD_SIZE;
+    memcpy(data, head, head_size);
+    if (payload_size) {
+        memcpy(data + head_size, payload, payload_size);
+    }
+    // Publish record, consumer stop at first slot not committed
+    MEDIA_LIB_ATOMIC_STORE_REL(*slot_head(ring, pos), (SLOT_HEAD_SIZE + head_size + payload_size) | SLOT_COMMITTED);
+    return 0;
+}
+
+int trace_ring_read(trace_ring_t *ring, uint8_t *buf, int size)
+{
+    while (1) {
+        uint32_t pos = ring->tail;
+        if (pos == MEDIA_LIB_ATOMIC_LOAD_ACQ(ring->head)) {
+            return 0;
+        }
+        uint32_t *slot = slot_head(ring, pos);
+        uint32_t word = MEDIA_LIB_ATOMIC_LOAD_ACQ(*slot);
+        if ((word & SLOT_COMMITTED) == 0) {
+            // Reserved but producer still writing
+            return 0;
+        }
+        uint32_t len = word & SLOT_SIZE_MASK;
+        int record_size = 0;
+        if ((word & SLOT_PADDING) == 0) {
+            record_size = len - SLOT_HEAD_SIZE;
+            if (record_size > size) {
+                record_size = size;
+            }
+            memcpy(buf, (uint8_t *)slot + SLOT_HEAD_SIZE, record_size);
+            len = SLOT_ALIGN(len);
+        }
+        // Clear whole slot before release space, any position may become next slot header
+        memset(slot, 0, len);
+        MEDIA_LIB_ATOMIC_STORE_REL(ring->tail, pos + len);
+        if (record_size) {
+            return record_size;
+        }
+    }
+}
+
+uint32_t trace_ring_get_dropped(trace_ring_t *ring)
+{
+    return MEDIA_LIB_ATOMIC_LOAD_ACQ(ring->dropped);
+}
+
+void trace_ring_destroy(trace_ring_t *ring)
+{
+    if (ring) {
+        media_lib_free(ring->buffer);
+        media_lib_free(ring);
+    }
+}
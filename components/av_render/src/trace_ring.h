@@ -0,0 +1,52 @@
+/**
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2025 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef TRACE_RING_H
+#define TRACE_RING_H
+
+#include <stdint.h>
+
+// Lock-free ring for variable size records, multiple producers and single consumer
+// Producers reserve space by compare and swap then commit record, never wait
+// Record dropped when ring full so that producer timing not affected
+typedef struct trace_ring_t trace_ring_t;
+
+// Size rounded up to power of two
+trace_ring_t *trace_ring_create(uint32_t size);
+
+// Largest record can be written, payload should be truncated to fit
+int trace_ring_max_record(trace_ring_t *ring);
+
+// Write record composed by head and payload, return -1 if no space
+int trace_ring_write(trace_ring_t *ring, const void *head, int head_size, const void *payload, int payload_size);
+
+// Copy out next committed record, return record size, 0 if no record ready
+int trace_ring_read(trace_ring_t *ring, uint8_t *buf, int size);
+
+uint32_t trace_ring_get_dropped(trace_ring_t *ring);
+
+void trace_ring_destroy(trace_ring_t *ring);
+
+#endif
@@ -0,0 +1,168 @@
+/**
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2025 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "media_lib_os.h"
+#include "media_lib_atomic.h"
+#include "video_fb_pool.h"
+
+typedef struct {
+    uint8_t *data;
+    uint32_t ref;
+} video_fb_t;
+
+typedef struct video_fb_pool_t {
+    video_fb_t             *fb;
+    int                     num;
+    int                     size;
+    media_lib_sema_handle_t free_sema;
+    uint32_t                owner;  // Destroy and every buffer in use hold one reference
+    bool                    destroying;
+} video_fb_pool_t;
+
+static void pool_release(video_fb_pool_t *pool)
+{
+    for (int i = 0; i < pool->num; i++) {
+        if (pool->fb[i].data) {
+            media_lib_free_align(pool->fb[i].data);
+        }
+    }
+    if (pool->free_sema) {
+        media_lib_sema_destroy(pool->free_sema);
+    }
+    media_lib_free(pool->fb);
+    media_lib_free(pool);
+}
+
+static void pool_put(video_fb_pool_t *pool)
+{
+    if (MEDIA_LIB_ATOMIC_SUB_ACQ_REL(pool->owner, 1) == 0) {
+        pool_release(pool);
+    }
+}
+
+static video_fb_t *pool_find(video_fb_pool_t *pool, uint8_t *data)
+{
+    if (data == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < pool->num; i++) {
+        if (pool->fb[i].data == data) {
+            return &pool->fb[i];
+        }
+    }
+    return NULL;
+}
+
+video_fb_pool_handle_t video_fb_pool_create(int num, int size, uint8_t align)
+{
+    video_fb_pool_t *pool = (video_fb_pool_t *)media_lib_calloc(1, sizeof(video_fb_pool_t));
+    if (pool == NULL) {
+        return NULL;
+    }
+    if (align == 0) {
+        align = 4;
+    }
+    pool->num = num;
+    pool->size = size;
+    pool->owner = 1;
+    pool->fb = (video_fb_t *)media_lib_calloc(num, sizeof(video_fb_t));
+    media_lib_sema_create(&pool->free_sema);
+    if (pool->fb == NULL || pool->free_sema == NULL) {
+        pool_release(pool);
+        return NULL;
+    }
+    for (int i = 0; i < num; i++) {
+        pool->fb[i].data = (uint8_t *)media_lib_malloc_align(size, align);
+        if (pool->fb[i].data == NULL) {
+            pool_release(pool);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+uint8_t *video_fb_pool_acquire(video_fb_pool_handle_t pool, uint32_t timeout)
+{
+    if (pool == NULL) {
+        return NULL;
+    }
+    while (MEDIA_LIB_ATOMIC_LOAD_ACQ(pool->destroying) == false) {
+        for (int i = 0; i < pool->num; i++) {
+            uint32_t free_ref = 0;
+            // Only acquire path change reference from 0, compare and swap avoid lock with release path
+            if (MEDIA_LIB_ATOMIC_CAS_ACQ_REL(pool->fb[i].ref, free_ref, 1)) {
+                MEDIA_LIB_ATOMIC_ADD_ACQ_REL(pool->owner, 1);
+                return pool->fb[i].data;
+            }
+        }
+        if (media_lib_sema_lock(pool->free_sema, timeout) != 0) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+bool video_fb_pool_ref(video_fb_pool_handle_t pool, uint8_t *data)
+{
+    video_fb_t *fb = pool ? pool_find(pool, data) : NULL;
+    if (fb == NULL) {
+        return false;
+    }
+    MEDIA_LIB_ATOMIC_ADD_ACQ_REL(fb->ref, 1);
+    return true;
+}
+
+bool video_fb_pool_unref(video_fb_pool_handle_t pool, uint8_t *data)
+{
+    video_fb_t *fb = pool ? pool_find(pool, data) : NULL;
+    if (fb == NULL || MEDIA_LIB_ATOMIC_LOAD_ACQ(fb->ref) == 0) {
+        return false;
+    }
+    if (MEDIA_LIB_ATOMIC_SUB_ACQ_REL(fb->ref, 1) == 0) {
+        media_lib_sema_unlock(pool->free_sema);
+        pool_put(pool);
+    }
+    return true;
+}
+
+bool video_fb_pool_contains(video_fb_pool_handle_t pool, uint8_t *data)
+{
+    return pool && pool_find(pool, data);
+}
+
+int video_fb_pool_get_size(video_fb_pool_handle_t pool)
+{
+    return pool ? pool->size : 0;
+}
+
+void video_fb_pool_destroy(video_fb_pool_handle_t pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+    MEDIA_LIB_ATOMIC_STORE_REL(pool->destroying, true);
+    media_lib_sema_unlock(pool->free_sema);
+    pool_put(pool);
+}
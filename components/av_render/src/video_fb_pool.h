@@ -0,0 +1,55 @@
+/**
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2025 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef VIDEO_FB_POOL_H
+#define VIDEO_FB_POOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Fixed number of aligned frame buffers shared by decoder and render thread
+// Each buffer is reference counted, buffer goes back to pool when last reference released
+// Pool itself is released after destroyed and all buffers returned
+typedef struct video_fb_pool_t *video_fb_pool_handle_t;
+
+video_fb_pool_handle_t video_fb_pool_create(int num, int size, uint8_t align);
+
+// Get free buffer with one reference, wait up to timeout (unit ms) when all buffers in use
+uint8_t *video_fb_pool_acquire(video_fb_pool_handle_t pool, uint32_t timeout);
+
+// Add reference to buffer, return false if buffer not belong to pool
+bool video_fb_pool_ref(video_fb_pool_handle_t pool, uint8_t *data);
+
+// Release reference of buffer, return false if buffer not belong to pool
+bool video_fb_pool_unref(video_fb_pool_handle_t pool, uint8_t *data);
+
+bool video_fb_pool_contains(video_fb_pool_handle_t pool, uint8_t *data);
+
+int video_fb_pool_get_size(video_fb_pool_handle_t pool);
+
+// Wake up waiting acquire and drop pool ownership
+void video_fb_pool_destroy(video_fb_pool_handle_t pool);
+
+#endif
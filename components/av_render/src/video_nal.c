@@ -0,0 +1,98 @@
+/**
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2025 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "video_nal.h"
+
+#define NAL_UNIT_TYPE_NON_IDR 1
+#define NAL_UNIT_TYPE_IDR     5
+
+static int get_start_code_len(uint8_t *data, int size)
+{
+    if (size < 3 || data[0] != 0 || data[1] != 0) {
+        return 0;
+    }
+    if (data[2] == 1) {
+        return 3;
+    }
+    if (size > 3 && data[2] == 0 && data[3] == 1) {
+        return 4;
+    }
+    return 0;
+}
+
+static int h264_parse(uint8_t *data, int size, video_nal_info_t *info)
+{
+    bool find_slice = false;
+    for (int i = 0; i < size - 3; i++) {
+        int start_code_len = get_start_code_len(data + i, size - i);
+        if (start_code_len == 0) {
+            continue;
+        }
+        i += start_code_len;
+        if (i >= size) {
+            break;
+        }
+        uint8_t nal_type = data[i] & 0x1F;
+        uint8_t nal_ref_idc = (data[i] >> 5) & 0x3;
+        if (nal_type == NAL_UNIT_TYPE_IDR) {
+            info->key_frame = true;
+            info->reference = true;
+            return 0;
+        }
+        if (nal_type == NAL_UNIT_TYPE_NON_IDR) {
+            // Frame is non-reference only when all slices have zero nal_ref_idc
+            if (find_slice == false) {
+                info->reference = false;
+                find_slice = true;
+            }
+            if (nal_ref_idc) {
+                // One referenced slice makes whole frame reference, no need to scan rest
+                info->reference = true;
+                return 0;
+            }
+        }
+    }
+    return find_slice ? 0 : -1;
+}
+
+int video_nal_parse(av_render_video_codec_t codec, uint8_t *data, int size, video_nal_info_t *info)
+{
+    info->key_frame = false;
+    info->reference = true;
+    if (data == NULL || size == 0) {
+        return -1;
+    }
+    switch (codec) {
+        case AV_RENDER_VIDEO_CODEC_H264:
+            return h264_parse(data, size, info);
+        case AV_RENDER_VIDEO_CODEC_MJPEG:
+            // Each picture is coded independently
+            info->key_frame = true;
+            info->reference = false;
+            return 0;
+        default:
+            return -1;
+    }
+}
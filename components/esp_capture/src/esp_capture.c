@@ -49,6 +49,7 @@
 #define EVENT_GROUP_MUXER_EXITED     (4)
 
 #define MAX_Q_SIZE (5)
+#define MUXER_RECV_BATCH_NUM (4)
 
 // Here hacking to use stream type to indicate start/stop command
 #define START_CMD_STREAM_TYPE  (esp_capture_stream_type_t)0x10
@@ -246,48 +247,64 @@ static int open_muxer(capture_path_t *path)
     return ret;
 }
 
+static void muxer_add_frame(capture_path_t *path, esp_capture_stream_frame_t *frame, bool drop)
+{
+    switch (frame->stream_type) {
+        case ESP_CAPTURE_STREAM_TYPE_AUDIO: {
+            if (drop == false) {
+                esp_muxer_audio_packet_t audio_packet = {
+                    .pts = frame->pts,
+                    .data = frame->data,
+                    .len = frame->size,
+                };
+                path->muxer_cur_pts = frame->pts;
+                esp_muxer_add_audio_packet(path->muxer, path->audio_stream_idx, &audio_packet);
+            }
+            share_q_release(path->audio_share_q, frame);
+        } break;
+        case ESP_CAPTURE_STREAM_TYPE_VIDEO: {
+            if (drop == false) {
+                esp_muxer_video_packet_t video_packet = {
+                    .pts = frame->pts,
+                    .data = frame->data,
+                    .len = frame->size,
+                };
+                path->muxer_cur_pts = frame->pts;
+                esp_muxer_add_video_packet(path->muxer, path->video_stream_idx, &video_packet);
+            }
+            share_q_release(path->video_share_q, frame);
+        } break;
+        default:
+            break;
+    }
+}
+
 static void muxer_thread(void *arg)
 {
     capture_path_t *path = (capture_path_t *)arg;
-    esp_capture_stream_frame_t frame = { 0 };
+    esp_capture_stream_frame_t frames[MUXER_RECV_BATCH_NUM];
+    bool stopped = false;
     ESP_LOGI(TAG, "Enter muxer thread muxing %d", path->muxing);
-    while (path->muxing) {
-        int ret = msg_q_recv(path->muxer_q, &frame, sizeof(frame), false);
-        if (ret != 0) {
-            ESP_LOGI(TAG, "Quit muxer for recv ret %d", ret);
-            break;
-        }
-        if (frame.stream_type == STOP_CMD_STREAM_TYPE) {
-            ESP_LOGI(TAG, "Muxer receive stop");
+    while (path->muxing && stopped == false) {
+        // Receive all queued frames with one lock
+        int num = msg_q_recv_many(path->muxer_q, frames, sizeof(esp_capture_stream_frame_t), MUXER_RECV_BATCH_NUM, false);
+        if (num <= 0) {
+            ESP_LOGI(TAG, "Quit muxer for recv ret %d", num);
             break;
         }
-        if (frame.data == NULL || frame.size == 0) {
-            ESP_LOGE(TAG, "Receive quit frame");
-            continue;
-        }
-        switch (frame.stream_type) {
-            case ESP_CAPTURE_STREAM_TYPE_AUDIO: {
-                esp_muxer_audio_packet_t audio_packet = {
-                    .pts = frame.pts,
-                    .data = frame.data,
-                    .len = frame.size,
-                };
-                path->muxer_cur_pts = frame.pts;
-                ret = esp_muxer_add_audio_packet(path->muxer, path->audio_stream_idx, &audio_packet);
-                share_q_release(path->audio_share_q, &frame);
-            } break;
-            case ESP_CAPTURE_STREAM_TYPE_VIDEO: {
-                esp_muxer_video_packet_t video_packet = {
-                    .pts = frame.pts,
-                    .data = frame.data,
-                    .len = frame.size,
-                };
-                path->muxer_cur_pts = frame.pts;
-                ret = esp_muxer_add_video_packet(path->muxer, path->video_stream_idx, &video_packet);
-                share_q_release(path->video_share_q, &frame);
-            } break;
-            default:
-                break;
+        for (int i = 0; i < num; i++) {
+            esp_capture_stream_frame_t *frame = &frames[i];
+            if (frame->stream_type == STOP_CMD_STREAM_TYPE) {
+                ESP_LOGI(TAG, "Muxer receive stop");
+                stopped = true;
+                continue;
+            }
+            if (frame->data == NULL || frame->size == 0) {
+                ESP_LOGE(TAG, "Receive quit frame");
+                continue;
+            }
+            // Frames received after stop only need release
+            muxer_add_frame(path, frame, stopped);
         }
     }
     ESP_LOGI(TAG, "Leave muxer thread");
@@ -713,11 +730,18 @@ static int prepare_src_queue(capture_path_t *path)
     capture_t *capture = path->parent;
     if (path->sink_cfg.audio_info.codec != ESP_CAPTURE_CODEC_TYPE_NONE && capture->audio_src_q == NULL) {
         // TODO need configure audio src q
-        capture->audio_src_q = data_queue_init(10 * 1024);
+        data_queue_cfg_t q_cfg = {
+            .size = 10 * 1024,
+            .mem = DATA_QUEUE_MEM_INTERNAL,
+            .spsc = true,
+        };
+        capture->audio_src_q = data_queue_init_with_cfg(&q_cfg);
         if (capture->audio_src_q == NULL) {
             ESP_LOGE(TAG, "Failed to create audio src q");
             // Not support audio now
             path->sink_cfg.audio_info.codec = ESP_CAPTURE_CODEC_TYPE_NONE;
+        } else {
+            data_queue_enable_stats(capture->audio_src_q, "CapASrc");
         }
     }
 
@@ -727,6 +751,8 @@ static int prepare_src_queue(capture_path_t *path)
         if (capture->video_src_q == NULL) {
             ESP_LOGE(TAG, "Failed to create video src q");
             path->sink_cfg.video_info.codec = ESP_CAPTURE_CODEC_TYPE_NONE;
+        } else {
+            msg_q_enable_stats(capture->video_src_q, "CapVSrc");
         }
     }
     return (path->sink_cfg.video_info.codec || path->sink_cfg.audio_info.codec) ? ESP_CAPTURE_ERR_OK : ESP_CAPTURE_ERR_NO_RESOURCES;
@@ -786,6 +812,7 @@ static int start_path(capture_path_t *path)
                     .use_external_q = true,
                 };
                 path->audio_share_q = share_q_create(&cfg);
+                share_q_enable_stats(path->audio_share_q, "CapAShare");
             }
             if (path->audio_share_q == NULL) {
                 ESP_LOGE(TAG, "Failed to create share q for audio sink");
@@ -823,6 +850,7 @@ static int start_path(capture_path_t *path)
                     .use_external_q = true,
                 };
                 path->video_share_q = share_q_create(&cfg);
+                share_q_enable_stats(path->video_share_q, "CapVShare");
             }
             if (path->video_share_q == NULL) {
                 ESP_LOGE(TAG, "Failed to create share q for video sink");
@@ -846,7 +874,11 @@ static int start_path(capture_path_t *path)
                 muxer_pool_size = path->muxer_cfg.muxer_cache_size;
             }
             if (path->muxer_data_q == NULL) {
-                path->muxer_data_q = data_queue_init(muxer_pool_size);
+                data_queue_cfg_t q_cfg = {
+                    .size = muxer_pool_size,
+                    .mem = DATA_QUEUE_MEM_PSRAM,
+                };
+                path->muxer_data_q = data_queue_init_with_cfg(&q_cfg);
                 if (path->muxer_data_q == NULL) {
                     ESP_LOGE(TAG, "Fail to create output queue for muxer");
                 }
@@ -901,10 +933,13 @@ static void consume_all_video_src(capture_t *capture)
     if (capture->video_src_q == NULL) {
         return;
     }
-    esp_capture_stream_frame_t frame = {};
-    while (msg_q_recv(capture->video_src_q, &frame, sizeof(frame), true) == 0) {
-        if (frame.size) {
-            capture->cfg.video_src->release_frame(capture->cfg.video_src, &frame);
+    esp_capture_stream_frame_t frames[MUXER_RECV_BATCH_NUM];
+    int num;
+    while ((num = msg_q_recv_many(capture->video_src_q, frames, sizeof(esp_capture_stream_frame_t), MUXER_RECV_BATCH_NUM, true)) > 0) {
+        for (int i = 0; i < num; i++) {
+            if (frames[i].size) {
+                capture->cfg.video_src->release_frame(capture->cfg.video_src, &frames[i]);
+            }
         }
     }
 }
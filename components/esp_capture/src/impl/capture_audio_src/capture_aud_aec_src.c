@@ -40,6 +40,8 @@
 
 // #define DISABLE_AEC
 
+#define AEC_FEED_BATCH_NUM (4)
+
 typedef struct {
     esp_capture_audio_src_if_t base;
     uint8_t                    channel;
@@ -237,26 +239,35 @@ static void audio_aec_src_buffer_in_thread(void *arg)
         ret = media_lib_thread_create_from_scheduler(NULL, "SrcRead", audio_read_thread, src);
     }
     int time_size = 0;
+    data_queue_iov_t feed_items[AEC_FEED_BATCH_NUM];
     while (!src->stopping && ret == 0) {
-        void *feed_data = NULL;
-        int ret = data_queue_read_lock(src->in_q, &feed_data, &read_size);
-        if (feed_data == NULL) {
+        int num = 0;
+        // Drain all cached data after read stall in one pass
+        if (data_queue_read_lock_batch(src->in_q, feed_items, AEC_FEED_BATCH_NUM, &num) != 0 || num == 0) {
             break;
         }
-        time_size += read_size;
-        if (time_size > 32000) {
-            time_size = 0;
-            int q_num = 0, q_size = 0;
-            data_queue_query(src->in_q, &q_num, &q_size);
-            printf("Cached %d\n", q_size);
+        for (int i = 0; i < num; i++) {
+            void *feed_data = feed_items[i].buffer;
+            read_size = feed_items[i].size;
+            time_size += read_size;
+            if (time_size > 32000) {
+                time_size = 0;
+                int q_num = 0, q_size = 0;
+                data_queue_query(src->in_q, &q_num, &q_size);
+                printf("Cached %d\n", q_size);
+            }
+            ret = src->aec_if->feed(src->aec_data, (int16_t *)feed_data);
+            if (ret < 0) {
+                ESP_LOGE(TAG, "Fail to feed data %d", ret);
+                break;
+            }
+            add_origin_data(feed_data, read_size);
         }
-        ret = src->aec_if->feed(src->aec_data, (int16_t *)feed_data);
+        data_queue_read_unlock_batch(src->in_q, num);
         if (ret < 0) {
-            ESP_LOGE(TAG, "Fail to feed data %d", ret);
             break;
         }
-        add_origin_data(feed_data, read_size);
-        data_queue_read_unlock(src->in_q);
+        ret = 0;
     }
     printf("wait for read quit\n");
     if (src->in_q) {
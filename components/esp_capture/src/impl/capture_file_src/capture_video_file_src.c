@@ -250,7 +250,13 @@ static int vid_file_src_open(esp_capture_video_src_if_t *h)
         ESP_LOGE(TAG, "open file failed");
         return ESP_CAPTURE_ERR_NOT_FOUND;
     }
-    src->frame_q = data_queue_init(MAX_FRAME_NUM * MAX_FRAME_SIZE);
+    // Each frame takes one whole block so that all MAX_FRAME_NUM frames can be cached
+    data_queue_cfg_t q_cfg = {
+        .mem = DATA_QUEUE_MEM_PSRAM,
+        .block_size = MAX_FRAME_SIZE,
+        .block_num = MAX_FRAME_NUM,
+    };
+    src->frame_q = data_queue_init_with_cfg(&q_cfg);
     if (src->frame_q == NULL) {
         vid_file_src_close(h);
         return ESP_CAPTURE_ERR_NO_MEM;
@@ -387,10 +387,20 @@ static int simple_capture_enable_audio(simple_capture_t *capture, bool enable)
         aenc->get_frame_size(aenc, &in_frame_size, &out_frame_size);
         res->audio_frame_size = out_frame_size;
         int frame_count = capture->enc_cfg.aenc_frame_count ? capture->enc_cfg.aenc_frame_count : 5;
-        int fifo_size = frame_count * (out_frame_size + 64);
-        // Reuse queue if disable and enable again
+        int block_size = out_frame_size + sizeof(esp_capture_stream_frame_t);
+        // Reuse queue if disable and enable again, recreate when frame size grows
+        if (res->audio_q && res->audio_q->block_size < block_size) {
+            data_queue_deinit(res->audio_q);
+            res->audio_q = NULL;
+        }
         if (res->audio_q == NULL) {
-            res->audio_q = data_queue_init(fifo_size);
+            // Encoded frames have same size, use fixed-block pool in internal RAM
+            data_queue_cfg_t q_cfg = {
+                .mem = DATA_QUEUE_MEM_INTERNAL,
+                .block_size = block_size,
+                .block_num = frame_count,
+            };
+            res->audio_q = data_queue_init_with_cfg(&q_cfg);
         }
         if (res->audio_q == NULL) {
             ESP_LOGE(TAG, "Fail to init audio encoder fifo");
@@ -439,7 +449,11 @@ static int simple_capture_enable_video(simple_capture_t *capture, bool enable)
         int frame_count = capture->enc_cfg.venc_frame_count ? capture->enc_cfg.venc_frame_count : 2;
         int fifo_size = frame_count * (out_frame_size + 256);
         if (res->video_q == NULL) {
-            res->video_q = data_queue_init(fifo_size);
+            data_queue_cfg_t q_cfg = {
+                .size = fifo_size,
+                .mem = DATA_QUEUE_MEM_PSRAM,
+            };
+            res->video_q = data_queue_init_with_cfg(&q_cfg);
         }
         if (res->video_q == NULL) {
             ESP_LOGE(TAG, "Fail to init video encoder fifo");
@@ -24,6 +24,8 @@
 
 #include "msg_q.h"
 #include "share_q.h"
+#include "queue_stats.h"
+#include "media_lib_atomic.h"
 #include <stdlib.h>
 #include <pthread.h>
 #include <string.h>
@@ -32,10 +34,15 @@
 #include <stdbool.h>
 
 typedef struct {
-    int   ref_count;
-    void *frame_data;
+    int   ref_count;  /*!< Users not released yet, updated atomically */
+    void *frame_data; /*!< Frame data used to match released item */
 } share_item_t;
 
+typedef struct {
+    void *frame_data; /*!< Key of entry, NULL for never used, SHARE_Q_TOMB for removed */
+    int   slot;       /*!< Slot index of frame data */
+} share_map_entry_t;
+
 typedef struct {
     msg_q_handle_t q;
     bool           enable;
@@ -47,13 +54,56 @@ typedef struct share_q_t {
     share_q_cfg_t      cfg;
     share_user_info_t *user_q;
     share_item_t      *items;
+    share_map_entry_t *map;
+    uint16_t           map_mask;
     uint8_t            valid_count;
     uint8_t            rp;
     uint8_t            wp;
     pthread_mutex_t    lock;
     pthread_cond_t     cond;
+    queue_stats_t     *stats;
 } share_q_t;
 
+// Removed map entry, keep probe chain so that lock-free lookup never miss live entry
+static uint8_t share_q_tomb;
+#define SHARE_Q_TOMB ((void *)&share_q_tomb)
+
+static inline uint16_t share_q_hash(share_q_t *q, void *frame_data)
+{
+    uint32_t v = (uint32_t)((uintptr_t)frame_data ^ ((uintptr_t)frame_data >> 16));
+    v *= 0x45d9f3b;
+    v ^= v >> 16;
+    return (uint16_t)(v & q->map_mask);
+}
+
+// Add frame data to slot map, called with lock held
+static void share_q_map_add(share_q_t *q, void *frame_data, int slot)
+{
+    uint16_t i = share_q_hash(q, frame_data);
+    while (1) {
+        void *key = q->map[i].frame_data;
+        if (key == NULL || key == SHARE_Q_TOMB) {
+            MEDIA_LIB_ATOMIC_STORE_RELAXED(q->map[i].slot, slot);
+            MEDIA_LIB_ATOMIC_STORE_REL(q->map[i].frame_data, frame_data);
+            return;
+        }
+        i = (i + 1) & q->map_mask;
+    }
+}
+
+// Remove entry of retired slot, called with lock held
+static void share_q_map_remove(share_q_t *q, void *frame_data, int slot)
+{
+    uint16_t i = share_q_hash(q, frame_data);
+    for (int n = 0; n <= q->map_mask && q->map[i].frame_data; n++) {
+        if (q->map[i].frame_data == frame_data && q->map[i].slot == slot) {
+            MEDIA_LIB_ATOMIC_STORE_REL(q->map[i].frame_data, SHARE_Q_TOMB);
+            return;
+        }
+        i = (i + 1) & q->map_mask;
+    }
+}
+
 share_q_t *share_q_create(share_q_cfg_t *cfg)
 {
     if (cfg == NULL) {
@@ -66,7 +116,14 @@ share_q_t *share_q_create(share_q_cfg_t *cfg)
     q->cfg = *cfg;
     q->items = (share_item_t *)calloc(cfg->q_count, sizeof(share_item_t));
     q->user_q = (share_user_info_t *)calloc(cfg->user_count, sizeof(share_user_info_t));
-    if (q->items == NULL || q->user_q == NULL) {
+    // Map size at least twice of slots to keep probe short
+    int map_size = 8;
+    while (map_size < 2 * cfg->q_count) {
+        map_size <<= 1;
+    }
+    q->map = (share_map_entry_t *)calloc(map_size, sizeof(share_map_entry_t));
+    q->map_mask = (uint16_t)(map_size - 1);
+    if (q->items == NULL || q->user_q == NULL || q->map == NULL) {
         goto _exit;
     }
     q->external = cfg->use_external_q;
@@ -187,6 +244,7 @@ int share_q_add(share_q_t *q, void *item)
     }
     pthread_mutex_lock(&q->lock);
     if (q->valid_count == 0) {
+        queue_stats_drop(q->stats);
         q->cfg.release_frame(item, q->cfg.ctx);
         pthread_mutex_unlock(&q->lock);
         return 0;
@@ -195,19 +253,25 @@ int share_q_add(share_q_t *q, void *item)
     int next_wp = (q->wp + 1) % q->cfg.q_count;
     while (next_wp == q->rp) {
         // Queue is full, cannot add new item
+        uint64_t start = q->stats ? queue_stats_now() : 0;
         pthread_cond_wait(&q->cond, &q->lock);
+        queue_stats_producer_wait(q->stats, start);
     }
     // Add into items first
     share_item_t *q_item = q->items + q->wp;
-    q_item->frame_data = q->cfg.get_frame_data(item);
-    q_item->ref_count = q->valid_count;
-    q->wp = next_wp;
+    MEDIA_LIB_ATOMIC_STORE_RELAXED(q_item->frame_data, q->cfg.get_frame_data(item));
+    MEDIA_LIB_ATOMIC_STORE_RELAXED(q_item->ref_count, (int)q->valid_count);
+    share_q_map_add(q, q_item->frame_data, q->wp);
+    // Publish slot before dispatch so that release can find it without lock
+    MEDIA_LIB_ATOMIC_STORE_REL(q->wp, (uint8_t)next_wp);
+    queue_stats_push(q->stats, q->cfg.item_size);
     // Add items into user queues
     for (int i = 0; i < q->cfg.user_count; i++) {
         if (q->user_q[i].enable == false || q->user_q[i].q == NULL) {
             continue;
         }
         if (msg_q_send(q->user_q[i].q, item, q->cfg.item_size) != 0) {
+            queue_stats_drop(q->stats);
             pthread_mutex_unlock(&q->lock);
             return -1;
         }
@@ -216,34 +280,73 @@ int share_q_add(share_q_t *q, void *item)
     return 0;
 }
 
+// Find slot of frame data through map, lock-free as entry only changed when slot retired
+static int share_q_find_slot(share_q_t *q, void *frame_data)
+{
+    uint16_t i = share_q_hash(q, frame_data);
+    for (int n = 0; n <= q->map_mask; n++) {
+        void *key = MEDIA_LIB_ATOMIC_LOAD_ACQ(q->map[i].frame_data);
+        if (key == NULL) {
+            break;
+        }
+        if (key == frame_data) {
+            int slot = MEDIA_LIB_ATOMIC_LOAD_RELAXED(q->map[i].slot);
+            share_item_t *q_item = &q->items[slot];
+            // Skip released slot not retired yet, its frame data may be reused by a newer item
+            if (MEDIA_LIB_ATOMIC_LOAD_RELAXED(q_item->frame_data) == frame_data &&
+                MEDIA_LIB_ATOMIC_LOAD_ACQ(q_item->ref_count) > 0) {
+                return slot;
+            }
+        }
+        i = (i + 1) & q->map_mask;
+    }
+    return -1;
+}
+
 // Release an item from the shared queue
 int share_q_release(share_q_t *q, void *item)
 {
     if (q == NULL || item == NULL) {
         return -1;
     }
-    pthread_mutex_lock(&q->lock);
-    // Find and decrement reference count
-    int rp = q->rp;
-    int wp = q->wp;
     void *frame_data = q->cfg.get_frame_data(item);
-    while (rp != wp) {
-        share_item_t *q_item = &q->items[rp];
-        if (q_item->frame_data == frame_data) {
-            q_item->ref_count--;
-            if (q_item->ref_count == 0) {
-                q->cfg.release_frame(item, q->cfg.ctx);
-                q->rp = (q->rp + 1) % q->cfg.q_count;
-                pthread_cond_signal(&q->cond);
-            }
-            pthread_mutex_unlock(&q->lock);
-            return 0;
-        }
-        rp = (rp + 1) % (q->cfg.q_count);
+    int slot = share_q_find_slot(q, frame_data);
+    if (slot < 0) {
+        printf("Not found frame data in q %p\n", frame_data);
+        return -1;
+    }
+    // Only last user need lock to retire the slot
+    if (MEDIA_LIB_ATOMIC_SUB_ACQ_REL(q->items[slot].ref_count, 1) > 0) {
+        return 0;
+    }
+    pthread_mutex_lock(&q->lock);
+    q->cfg.release_frame(item, q->cfg.ctx);
+    // Retire all released slots from oldest, slot released out of order is kept until older ones released
+    uint8_t rp = q->rp;
+    while (rp != q->wp && MEDIA_LIB_ATOMIC_LOAD_ACQ(q->items[rp].ref_count) == 0) {
+        share_q_map_remove(q, q->items[rp].frame_data, rp);
+        queue_stats_pop(q->stats, q->cfg.item_size);
+        rp = (rp + 1) % q->cfg.q_count;
+    }
+    if (rp != q->rp) {
+        MEDIA_LIB_ATOMIC_STORE_REL(q->rp, rp);
+        pthread_cond_signal(&q->cond);
     }
     pthread_mutex_unlock(&q->lock);
-    printf("Not found frame data in q %p\n", frame_data);
-    return -1;
+    return 0;
+}
+
+int share_q_enable_stats(share_q_handle_t q, const char *name)
+{
+    if (q == NULL) {
+        return -1;
+    }
+    pthread_mutex_lock(&q->lock);
+    if (q->stats == NULL) {
+        q->stats = queue_stats_register(name, QUEUE_STATS_TYPE_SHARE_Q);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return q->stats ? 0 : -1;
 }
 
 void share_q_destroy(share_q_t *q)
@@ -251,9 +354,13 @@ void share_q_destroy(share_q_t *q)
     if (q == NULL) {
         return;
     }
+    queue_stats_unregister(q->stats);
     if (q->items) {
         free(q->items);
     }
+    if (q->map) {
+        free(q->map);
+    }
     if (q->user_q) {
         if (q->external == false) {
             for (int i = 0; i < q->cfg.user_count; i++) {
@@ -156,6 +156,9 @@ int share_q_add(share_q_handle_t q, void *item);
 /**
  * @brief  Release frame
  *
+ * @note  Only the last user of the frame takes the queue lock to release the frame
+ *        Frames can be released out of order, slot is reused after all older frames released
+ *
  * @param[in]  q     Shared queue handle
  * @param[in]  item  Frame to be released
  *
@@ -166,6 +169,22 @@ int share_q_add(share_q_handle_t q, void *item);
  */
 int share_q_release(share_q_handle_t q, void *item);
 
+/**
+ * @brief  Enable statistics for share queue
+ *
+ * @note  Statistics is registered only when `queue_stats_set_enable` is enabled
+ *        Items count frames not yet released by all users
+ *
+ * @param[in]  q     Shared queue handle
+ * @param[in]  name  Name to show in statistics
+ *
+ * @return
+ *       - 0   On success
+ *       - -1  Statistics is disabled or no memory
+ *
+ */
+int share_q_enable_stats(share_q_handle_t q, const char *name);
+
 /**
  * @brief  Destroy share queue
  *
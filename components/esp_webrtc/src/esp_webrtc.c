@@ -36,6 +36,8 @@
 #include "esp_webrtc_defaults.h"
 
 #define AUDIO_FRAME_INTERVAL (20)
+// Drop received audio if decoder fifo stays full longer than this, so peer receive is not blocked
+#define RECV_AUDIO_MAX_WAIT  (100)
 #define STR_SAME(a, b)       (strncmp(a, b, sizeof(b) - 1) == 0)
 #define GOTO_LABEL_ON_NULL(label, ptr, code) if (ptr == NULL) {   \
     ret = code;                                                   \
@@ -335,6 +337,7 @@ static int pc_on_audio_data(esp_peer_audio_frame_t *info, void *ctx)
         .pts = info->pts,
         .data = info->data,
         .size = info->size,
+        .deadline = (uint32_t)(esp_timer_get_time() / 1000) + RECV_AUDIO_MAX_WAIT,
     };
     av_render_add_audio_data(rtc->play_handle, &audio_data);
     return 0;
@@ -25,6 +25,8 @@
 #pragma once
 
 #include <stdbool.h>
+#include "media_lib_err.h"
+#include "queue_stats.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -37,19 +39,64 @@ extern "C" {
  *        It adds a fill_end member to record fifo write end position before ring back.
  */
 typedef struct {
-    void *buffer;     /*!< Buffer for queue */
-    int   size;       /*!< Buffer size */
-    int   fill_end;   /*!< Buffer write position before ring back */
-    int   wp;         /*!< Write pointer */
-    int   rp;         /*!< Read pointer */
-    int   filled;     /*!< Buffer filled size */
-    int   user;       /*!< Buffer reference by reader or writer */
-    int   quit;       /*!< Buffer quit flag */
-    void *lock;       /*!< Protect lock */
-    void *write_lock; /*!< Write lock to let only one writer at same time */
-    void *event;      /*!< Event group to wake up reader or writer */
+    void          *buffer;        /*!< Buffer for queue */
+    int            size;          /*!< Buffer size */
+    int            fill_end;      /*!< Buffer write position before ring back */
+    int            wp;            /*!< Write pointer */
+    int            rp;            /*!< Read pointer */
+    int            filled;        /*!< Buffer filled size */
+    int            user;          /*!< Buffer reference by reader or writer */
+    int            quit;          /*!< Buffer quit flag */
+    void          *lock;          /*!< Protect lock */
+    void          *write_lock;    /*!< Write lock to let only one writer at same time */
+    void          *event;         /*!< Event group to wake up reader or writer */
+    bool           spsc;          /*!< Lock-free single producer single consumer mode */
+    int            writing;       /*!< Writer claim flag (SPSC mode) */
+    int            waiting;       /*!< Bits of reader or writer waiting on event (SPSC mode) */
+    int            read_pos;      /*!< Position of next item to be read locked (SPSC mode) */
+    int            peek_pos;      /*!< Position of last read locked item (SPSC mode) */
+    int            reading;       /*!< Read locks held by consumer, -1 when consumed by other thread (SPSC mode) */
+    int            flush;         /*!< Consume all pending until consumer unlock (SPSC mode) */
+    int            reserve_pos;   /*!< Position of buffer being written (SPSC mode) */
+    int            reserve_size;  /*!< Size of buffer being written (SPSC mode) */
+    int            count;         /*!< Data block number kept in queue */
+    int            bytes;         /*!< Total data size kept in queue */
+    queue_stats_t *stats;         /*!< Queue statistics, NULL if not enabled */
+    int            head_size;     /*!< Item header size (mutex mode) */
+    int            block_size;    /*!< Maximum item size, 0 if not pool mode */
+    int            block_stride;  /*!< Block size include header (pool mode) */
+    uint8_t        buffer_type;   /*!< How buffer is allocated */
 } data_queue_t;
 
+/**
+ * @brief Memory placement hint for data queue buffer
+ */
+typedef enum {
+    DATA_QUEUE_MEM_DEFAULT = 0,  /*!< Allocate by `media_lib_malloc` */
+    DATA_QUEUE_MEM_INTERNAL,     /*!< Prefer internal RAM, for small latency critical queue */
+    DATA_QUEUE_MEM_PSRAM,        /*!< Prefer PSRAM, for bulk data queue */
+} data_queue_mem_t;
+
+/**
+ * @brief Configuration for data queue
+ */
+typedef struct {
+    int              size;        /*!< Buffer size, calculated from block setting in pool mode */
+    data_queue_mem_t mem;         /*!< Memory placement hint, fallback to default heap if not enough */
+    uint8_t          align;       /*!< Buffer alignment (power of 2), 0 for default */
+    bool             spsc;        /*!< Lock-free single producer single consumer mode */
+    int              block_size;  /*!< Set to enable fixed-block pool mode, each item take one block of this size */
+    int              block_num;   /*!< Block number in pool mode */
+} data_queue_cfg_t;
+
+/**
+ * @brief Struct for item read by batch
+ */
+typedef struct {
+    void *buffer;  /*!< Item data */
+    int   size;    /*!< Item size */
+} data_queue_iov_t;
+
 /**
  * @brief         Initialize data queue
  *
@@ -59,6 +106,47 @@ typedef struct {
  */
 data_queue_t *data_queue_init(int size);
 
+/**
+ * @brief         Initialize data queue in lock-free single producer single consumer mode
+ *
+ * @note          Read and write position are updated by atomic operation, no mutex is taken on data path
+ *                And event is only set when the other side is waiting on it
+ *                Only one consumer can access the queue at the same time
+ *                Writers are serialized by an atomic claim flag which is held from `data_queue_get_buffer`
+ *                to `data_queue_send_buffer`, so occasional writers from other thread are still allowed
+ *                Each item (including 4 bytes header) is 4 bytes aligned and limited to half of the queue size
+ *
+ * @param         size: Buffer size
+ * @return        - NULL: Fail to initialize queue
+ *                - Others: Data queue instance
+ */
+data_queue_t *data_queue_init_spsc(int size);
+
+/**
+ * @brief         Initialize data queue by configuration
+ *
+ * @note          In pool mode buffer is divided into `block_num` blocks, each item takes one whole block
+ *                So queue never fragment and always hold `block_num` items of at most `block_size`
+ *                Item data is aligned to `align` in pool mode, pool mode can not be used with SPSC mode
+ *
+ * @param         cfg: Data queue configuration
+ * @return        - NULL: Fail to initialize queue
+ *                - Others: Data queue instance
+ */
+data_queue_t *data_queue_init_with_cfg(data_queue_cfg_t *cfg);
+
+/**
+ * @brief         Enable statistics for data queue
+ *
+ * @note          Statistics is registered only when `queue_stats_set_enable` is enabled
+ *
+ * @param         q: Data queue instance
+ * @param         name: Name to show in statistics
+ * @return        - 0: On success
+ *                - Others: Statistics is disabled or no memory
+ */
+int data_queue_enable_stats(data_queue_t *q, const char *name);
+
 /**
  * @brief         Wakeup thread which wait on queue data
  *
@@ -83,6 +171,19 @@ void data_queue_deinit(data_queue_t *q);
  */
 void *data_queue_get_buffer(data_queue_t *q, int size);
 
+/**
+ * @brief         Get continuous buffer from data queue with timeout
+ *
+ * @param         q: Data queue instance
+ * @param         size: Buffer size want to get
+ * @param[out]    buffer: Buffer data
+ * @param         timeout: Maximum wait time in milliseconds, 0 not wait, `MEDIA_LIB_MAX_LOCK_TIME` wait forever
+ * @return        - 0: On success
+ *                - ESP_MEDIA_ERR_TIMEOUT: Not enough space before timeout
+ *                - Others: Fail to get buffer
+ */
+int data_queue_get_buffer_timeout(data_queue_t *q, int size, void **buffer, uint32_t timeout);
+
 /**
  * @brief         Get data pointer being written but not send yet
  *
@@ -113,6 +214,19 @@ int data_queue_send_buffer(data_queue_t *q, int size);
  */
 int data_queue_read_lock(data_queue_t *q, void **buffer, int *size);
 
+/**
+ * @brief         Read data from data queue with timeout, and add reference count
+ *
+ * @param         q: Data queue instance
+ * @param[out]    buffer: Buffer in front of queue, this buffer is always valid before call `data_queue_read_unlock`
+ * @param[out]    size: Buffer size in front of queue
+ * @param         timeout: Maximum wait time in milliseconds, 0 not wait, `MEDIA_LIB_MAX_LOCK_TIME` wait forever
+ * @return        - 0: On success
+ *                - ESP_MEDIA_ERR_TIMEOUT: No data before timeout
+ *                - Others: Fail to read buffer
+ */
+int data_queue_read_lock_timeout(data_queue_t *q, void **buffer, int *size, uint32_t timeout);
+
 /**
  * @brief         Release data be read and decrease reference count
  *
@@ -124,6 +238,32 @@ int data_queue_read_lock(data_queue_t *q, void **buffer, int *size);
  */
 int data_queue_read_unlock(data_queue_t *q);
 
+/**
+ * @brief         Read all ready items from data queue in one locked section
+ *
+ * @note          Block until at least one item is ready, then return every ready item up to `max`
+ *                Items keep valid until call `data_queue_read_unlock_batch`
+ *                Only one batch can be locked at the same time, `data_queue_peek_unlock` is not supported for batch
+ *
+ * @param         q: Data queue instance
+ * @param[out]    iov: Array to store item data and size
+ * @param         max: Maximum item number to read
+ * @param[out]    n: Item number read
+ * @return        - 0: On success
+ *                - Others: Fail to read buffer
+ */
+int data_queue_read_lock_batch(data_queue_t *q, data_queue_iov_t iov[], int max, int *n);
+
+/**
+ * @brief         Release items read by `data_queue_read_lock_batch`
+ *
+ * @param         q: Data queue instance
+ * @param         n: Item number to release, should be same as returned by `data_queue_read_lock_batch`
+ * @return        - 0: On success
+ *                - Others: Fail to release buffer
+ */
+int data_queue_read_unlock_batch(data_queue_t *q, int n);
+
 /**
  * @brief         Peak data unlock, call `data_queue_read_lock` to read data with block
  *                After peek data, not consume the data and release the lock
@@ -137,6 +277,8 @@ int data_queue_peek_unlock(data_queue_t *q);
 /**
  * @brief         Consume all data in queue
  *
+ * @note          In SPSC mode when consumer holds read lock, data is consumed when it unlocks
+ *
  * @param         q: Data queue instance
  * @return        - 0: On success
  *                - Others: Fail to read buffer
@@ -0,0 +1,71 @@
+/**
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2025 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief  Atomic helpers shared by media components
+ *
+ * @note  Memory order is part of macro name so that it is visible at call site:
+ *          - RELAXED: counters and statistics which do not guard other data
+ *          - ACQ/REL: publish data by release store, observe it by acquire load
+ *          - ACQ_REL: read-modify-write which both consumes and publishes (reference count, slot claim)
+ *          - SC:      store followed by load of another variable while peer does the reverse,
+ *                     such as setting waiter flag then checking position (store-load ordering)
+ *        Arithmetic macros return value after operation, compare-exchange updates `expect` on failure
+ */
+#define MEDIA_LIB_ATOMIC_LOAD_RELAXED(v)  __atomic_load_n(&(v), __ATOMIC_RELAXED)
+#define MEDIA_LIB_ATOMIC_LOAD_ACQ(v)      __atomic_load_n(&(v), __ATOMIC_ACQUIRE)
+#define MEDIA_LIB_ATOMIC_LOAD_SC(v)       __atomic_load_n(&(v), __ATOMIC_SEQ_CST)
+
+#define MEDIA_LIB_ATOMIC_STORE_RELAXED(v, n) __atomic_store_n(&(v), (n), __ATOMIC_RELAXED)
+#define MEDIA_LIB_ATOMIC_STORE_REL(v, n)     __atomic_store_n(&(v), (n), __ATOMIC_RELEASE)
+#define MEDIA_LIB_ATOMIC_STORE_SC(v, n)      __atomic_store_n(&(v), (n), __ATOMIC_SEQ_CST)
+
+#define MEDIA_LIB_ATOMIC_ADD_RELAXED(v, n) __atomic_add_fetch(&(v), (n), __ATOMIC_RELAXED)
+#define MEDIA_LIB_ATOMIC_ADD_ACQ_REL(v, n) __atomic_add_fetch(&(v), (n), __ATOMIC_ACQ_REL)
+#define MEDIA_LIB_ATOMIC_ADD_SC(v, n)      __atomic_add_fetch(&(v), (n), __ATOMIC_SEQ_CST)
+#define MEDIA_LIB_ATOMIC_SUB_RELAXED(v, n) __atomic_sub_fetch(&(v), (n), __ATOMIC_RELAXED)
+#define MEDIA_LIB_ATOMIC_SUB_ACQ_REL(v, n) __atomic_sub_fetch(&(v), (n), __ATOMIC_ACQ_REL)
+
+#define MEDIA_LIB_ATOMIC_OR_SC(v, n)  __atomic_or_fetch(&(v), (n), __ATOMIC_SEQ_CST)
+#define MEDIA_LIB_ATOMIC_AND_SC(v, n) __atomic_and_fetch(&(v), (n), __ATOMIC_SEQ_CST)
+
+#define MEDIA_LIB_ATOMIC_XCHG_ACQ(v, n)     __atomic_exchange_n(&(v), (n), __ATOMIC_ACQUIRE)
+#define MEDIA_LIB_ATOMIC_XCHG_ACQ_REL(v, n) __atomic_exchange_n(&(v), (n), __ATOMIC_ACQ_REL)
+
+#define MEDIA_LIB_ATOMIC_CAS_RELAXED(v, expect, n) \
+    __atomic_compare_exchange_n(&(v), &(expect), (n), false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#define MEDIA_LIB_ATOMIC_CAS_ACQ_REL(v, expect, n) \
+    __atomic_compare_exchange_n(&(v), &(expect), (n), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+
+#ifdef __cplusplus
+}
+#endif
@@ -78,6 +78,42 @@ int msg_q_send(msg_q_handle_t q, void *msg, int size);
  */
 int msg_q_recv(msg_q_handle_t q, void *msg, int size, bool no_wait);
 
+/**
+ * @brief  Send multiple messages to queue under one lock
+ *
+ * @note  Block until all messages sent, consumer is woken once after messages inserted
+ *
+ * @param[in]   q     Message queue handle
+ * @param[in]   msgs  Continuous messages array to be inserted into queue
+ * @param[in]   size  Size of each message, need not larger than msg_size when created
+ * @param[in]   num   Messages number
+ *
+ * @return
+ *       - >0   Number of messages sent, less than `num` only when queue quit or reset
+ *       - -1   Invalid input arguments
+ *       - -2   Queue quit or reset before any message sent
+ *
+ */
+int msg_q_send_many(msg_q_handle_t q, void *msgs, int size, int num);
+
+/**
+ * @brief  Receive multiple messages from queue under one lock
+ *
+ * @param[in]   q        Message queue handle
+ * @param[out]  msgs     Continuous messages array to store received messages
+ * @param[in]   size     Size of each message, need not larger than msg_size when created
+ * @param[in]   max_num  Maximum messages to receive
+ * @param[in]   no_wait  If true, return immediately if no message in queue
+ *
+ * @return
+ *       - >0   Number of messages received
+ *       - 0    If no message in queue and no_wait is true
+ *       - -1   Invalid input arguments
+ *       - -2   Queue quit or reset
+ *
+ */
+int msg_q_recv_many(msg_q_handle_t q, void *msgs, int size, int max_num, bool no_wait);
+
 /**
  * @brief  Get items number in message queue
  *
@@ -90,6 +126,21 @@ int msg_q_recv(msg_q_handle_t q, void *msg, int size, bool no_wait);
  */
 int msg_q_number(msg_q_handle_t q);
 
+/**
+ * @brief  Enable statistics for message queue
+ *
+ * @note  Statistics is registered only when `queue_stats_set_enable` is enabled
+ *
+ * @param[in]  q     Message queue handle
+ * @param[in]  name  Name to show in statistics
+ *
+ * @return
+ *       - 0    On success
+ *       - -1   Statistics is disabled or no memory
+ *
+ */
+int msg_q_enable_stats(msg_q_handle_t q, const char *name);
+
 /**
  * @brief  Destroy message queue
  *
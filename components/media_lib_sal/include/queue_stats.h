@@ -0,0 +1,209 @@
+/**
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2025 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "media_lib_atomic.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define QUEUE_STATS_NAME_LEN (16)
+
+/**
+ * @brief  Queue type which statistics belongs to
+ */
+typedef enum {
+    QUEUE_STATS_TYPE_DATA_QUEUE,   /*!< Data queue */
+    QUEUE_STATS_TYPE_MSG_Q,        /*!< Message queue */
+    QUEUE_STATS_TYPE_FIFO_RINGBUF, /*!< FIFO ring buffer */
+    QUEUE_STATS_TYPE_SHARE_Q,      /*!< Shared queue */
+} queue_stats_type_t;
+
+/**
+ * @brief  Queue statistics
+ *
+ * @note  Statistics is updated by queue itself after registered, user can only read it through snapshot
+ */
+typedef struct {
+    char               name[QUEUE_STATS_NAME_LEN]; /*!< Queue name */
+    queue_stats_type_t type;                       /*!< Queue type */
+    uint32_t           items;                      /*!< Items kept in queue currently */
+    uint32_t           bytes;                      /*!< Bytes kept in queue currently */
+    uint32_t           max_items;                  /*!< High-water mark of items */
+    uint32_t           max_bytes;                  /*!< High-water mark of bytes */
+    uint32_t           drops;                      /*!< Items dropped or overwritten */
+    uint64_t           producer_wait_us;           /*!< Total time producer waits for space (unit us) */
+    uint64_t           consumer_wait_us;           /*!< Total time consumer waits for data (unit us) */
+} queue_stats_t;
+
+/**
+ * @brief  Enable or disable queue statistics globally
+ *
+ * @note  Default is disabled, no statistics is created for queues then
+ *        Only affect queues which register statistics after this call
+ *
+ * @param[in]  enable  Enable or disable
+ */
+void queue_stats_set_enable(bool enable);
+
+/**
+ * @brief  Register statistics into global registry
+ *
+ * @note  Called by queue implementation when user enables statistics on it
+ *
+ * @param[in]  name  Queue name
+ * @param[in]  type  Queue type
+ *
+ * @return
+ *       - NULL    Statistics disabled or no memory
+ *       - Others  Statistics to be updated by queue
+ */
+queue_stats_t *queue_stats_register(const char *name, queue_stats_type_t type);
+
+/**
+ * @brief  Unregister statistics from global registry and free it
+ *
+ * @param[in]  stats  Statistics got from `queue_stats_register`
+ */
+void queue_stats_unregister(queue_stats_t *stats);
+
+/**
+ * @brief  Get snapshot of all registered statistics
+ *
+ * @param[out]  stats    Array to store statistics
+ * @param[in]   max_num  Array size
+ *
+ * @return
+ *       - Number of statistics copied
+ */
+int queue_stats_snapshot(queue_stats_t *stats, int max_num);
+
+/**
+ * @brief  Print all registered statistics
+ */
+void queue_stats_dump(void);
+
+/**
+ * @brief  Start thread to print all registered statistics periodically
+ *
+ * @param[in]  interval_ms  Print interval (unit ms)
+ *
+ * @return
+ *       - 0   On success
+ *       - -1  Fail to create thread
+ */
+int queue_stats_start_dump(uint32_t interval_ms);
+
+/**
+ * @brief  Stop periodically print thread
+ *
+ * @note  Thread quits after current sleep, dump can be restarted at once
+ */
+void queue_stats_stop_dump(void);
+
+/**
+ * @brief  Get current time for wait time statistics (unit us)
+ */
+uint64_t queue_stats_now(void);
+
+/**
+ * @brief  Update high-water mark, internal helper of record APIs
+ */
+static inline void queue_stats_update_max(uint32_t *max, uint32_t v)
+{
+    uint32_t old = MEDIA_LIB_ATOMIC_LOAD_RELAXED(*max);
+    while (v > old && !MEDIA_LIB_ATOMIC_CAS_RELAXED(*max, old, v)) {
+    }
+}
+
+/*  Record APIs are inline so that queue without statistics only pays one branch */
+
+/**
+ * @brief  Record item added into queue
+ *
+ * @note  Must be called before item is visible to consumer, otherwise pop may run first
+ */
+static inline void queue_stats_push(queue_stats_t *stats, int bytes)
+{
+    if (stats == NULL) {
+        return;
+    }
+    queue_stats_update_max(&stats->max_items, MEDIA_LIB_ATOMIC_ADD_RELAXED(stats->items, 1));
+    queue_stats_update_max(&stats->max_bytes, MEDIA_LIB_ATOMIC_ADD_RELAXED(stats->bytes, bytes));
+}
+
+/**
+ * @brief  Record item removed from queue
+ */
+static inline void queue_stats_pop(queue_stats_t *stats, int bytes)
+{
+    if (stats == NULL) {
+        return;
+    }
+    MEDIA_LIB_ATOMIC_SUB_RELAXED(stats->items, 1);
+    MEDIA_LIB_ATOMIC_SUB_RELAXED(stats->bytes, bytes);
+}
+
+/**
+ * @brief  Record item dropped or overwritten
+ */
+static inline void queue_stats_drop(queue_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    MEDIA_LIB_ATOMIC_ADD_RELAXED(stats->drops, 1);
+}
+
+/**
+ * @brief  Record producer wait time from `start` got by `queue_stats_now`
+ */
+static inline void queue_stats_producer_wait(queue_stats_t *stats, uint64_t start)
+{
+    if (stats == NULL) {
+        return;
+    }
+    MEDIA_LIB_ATOMIC_ADD_RELAXED(stats->producer_wait_us, queue_stats_now() - start);
+}
+
+/**
+ * @brief  Record consumer wait time from `start` got by `queue_stats_now`
+ */
+static inline void queue_stats_consumer_wait(queue_stats_t *stats, uint64_t start)
+{
+    if (stats == NULL) {
+        return;
+    }
+    MEDIA_LIB_ATOMIC_ADD_RELAXED(stats->consumer_wait_us, queue_stats_now() - start);
+}
+
+#ifdef __cplusplus
+}
+#endif
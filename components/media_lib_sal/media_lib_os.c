@@ -25,6 +25,7 @@
  */
 
 #include <stdarg.h>
+#include <stdio.h>
 #include "media_lib_os_reg.h"
 #include "media_lib_common.h"
 #include "media_lib_os.h"
@@ -22,8 +22,17 @@
  *
  */
 
+#include <stdio.h>
+#include <time.h>
 #include "media_lib_os.h"
 #include "data_queue.h"
+#include "media_lib_atomic.h"
+#include "esp_log.h"
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+
+#define TAG                      "DATA_Q"
 
 #define DATA_Q_ALLOC_HEAD_SIZE   (4)
 #define DATA_Q_DATA_ARRIVE_BITS  (1)
@@ -35,10 +44,54 @@
 #define _WAIT_BITS(group, bit)                                                                           \
     media_lib_event_group_wait_bits((media_lib_event_grp_handle_t) group, bit, MEDIA_LIB_MAX_LOCK_TIME); \
     media_lib_event_group_clr_bits(group, bit)
+#define _WAIT_BITS_TIMEOUT(group, bit, timeout)                                                          \
+    media_lib_event_group_wait_bits((media_lib_event_grp_handle_t) group, bit, timeout);                 \
+    media_lib_event_group_clr_bits(group, bit)
 
 #define _MUTEX_LOCK(mutex)   media_lib_mutex_lock((media_lib_mutex_handle_t) mutex, MEDIA_LIB_MAX_LOCK_TIME)
 #define _MUTEX_UNLOCK(mutex) media_lib_mutex_unlock((media_lib_mutex_handle_t) mutex)
 
+// SPSC mode definitions, item header 0 used as ring back marker
+#define DATA_Q_SPSC_ALIGN        (4)
+#define DATA_Q_SPSC_ALIGN_UP(n)  (((n) + DATA_Q_SPSC_ALIGN - 1) & ~(DATA_Q_SPSC_ALIGN - 1))
+#define DATA_Q_SPSC_RING_MARK    (0)
+#define DATA_Q_WAIT_DATA         (1)
+#define DATA_Q_WAIT_CONSUME      (2)
+// SPSC waiter bits and positions are set then checked crosswise by both sides, so use SC atomics for them
+
+// Pool mode item header: block size and payload size
+#define DATA_Q_POOL_HEAD_SIZE    (8)
+#define DATA_Q_ALIGN_UP(n, a)    (((n) + (a) - 1) & ~((a) - 1))
+
+#define DATA_Q_BUFFER_MALLOC     (0)
+#define DATA_Q_BUFFER_ALIGN      (1)
+#define DATA_Q_BUFFER_CAPS       (2)
+
+// Get wait start time only when statistics enabled
+#define _STATS_NOW(q)            ((q)->stats ? queue_stats_now() : 0)
+
+static uint32_t data_queue_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) (ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static uint32_t data_queue_wait_start(uint32_t timeout)
+{
+    return (timeout == MEDIA_LIB_MAX_LOCK_TIME) ? 0 : data_queue_get_time();
+}
+
+// Get time left to wait, 0 means already timeout
+static uint32_t data_queue_wait_left(uint32_t start, uint32_t timeout)
+{
+    if (timeout == MEDIA_LIB_MAX_LOCK_TIME) {
+        return timeout;
+    }
+    uint32_t elapsed = data_queue_get_time() - start;
+    return (elapsed >= timeout) ? 0 : timeout - elapsed;
+}
+
 static int data_queue_release_user(data_queue_t *q)
 {
     _SET_BITS(q->event, DATA_Q_USER_FREE_BITS);
@@ -51,11 +104,13 @@ static int data_queue_notify_data(data_queue_t *q)
     return 0;
 }
 
-static int data_queue_wait_data(data_queue_t *q)
+static int data_queue_wait_data(data_queue_t *q, uint32_t timeout)
 {
     q->user++;
     _MUTEX_UNLOCK(q->lock);
-    _WAIT_BITS(q->event, DATA_Q_DATA_ARRIVE_BITS);
+    uint64_t start = _STATS_NOW(q);
+    _WAIT_BITS_TIMEOUT(q->event, DATA_Q_DATA_ARRIVE_BITS, timeout);
+    queue_stats_consumer_wait(q->stats, start);
     _MUTEX_LOCK(q->lock);
     int ret = (q->quit) ? -1 : 0;
     q->user--;
@@ -69,11 +124,13 @@ static int data_queue_data_consumed(data_queue_t *q)
     return 0;
 }
 
-static int data_queue_wait_consume(data_queue_t *q)
+static int data_queue_wait_consume(data_queue_t *q, uint32_t timeout)
 {
     q->user++;
     _MUTEX_UNLOCK(q->lock);
-    _WAIT_BITS(q->event, DATA_Q_DATA_CONSUME_BITS);
+    uint64_t start = _STATS_NOW(q);
+    _WAIT_BITS_TIMEOUT(q->event, DATA_Q_DATA_CONSUME_BITS, timeout);
+    queue_stats_producer_wait(q->stats, start);
     _MUTEX_LOCK(q->lock);
     int ret = (q->quit) ? -1 : 0;
     q->user--;
@@ -102,26 +159,489 @@ static bool _data_queue_have_data_from_last(data_queue_t *q)
     return q->filled ? true : false;
 }
 
-data_queue_t *data_queue_init(int size)
+static inline int spsc_item_header(data_queue_t *q, int pos)
+{
+    int size = *(int *) ((uint8_t *) q->buffer + pos);
+    if (size != DATA_Q_SPSC_RING_MARK && (size < DATA_Q_ALLOC_HEAD_SIZE || size > q->size)) {
+        *(int*)0 = 0;
+    }
+    return size;
+}
+
+// Get position of item and its header, skip ring back marker
+static inline int spsc_item_pos(data_queue_t *q, int pos, int *size)
+{
+    *size = spsc_item_header(q, pos);
+    if (*size == DATA_Q_SPSC_RING_MARK) {
+        pos = 0;
+        *size = spsc_item_header(q, pos);
+    }
+    return pos;
+}
+
+static inline int spsc_next_pos(data_queue_t *q, int pos, int size)
+{
+    pos += DATA_Q_SPSC_ALIGN_UP(size);
+    return (pos >= q->size) ? 0 : pos;
+}
+
+static inline void spsc_notify(data_queue_t *q, int wait_bits, int event_bits)
+{
+    // Only touch event group when other side is waiting on it
+    if (MEDIA_LIB_ATOMIC_LOAD_SC(q->waiting) & wait_bits) {
+        MEDIA_LIB_ATOMIC_AND_SC(q->waiting, ~wait_bits);
+        _SET_BITS(q->event, event_bits);
+    }
+}
+
+static inline void spsc_release_user(data_queue_t *q)
+{
+    MEDIA_LIB_ATOMIC_ADD_SC(q->user, -1);
+    if (MEDIA_LIB_ATOMIC_LOAD_SC(q->quit)) {
+        data_queue_release_user(q);
+    }
+}
+
+/*   Write position never catch up read position, so wp == rp means empty
+ *   case 1:  [0...rp...wp...size]  write at wp or ring back to 0 (leave a marker at wp)
+ *   case 2:  [0...wp...rp...size]  write at wp
+ */
+static int spsc_fit_pos(data_queue_t *q, int size, bool *ring)
+{
+    int rp = MEDIA_LIB_ATOMIC_LOAD_SC(q->rp);
+    int wp = q->wp;
+    *ring = false;
+    if (wp >= rp) {
+        int left = q->size - wp;
+        if (size < left || (size == left && rp > 0)) {
+            return wp;
+        }
+        if (size < rp) {
+            *ring = true;
+            return 0;
+        }
+        return -1;
+    }
+    return (size < rp - wp) ? wp : -1;
+}
+
+static int spsc_get_available(data_queue_t *q)
+{
+    int rp = MEDIA_LIB_ATOMIC_LOAD_SC(q->rp);
+    int wp = MEDIA_LIB_ATOMIC_LOAD_SC(q->wp);
+    int avail;
+    if (wp >= rp) {
+        avail = q->size - wp - (rp ? 0 : DATA_Q_SPSC_ALIGN);
+        if (rp - DATA_Q_SPSC_ALIGN > avail) {
+            avail = rp - DATA_Q_SPSC_ALIGN;
+        }
+    } else {
+        avail = rp - wp - DATA_Q_SPSC_ALIGN;
+    }
+    if (avail > q->size / 2) {
+        avail = (q->size / 2) & ~(DATA_Q_SPSC_ALIGN - 1);
+    }
+    avail -= DATA_Q_ALLOC_HEAD_SIZE;
+    return avail > 0 ? avail : 0;
+}
+
+static int spsc_get_buffer(data_queue_t *q, int size, void **buffer, uint32_t timeout)
+{
+    size = DATA_Q_SPSC_ALIGN_UP(size + DATA_Q_ALLOC_HEAD_SIZE);
+    // Always can fit into empty queue
+    if (size > ((q->size / 2) & ~(DATA_Q_SPSC_ALIGN - 1))) {
+        return -1;
+    }
+    uint32_t wait_start = data_queue_wait_start(timeout);
+    MEDIA_LIB_ATOMIC_ADD_SC(q->user, 1);
+    // Claim writer, contention only happens for occasional writer from other thread
+    while (MEDIA_LIB_ATOMIC_XCHG_ACQ(q->writing, 1)) {
+        if (MEDIA_LIB_ATOMIC_LOAD_SC(q->quit)) {
+            spsc_release_user(q);
+            return -1;
+        }
+        if (data_queue_wait_left(wait_start, timeout) == 0) {
+            spsc_release_user(q);
+            return ESP_MEDIA_ERR_TIMEOUT;
+        }
+        media_lib_thread_sleep(1);
+    }
+    bool ring = false;
+    int ret = -1;
+    while (!MEDIA_LIB_ATOMIC_LOAD_SC(q->quit)) {
+        int pos = spsc_fit_pos(q, size, &ring);
+        if (pos >= 0) {
+            if (ring) {
+                // Reader only see marker after write position updated
+                *(int *) ((uint8_t *) q->buffer + q->wp) = DATA_Q_SPSC_RING_MARK;
+            }
+            q->reserve_pos = pos;
+            q->reserve_size = size;
+            *buffer = (uint8_t *) q->buffer + pos + DATA_Q_ALLOC_HEAD_SIZE;
+            return 0;
+        }
+        uint32_t left = data_queue_wait_left(wait_start, timeout);
+        if (left == 0) {
+            ret = ESP_MEDIA_ERR_TIMEOUT;
+            break;
+        }
+        MEDIA_LIB_ATOMIC_OR_SC(q->waiting, DATA_Q_WAIT_CONSUME);
+        if (spsc_fit_pos(q, size, &ring) < 0 && !MEDIA_LIB_ATOMIC_LOAD_SC(q->quit)) {
+            uint64_t start = _STATS_NOW(q);
+            _WAIT_BITS_TIMEOUT(q->event, DATA_Q_DATA_CONSUME_BITS, left);
+            queue_stats_producer_wait(q->stats, start);
+        }
+        MEDIA_LIB_ATOMIC_AND_SC(q->waiting, ~DATA_Q_WAIT_CONSUME);
+    }
+    MEDIA_LIB_ATOMIC_STORE_REL(q->writing, 0);
+    spsc_release_user(q);
+    return ret;
+}
+
+static int spsc_send_buffer(data_queue_t *q, int size)
 {
+    int ret = 0;
+    if (size) {
+        size += DATA_Q_ALLOC_HEAD_SIZE;
+        if (DATA_Q_SPSC_ALIGN_UP(size) <= q->reserve_size) {
+            *(int *) ((uint8_t *) q->buffer + q->reserve_pos) = size;
+            MEDIA_LIB_ATOMIC_ADD_SC(q->count, 1);
+            MEDIA_LIB_ATOMIC_ADD_SC(q->bytes, size - DATA_Q_ALLOC_HEAD_SIZE);
+            // Count before publish, consumer may pop it at once
+            queue_stats_push(q->stats, size - DATA_Q_ALLOC_HEAD_SIZE);
+            MEDIA_LIB_ATOMIC_STORE_SC(q->wp, spsc_next_pos(q, q->reserve_pos, size));
+            spsc_notify(q, DATA_Q_WAIT_DATA, DATA_Q_DATA_ARRIVE_BITS);
+        } else {
+            queue_stats_drop(q->stats);
+            ESP_LOGW(TAG, "Send %d exceed reserved %d", size - DATA_Q_ALLOC_HEAD_SIZE,
+                     q->reserve_size - DATA_Q_ALLOC_HEAD_SIZE);
+            ret = -1;
+        }
+    }
+    q->reserve_size = 0;
+    MEDIA_LIB_ATOMIC_STORE_REL(q->writing, 0);
+    spsc_release_user(q);
+    return ret;
+}
+
+static void spsc_consume_one(data_queue_t *q)
+{
+    int size;
+    int pos = spsc_item_pos(q, q->rp, &size);
+    MEDIA_LIB_ATOMIC_ADD_SC(q->count, -1);
+    MEDIA_LIB_ATOMIC_ADD_SC(q->bytes, -(size - DATA_Q_ALLOC_HEAD_SIZE));
+    queue_stats_pop(q->stats, size - DATA_Q_ALLOC_HEAD_SIZE);
+    MEDIA_LIB_ATOMIC_STORE_SC(q->rp, spsc_next_pos(q, pos, size));
+}
+
+/*   Reader claim counts read lock held by consumer, consume all from other thread claims it with -1
+ *   So that items held by reader are never consumed under it, consume all is deferred to reader instead
+ */
+static bool spsc_claim_reader(data_queue_t *q)
+{
+    int n = MEDIA_LIB_ATOMIC_LOAD_SC(q->reading);
+    while (1) {
+        if (n >= 0) {
+            if (MEDIA_LIB_ATOMIC_CAS_ACQ_REL(q->reading, n, n + 1)) {
+                return true;
+            }
+            continue;
+        }
+        if (MEDIA_LIB_ATOMIC_LOAD_SC(q->quit)) {
+            return false;
+        }
+        media_lib_thread_sleep(1);
+        n = MEDIA_LIB_ATOMIC_LOAD_SC(q->reading);
+    }
+}
+
+static void spsc_drain(data_queue_t *q)
+{
+    while (q->rp != MEDIA_LIB_ATOMIC_LOAD_SC(q->wp)) {
+        if (MEDIA_LIB_ATOMIC_LOAD_SC(q->quit)) {
+            break;
+        }
+        spsc_consume_one(q);
+    }
+    q->peek_pos = q->rp;
+    MEDIA_LIB_ATOMIC_STORE_SC(q->read_pos, q->rp);
+    spsc_notify(q, DATA_Q_WAIT_CONSUME, DATA_Q_DATA_CONSUME_BITS);
+}
+
+// Run pending consume all when no item is read locked, otherwise reader runs it on last unlock
+static void spsc_flush_pending(data_queue_t *q)
+{
+    while (MEDIA_LIB_ATOMIC_LOAD_SC(q->flush)) {
+        int n = 0;
+        if (!MEDIA_LIB_ATOMIC_CAS_ACQ_REL(q->reading, n, -1)) {
+            return;
+        }
+        if (MEDIA_LIB_ATOMIC_XCHG_ACQ_REL(q->flush, 0)) {
+            spsc_drain(q);
+        }
+        MEDIA_LIB_ATOMIC_STORE_SC(q->reading, 0);
+    }
+}
+
+static void spsc_release_reader(data_queue_t *q)
+{
+    MEDIA_LIB_ATOMIC_ADD_SC(q->reading, -1);
+    spsc_flush_pending(q);
+}
+
+static int spsc_read_lock(data_queue_t *q, void **buffer, int *size, uint32_t timeout)
+{
+    uint32_t wait_start = data_queue_wait_start(timeout);
+    int ret = -1;
+    MEDIA_LIB_ATOMIC_ADD_SC(q->user, 1);
+    while (!MEDIA_LIB_ATOMIC_LOAD_SC(q->quit)) {
+        if (spsc_claim_reader(q) == false) {
+            break;
+        }
+        if (q->read_pos != MEDIA_LIB_ATOMIC_LOAD_SC(q->wp)) {
+            int data_size;
+            int pos = spsc_item_pos(q, q->read_pos, &data_size);
+            q->peek_pos = q->read_pos;
+            MEDIA_LIB_ATOMIC_STORE_SC(q->read_pos, spsc_next_pos(q, pos, data_size));
+            *buffer = (uint8_t *) q->buffer + pos + DATA_Q_ALLOC_HEAD_SIZE;
+            *size = data_size - DATA_Q_ALLOC_HEAD_SIZE;
+            return 0;
+        }
+        spsc_release_reader(q);
+        uint32_t left = data_queue_wait_left(wait_start, timeout);
+        if (left == 0) {
+            ret = ESP_MEDIA_ERR_TIMEOUT;
+            break;
+        }
+        MEDIA_LIB_ATOMIC_OR_SC(q->waiting, DATA_Q_WAIT_DATA);
+        if (MEDIA_LIB_ATOMIC_LOAD_SC(q->read_pos) == MEDIA_LIB_ATOMIC_LOAD_SC(q->wp) && !MEDIA_LIB_ATOMIC_LOAD_SC(q->quit)) {
+            uint64_t start = _STATS_NOW(q);
+            _WAIT_BITS_TIMEOUT(q->event, DATA_Q_DATA_ARRIVE_BITS, left);
+            queue_stats_consumer_wait(q->stats, start);
+        }
+        MEDIA_LIB_ATOMIC_AND_SC(q->waiting, ~DATA_Q_WAIT_DATA);
+    }
+    spsc_release_user(q);
+    return ret;
+}
+
+static int spsc_read_lock_batch(data_queue_t *q, data_queue_iov_t iov[], int max, int *n)
+{
+    int ret = spsc_read_lock(q, &iov[0].buffer, &iov[0].size, MEDIA_LIB_MAX_LOCK_TIME);
+    if (ret != 0) {
+        return ret;
+    }
+    int num = 1;
+    int wp = MEDIA_LIB_ATOMIC_LOAD_SC(q->wp);
+    while (num < max && q->read_pos != wp) {
+        int data_size;
+        int pos = spsc_item_pos(q, q->read_pos, &data_size);
+        MEDIA_LIB_ATOMIC_STORE_SC(q->read_pos, spsc_next_pos(q, pos, data_size));
+        iov[num].buffer = (uint8_t *) q->buffer + pos + DATA_Q_ALLOC_HEAD_SIZE;
+        iov[num].size = data_size - DATA_Q_ALLOC_HEAD_SIZE;
+        num++;
+    }
+    *n = num;
+    return 0;
+}
+
+// Consume up to n items, unlock without read lock is allowed to drop item directly
+static int spsc_read_unlock_batch(data_queue_t *q, int n)
+{
+    // Only consumer thread changes positive claim, so it tells whether read lock is held
+    bool locked = MEDIA_LIB_ATOMIC_LOAD_SC(q->reading) > 0;
+    if (locked == false && spsc_claim_reader(q) == false) {
+        return -1;
+    }
+    int consumed = 0;
+    while (consumed < n && q->rp != MEDIA_LIB_ATOMIC_LOAD_SC(q->wp)) {
+        int rp = q->rp;
+        spsc_consume_one(q);
+        // Consumed without read lock
+        if (q->read_pos == rp) {
+            MEDIA_LIB_ATOMIC_STORE_SC(q->read_pos, q->rp);
+        }
+        consumed++;
+    }
+    if (consumed) {
+        spsc_notify(q, DATA_Q_WAIT_CONSUME, DATA_Q_DATA_CONSUME_BITS);
+    }
+    spsc_release_reader(q);
+    if (locked) {
+        spsc_release_user(q);
+    }
+    return 0;
+}
+
+static int spsc_read_unlock(data_queue_t *q)
+{
+    return spsc_read_unlock_batch(q, 1);
+}
+
+static int spsc_peek_unlock(data_queue_t *q)
+{
+    if (MEDIA_LIB_ATOMIC_LOAD_SC(q->reading) <= 0) {
+        return -1;
+    }
+    MEDIA_LIB_ATOMIC_STORE_SC(q->read_pos, q->peek_pos);
+    spsc_release_reader(q);
+    spsc_release_user(q);
+    return 0;
+}
+
+static int spsc_consume_all(data_queue_t *q)
+{
+    MEDIA_LIB_ATOMIC_STORE_SC(q->flush, 1);
+    spsc_flush_pending(q);
+    return 0;
+}
+
+// Get payload size of item, pool mode keep it in second header word
+static inline int data_queue_item_size(data_queue_t *q, uint8_t *item)
+{
+    if (q->block_size) {
+        return *((int *) item + 1);
+    }
+    return *((int *) item) - DATA_Q_ALLOC_HEAD_SIZE;
+}
+
+// Retire item at read pointer, need hold lock and have data
+static int data_queue_consume_item(data_queue_t *q)
+{
+    uint8_t *buffer = (uint8_t *) q->buffer + q->rp;
+    int size = *((int *) buffer);
+    if (size < 0 || size >q->size) {
+        *(int*)0 = 0;
+    }
+    int data_size = data_queue_item_size(q, buffer);
+    q->rp += size;
+    if (q->fill_end && q->rp >= q->fill_end) {
+        q->fill_end = 0;
+        q->rp = 0;
+    }
+    q->count--;
+    q->bytes -= data_size;
+    queue_stats_pop(q->stats, data_size);
+    return size;
+}
+
+static void *data_queue_alloc_buffer(data_queue_t *q, int size, data_queue_mem_t mem, uint8_t align)
+{
+#ifdef ESP_PLATFORM
+    uint32_t caps = 0;
+    if (mem == DATA_QUEUE_MEM_INTERNAL) {
+        caps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+    } else if (mem == DATA_QUEUE_MEM_PSRAM) {
+        caps = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+    }
+    if (caps) {
+        void *buffer = align ? heap_caps_aligned_alloc(align, size, caps) : heap_caps_malloc(size, caps);
+        if (buffer) {
+            q->buffer_type = DATA_Q_BUFFER_CAPS;
+            return buffer;
+        }
+        // Placement is only a hint, fallback to default heap
+    }
+#endif
+    if (align) {
+        q->buffer_type = DATA_Q_BUFFER_ALIGN;
+        return media_lib_malloc_align(size, align);
+    }
+    q->buffer_type = DATA_Q_BUFFER_MALLOC;
+    return media_lib_malloc(size);
+}
+
+static void data_queue_free_buffer(data_queue_t *q)
+{
+    switch (q->buffer_type) {
+#ifdef ESP_PLATFORM
+        case DATA_Q_BUFFER_CAPS:
+            heap_caps_free(q->buffer);
+            break;
+#endif
+        case DATA_Q_BUFFER_ALIGN:
+            media_lib_free_align(q->buffer);
+            break;
+        default:
+            media_lib_free(q->buffer);
+            break;
+    }
+}
+
+data_queue_t *data_queue_init_with_cfg(data_queue_cfg_t *cfg)
+{
+    if (cfg == NULL || (cfg->align & (cfg->align - 1))) {
+        return NULL;
+    }
+    int size = cfg->size;
+    int head_size = DATA_Q_ALLOC_HEAD_SIZE;
+    int block_stride = 0;
+    if (cfg->block_size) {
+        // Pool mode work on mutex ring only
+        if (cfg->spsc || cfg->block_size < 0 || cfg->block_num <= 0) {
+            return NULL;
+        }
+        // Keep payload aligned when header size equal to alignment
+        int block_align = cfg->align > DATA_Q_SPSC_ALIGN ? cfg->align : DATA_Q_SPSC_ALIGN;
+        head_size = cfg->align > DATA_Q_POOL_HEAD_SIZE ? cfg->align : DATA_Q_POOL_HEAD_SIZE;
+        block_stride = DATA_Q_ALIGN_UP(cfg->block_size + head_size, block_align);
+        size = block_stride * cfg->block_num;
+    } else if (cfg->spsc) {
+        size &= ~(DATA_Q_SPSC_ALIGN - 1);
+    }
+    if (size <= 0) {
+        return NULL;
+    }
     data_queue_t *q = media_lib_calloc(1, sizeof(data_queue_t));
     if (q == NULL) {
         return NULL;
     }
-    q->buffer = media_lib_malloc(size);
-    media_lib_mutex_create(&q->lock);
-    media_lib_mutex_create(&q->write_lock);
+    q->buffer = data_queue_alloc_buffer(q, size, cfg->mem, cfg->align);
+    if (cfg->spsc == false) {
+        media_lib_mutex_create(&q->lock);
+        media_lib_mutex_create(&q->write_lock);
+    }
     media_lib_event_group_create(&q->event);
-    if (q->buffer == NULL || q->lock == NULL || q->write_lock == NULL || q->event == NULL) {
+    if (q->buffer == NULL || q->event == NULL ||
+        (cfg->spsc == false && (q->lock == NULL || q->write_lock == NULL))) {
         data_queue_deinit(q);
         return NULL;
     }
     q->size = size;
+    q->spsc = cfg->spsc;
+    q->head_size = head_size;
+    q->block_size = cfg->block_size;
+    q->block_stride = block_stride;
     return q;
 }
 
+data_queue_t *data_queue_init(int size)
+{
+    data_queue_cfg_t cfg = {
+        .size = size,
+    };
+    return data_queue_init_with_cfg(&cfg);
+}
+
+data_queue_t *data_queue_init_spsc(int size)
+{
+    data_queue_cfg_t cfg = {
+        .size = size,
+        .spsc = true,
+    };
+    return data_queue_init_with_cfg(&cfg);
+}
+
 void data_queue_wakeup(data_queue_t *q)
 {
+    if (q && q->spsc) {
+        MEDIA_LIB_ATOMIC_STORE_SC(q->quit, 1);
+        _SET_BITS(q->event, DATA_Q_DATA_ARRIVE_BITS | DATA_Q_DATA_CONSUME_BITS);
+        while (MEDIA_LIB_ATOMIC_LOAD_SC(q->user)) {
+            _WAIT_BITS(q->event, DATA_Q_USER_FREE_BITS);
+        }
+        return;
+    }
     if (q && q->lock) {
         _MUTEX_LOCK(q->lock);
         q->quit = 1;
@@ -137,23 +657,16 @@ void data_queue_wakeup(data_queue_t *q)
 
 int data_queue_consume_all(data_queue_t *q)
 {
+    if (q && q->spsc) {
+        return spsc_consume_all(q);
+    }
     if (q && q->lock) {
         _MUTEX_LOCK(q->lock);
         while (_data_queue_have_data(q)) {
             if (q->quit) {
                 break;
             }
-            uint8_t *buffer = (uint8_t *) q->buffer + q->rp;
-            int size = *((int *) buffer);
-            if (size < 0 || size >= q->size) {
-                *(int*)0 = 0;
-            }
-            q->rp += size;
-            q->filled -= size;
-            if (q->fill_end && q->rp >= q->fill_end) {
-                q->fill_end = 0;
-                q->rp = 0;
-            }
+            q->filled -= data_queue_consume_item(q);
             data_queue_data_consumed(q);
         }
         _MUTEX_UNLOCK(q->lock);
@@ -161,11 +674,23 @@ int data_queue_consume_all(data_queue_t *q)
     return 0;
 }
 
+int data_queue_enable_stats(data_queue_t *q, const char *name)
+{
+    if (q == NULL) {
+        return -1;
+    }
+    if (q->stats == NULL) {
+        q->stats = queue_stats_register(name, QUEUE_STATS_TYPE_DATA_QUEUE);
+    }
+    return q->stats ? 0 : -1;
+}
+
 void data_queue_deinit(data_queue_t *q)
 {
     if (q == NULL) {
         return;
     }
+    queue_stats_unregister(q->stats);
     if (q->lock) {
         media_lib_mutex_destroy((media_lib_mutex_handle_t) q->lock);
     }
@@ -176,7 +701,7 @@ void data_queue_deinit(data_queue_t *q)
         media_lib_event_group_destroy((media_lib_mutex_handle_t) q->event);
     }
     if (q->buffer) {
-        media_lib_free(q->buffer);
+        data_queue_free_buffer(q);
     }
     media_lib_free(q);
 }
@@ -204,6 +729,9 @@ int data_queue_get_available(data_queue_t *q)
     if (q == NULL) {
         return 0;
     }
+    if (q->spsc) {
+        return spsc_get_available(q);
+    }
     _MUTEX_LOCK(q->lock);
     int avail;
     // Handle corner case [0 rp==wp fifo_end]
@@ -213,7 +741,9 @@ int data_queue_get_available(data_queue_t *q)
     } else {
         avail = get_available_size(q);
     }
-    if (avail >= DATA_Q_ALLOC_HEAD_SIZE) {
+    if (q->block_size) {
+        avail = (avail >= q->block_stride) ? q->block_size : 0;
+    } else if (avail >= DATA_Q_ALLOC_HEAD_SIZE) {
         avail -= DATA_Q_ALLOC_HEAD_SIZE;
     } else {
         avail = 0;
@@ -222,13 +752,30 @@ int data_queue_get_available(data_queue_t *q)
     return avail;
 }
 
-void *data_queue_get_buffer(data_queue_t *q, int size)
+int data_queue_get_buffer_timeout(data_queue_t *q, int size, void **buffer, uint32_t timeout)
 {
     int avail = 0;
-    size += DATA_Q_ALLOC_HEAD_SIZE;
-    if (q == NULL || size > q->size) {
-        return NULL;
+    int ret = -1;
+    if (q == NULL || buffer == NULL) {
+        return -1;
+    }
+    *buffer = NULL;
+    if (q->spsc) {
+        return spsc_get_buffer(q, size, buffer, timeout);
     }
+    if (q->block_size) {
+        // Pool mode always take one whole block
+        if (size > q->block_size) {
+            return -1;
+        }
+        size = q->block_stride;
+    } else {
+        size += DATA_Q_ALLOC_HEAD_SIZE;
+    }
+    if (size > q->size) {
+        return -1;
+    }
+    uint32_t wait_start = data_queue_wait_start(timeout);
     _MUTEX_LOCK(q->write_lock);
     _MUTEX_LOCK(q->lock);
     while (!q->quit) {
@@ -243,19 +790,30 @@ void *data_queue_get_buffer(data_queue_t *q, int size)
             avail = get_available_size(q);
         }
         if (avail >= size) {
-            uint8_t *buffer = (uint8_t *) q->buffer + q->wp;
+            *buffer = (uint8_t *) q->buffer + q->wp + q->head_size;
             q->user++;
             _MUTEX_UNLOCK(q->lock);
-            return buffer + DATA_Q_ALLOC_HEAD_SIZE;
+            return 0;
+        }
+        uint32_t left = data_queue_wait_left(wait_start, timeout);
+        if (left == 0) {
+            ret = ESP_MEDIA_ERR_TIMEOUT;
+            break;
         }
-        int ret = data_queue_wait_consume(q);
-        if (ret != 0) {
+        if (data_queue_wait_consume(q, left) != 0) {
             break;
         }
     }
     _MUTEX_UNLOCK(q->lock);
     _MUTEX_UNLOCK(q->write_lock);
-    return NULL;
+    return ret;
+}
+
+void *data_queue_get_buffer(data_queue_t *q, int size)
+{
+    void *buffer = NULL;
+    data_queue_get_buffer_timeout(q, size, &buffer, MEDIA_LIB_MAX_LOCK_TIME);
+    return buffer;
 }
 
 void *data_queue_get_write_data(data_queue_t *q)
@@ -263,10 +821,13 @@ void *data_queue_get_write_data(data_queue_t *q)
     if (q == NULL) {
         return NULL;
     }
+    if (q->spsc) {
+        return q->reserve_size ? (uint8_t *) q->buffer + q->reserve_pos + DATA_Q_ALLOC_HEAD_SIZE : NULL;
+    }
     _MUTEX_LOCK(q->lock);
     uint8_t *buffer = (uint8_t *) q->buffer + q->wp;
     _MUTEX_UNLOCK(q->lock);
-    return buffer + DATA_Q_ALLOC_HEAD_SIZE;
+    return buffer + q->head_size;
 }
 
 int data_queue_send_buffer(data_queue_t *q, int size)
@@ -275,6 +836,9 @@ int data_queue_send_buffer(data_queue_t *q, int size)
     if (q == NULL) {
         return -1;
     }
+    if (q->spsc) {
+        return spsc_send_buffer(q, size);
+    }
     _MUTEX_LOCK(q->lock);
     if (size == 0) {
         q->user--;
@@ -283,16 +847,27 @@ int data_queue_send_buffer(data_queue_t *q, int size)
         _MUTEX_UNLOCK(q->write_lock);
         return 0;
     }
-    size += DATA_Q_ALLOC_HEAD_SIZE;
+    int data_size = size;
+    if (q->block_size) {
+        size = (data_size <= q->block_size) ? q->block_stride : q->size + 1;
+    } else {
+        size += DATA_Q_ALLOC_HEAD_SIZE;
+    }
     if (get_available_size(q) >= size) {
         uint8_t *buffer = (uint8_t *) q->buffer + q->wp;
         *((int *) buffer) = size;
+        if (q->block_size) {
+            *((int *) buffer + 1) = data_size;
+        }
         if (size < 0 || size > q->size) {
             *(int*)0 = 0;
         }
         q->wp += size;
         q->filled += size;
+        q->count++;
+        q->bytes += data_size;
         q->user--;
+        queue_stats_push(q->stats, data_size);
         data_queue_notify_data(q);
         data_queue_release_user(q);
         _MUTEX_UNLOCK(q->lock);
@@ -301,6 +876,7 @@ int data_queue_send_buffer(data_queue_t *q, int size)
     } else {
         q->user--;
         data_queue_release_user(q);
+        queue_stats_drop(q->stats);
         printf("Release for avail %d\n", get_available_size(q));
         _MUTEX_UNLOCK(q->lock);
         _MUTEX_UNLOCK(q->write_lock);
@@ -314,6 +890,9 @@ bool data_queue_have_data(data_queue_t *q)
     if (q == NULL) {
         return has_data;
     }
+    if (q->spsc) {
+        return !MEDIA_LIB_ATOMIC_LOAD_SC(q->quit) && MEDIA_LIB_ATOMIC_LOAD_SC(q->rp) != MEDIA_LIB_ATOMIC_LOAD_SC(q->wp);
+    }
     _MUTEX_LOCK(q->lock);
     if (!q->quit) {
         has_data = _data_queue_have_data(q);
@@ -322,35 +901,87 @@ bool data_queue_have_data(data_queue_t *q)
     return has_data;
 }
 
-int data_queue_read_lock(data_queue_t *q, void **buffer, int *size)
+// Lock next item after items already read locked, need hold lock and have data
+static void data_queue_lock_item(data_queue_t *q, void **buffer, int *size)
+{
+    int cur_rp;
+    if (q->filled <= q->wp) {
+        cur_rp = q->wp - q->filled;
+    } else {
+        cur_rp = q->wp + q->fill_end - q->filled;
+    }
+    uint8_t *data_buffer = (uint8_t *) q->buffer + cur_rp;
+    int data_size = *((int *) data_buffer);
+    if (data_size < 0 || data_size >q->size) {
+        *(int*)0 = 0;
+    }
+    q->filled -= data_size;
+    *buffer = data_buffer + q->head_size;
+    *size = data_queue_item_size(q, data_buffer);
+}
+
+int data_queue_read_lock_timeout(data_queue_t *q, void **buffer, int *size, uint32_t timeout)
 {
     int ret = -1;
     if (q == NULL) {
         return -1;
     }
+    if (q->spsc) {
+        return spsc_read_lock(q, buffer, size, timeout);
+    }
+    uint32_t wait_start = data_queue_wait_start(timeout);
     _MUTEX_LOCK(q->lock);
     while (!q->quit) {
         if (_data_queue_have_data_from_last(q) == false) {
-            if (data_queue_wait_data(q) != 0) {
+            uint32_t left = data_queue_wait_left(wait_start, timeout);
+            if (left == 0) {
+                ret = ESP_MEDIA_ERR_TIMEOUT;
+                break;
+            }
+            if (data_queue_wait_data(q, left) != 0) {
                 ret = -1;
                 break;
             }
             continue;
         }
-        int cur_rp;
-        if (q->filled <= q->wp) {
-           cur_rp = q->wp - q->filled;
-        } else {
-            cur_rp = q->wp + q->fill_end - q->filled;
+        data_queue_lock_item(q, buffer, size);
+        q->user++;
+        ret = 0;
+        break;
+    }
+    _MUTEX_UNLOCK(q->lock);
+    return ret;
+}
+
+int data_queue_read_lock(data_queue_t *q, void **buffer, int *size)
+{
+    return data_queue_read_lock_timeout(q, buffer, size, MEDIA_LIB_MAX_LOCK_TIME);
+}
+
+int data_queue_read_lock_batch(data_queue_t *q, data_queue_iov_t iov[], int max, int *n)
+{
+    int ret = -1;
+    if (q == NULL || iov == NULL || max <= 0 || n == NULL) {
+        return -1;
+    }
+    *n = 0;
+    if (q->spsc) {
+        return spsc_read_lock_batch(q, iov, max, n);
+    }
+    _MUTEX_LOCK(q->lock);
+    while (!q->quit) {
+        if (_data_queue_have_data_from_last(q) == false) {
+            if (data_queue_wait_data(q, MEDIA_LIB_MAX_LOCK_TIME) != 0) {
+                ret = -1;
+                break;
+            }
+            continue;
         }
-        uint8_t *data_buffer = (uint8_t *) q->buffer + cur_rp;
-        int data_size = *((int *) data_buffer);
-        if (data_size < 0 || data_size >q->size) {
-            *(int*)0 = 0;
+        while (*n < max && _data_queue_have_data_from_last(q)) {
+            data_queue_lock_item(q, &iov[*n].buffer, &iov[*n].size);
+            (*n)++;
         }
-        q->filled -= data_size;
-        *buffer = data_buffer + DATA_Q_ALLOC_HEAD_SIZE;
-        *size = data_size - DATA_Q_ALLOC_HEAD_SIZE;
+        // Whole batch hold one reference
         q->user++;
         ret = 0;
         break;
@@ -362,6 +993,9 @@ int data_queue_read_lock(data_queue_t *q, void **buffer, int *size)
 int data_queue_peek_unlock(data_queue_t *q)
 {
     int ret = -1;
+    if (q && q->spsc) {
+        return spsc_peek_unlock(q);
+    }
     if (q) {
         _MUTEX_LOCK(q->lock);
         q->user--;
@@ -374,19 +1008,13 @@ int data_queue_peek_unlock(data_queue_t *q)
 int data_queue_read_unlock(data_queue_t *q)
 {
     int ret = -1;
+    if (q && q->spsc) {
+        return spsc_read_unlock(q);
+    }
     if (q) {
         _MUTEX_LOCK(q->lock);
         if (_data_queue_have_data(q)) {
-            uint8_t *buffer = (uint8_t *) q->buffer + q->rp;
-            int size = *((int *) buffer);
-            if (size < 0 || size >q->size) {
-                *(int*)0 = 0;
-            }
-            q->rp += size;
-            if (q->fill_end && q->rp >= q->fill_end) {
-                q->fill_end = 0;
-                q->rp = 0;
-            }
+            data_queue_consume_item(q);
             q->user--;
             data_queue_data_consumed(q);
             data_queue_release_user(q);
@@ -397,28 +1025,41 @@ int data_queue_read_unlock(data_queue_t *q)
     return ret;
 }
 
+int data_queue_read_unlock_batch(data_queue_t *q, int n)
+{
+    if (q == NULL || n <= 0) {
+        return -1;
+    }
+    if (q->spsc) {
+        return spsc_read_unlock_batch(q, n);
+    }
+    _MUTEX_LOCK(q->lock);
+    int consumed = 0;
+    while (consumed < n && _data_queue_have_data(q)) {
+        data_queue_consume_item(q);
+        consumed++;
+    }
+    if (consumed) {
+        q->user--;
+        data_queue_data_consumed(q);
+        data_queue_release_user(q);
+    }
+    _MUTEX_UNLOCK(q->lock);
+    return 0;
+}
+
 int data_queue_query(data_queue_t *q, int *q_num, int *q_size)
 {
+    if (q && q->spsc) {
+        *q_num = MEDIA_LIB_ATOMIC_LOAD_SC(q->count);
+        *q_size = MEDIA_LIB_ATOMIC_LOAD_SC(q->bytes);
+        return 0;
+    }
     if (q) {
+        // Counters are updated on send and consume, no need to walk items
         _MUTEX_LOCK(q->lock);
-        *q_num = *q_size = 0;
-        if (_data_queue_have_data(q)) {
-            int rp = q->rp;
-            int ring = q->fill_end;
-            while (rp != q->wp || ring) {
-                int size = *(int *) (q->buffer + rp);
-                if (size < 0 || size > q->size) {
-                    *(int*)0 = 0;
-                }
-                rp += size;
-                if (ring && rp == ring) {
-                    ring = 0;
-                    rp = 0;
-                }
-                (*q_num)++;
-                (*q_size) += size - DATA_Q_ALLOC_HEAD_SIZE;
-            }
-        }
+        *q_num = q->count;
+        *q_size = q->bytes;
         _MUTEX_UNLOCK(q->lock);
     }
     return 0;
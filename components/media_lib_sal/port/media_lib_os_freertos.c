@@ -25,6 +25,8 @@
  *
  */
 
+#ifdef ESP_PLATFORM
+
 #include <stdlib.h>
 #include <string.h>
 #include "freertos/FreeRTOS.h"
@@ -538,3 +540,5 @@ esp_err_t media_lib_add_default_os_adapter(void)
     };
     return media_lib_os_register(&os_lib);
 }
+
+#endif
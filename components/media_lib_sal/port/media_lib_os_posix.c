@@ -0,0 +1,422 @@
+/**
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2025 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+/* OS adapter for POSIX hosts, allow media_lib_sal users to run on Linux without FreeRTOS */
+#ifndef ESP_PLATFORM
+
+// Need for pthread_setname_np on glibc
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#if defined(__GLIBC__)
+#include <execinfo.h>
+#endif
+#include "media_lib_adapter.h"
+#include "media_lib_os_reg.h"
+#include "media_lib_os.h"
+
+#define RETURN_ON_NULL_HANDLE(h)                                               \
+    if (h == NULL) {                                                           \
+        return ESP_ERR_INVALID_ARG;                                            \
+    }
+
+typedef struct {
+    void (*body)(void *arg);
+    void  *arg;
+} posix_thread_ctx_t;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    uint32_t        value;
+} posix_sync_t;
+
+static void *_malloc_align(size_t size, uint8_t align)
+{
+    void *buf = NULL;
+    if (!align || ((align & (align - 1)) != 0)) {
+        return NULL;
+    }
+    if (align < sizeof(void *)) {
+        align = sizeof(void *);
+    }
+    if (posix_memalign(&buf, align, size) != 0) {
+        return NULL;
+    }
+    return buf;
+}
+
+static int _get_stack_frame(void **addr, int n)
+{
+#if defined(__GLIBC__)
+    return backtrace(addr, n);
+#else
+    return 0;
+#endif
+}
+
+static void *thread_entry(void *arg)
+{
+    posix_thread_ctx_t ctx = *(posix_thread_ctx_t *)arg;
+    free(arg);
+    ctx.body(ctx.arg);
+    return NULL;
+}
+
+static int _thread_create(media_lib_thread_handle_t *handle, const char *name,
+                          void(*body)(void *arg), void *arg, uint32_t stack_size,
+                          int prio, int core)
+{
+    posix_thread_ctx_t *ctx = (posix_thread_ctx_t *)malloc(sizeof(posix_thread_ctx_t));
+    if (ctx == NULL) {
+        return ESP_FAIL;
+    }
+    ctx->body = body;
+    ctx->arg = arg;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    // Host stack usage is higher than target, never go below system minimum
+    if (stack_size < PTHREAD_STACK_MIN * 4) {
+        stack_size = PTHREAD_STACK_MIN * 4;
+    }
+    pthread_attr_setstacksize(&attr, stack_size);
+    pthread_t thread;
+    int ret = pthread_create(&thread, &attr, thread_entry, ctx);
+    pthread_attr_destroy(&attr);
+    if (ret != 0) {
+        printf("Fail to create thread %s ret %d\n", name ? name : "", ret);
+        free(ctx);
+        return ESP_FAIL;
+    }
+#if defined(__linux__)
+    if (name) {
+        // Thread name limited to 16 bytes include terminator
+        char short_name[16];
+        strncpy(short_name, name, sizeof(short_name) - 1);
+        short_name[sizeof(short_name) - 1] = 0;
+        pthread_setname_np(thread, short_name);
+    }
+#endif
+    if (handle) {
+        *handle = (media_lib_thread_handle_t)(uintptr_t)thread;
+    }
+    return ESP_OK;
+}
+
+static void _thread_destroy(media_lib_thread_handle_t handle)
+{
+    // Only support destroy self, thread is detached so resource is freed after exit
+    if (handle == NULL || (pthread_t)(uintptr_t)handle == pthread_self()) {
+        pthread_exit(NULL);
+    }
+}
+
+static bool _thread_set_priority(media_lib_thread_handle_t handle, int prio)
+{
+    // Priority change need privilege on host, just ignore it
+    return true;
+}
+
+static void _thread_sleep(uint32_t ms)
+{
+    struct timespec ts = {
+        .tv_sec = ms / 1000,
+        .tv_nsec = (ms % 1000) * 1000000,
+    };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+static void get_abs_time(struct timespec *ts, uint32_t timeout)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    uint64_t nsec = (uint64_t)ts->tv_nsec + (uint64_t)(timeout % 1000) * 1000000;
+    ts->tv_sec += timeout / 1000 + nsec / 1000000000;
+    ts->tv_nsec = nsec % 1000000000;
+}
+
+static posix_sync_t *sync_create(void)
+{
+    posix_sync_t *s = (posix_sync_t *)calloc(1, sizeof(posix_sync_t));
+    if (s == NULL) {
+        return NULL;
+    }
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&s->mutex, NULL);
+    pthread_cond_init(&s->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    return s;
+}
+
+// Wait until condition reached, return false if timeout
+static bool sync_wait(posix_sync_t *s, bool (*reached)(posix_sync_t *s, uint32_t arg), uint32_t arg, uint32_t timeout)
+{
+    struct timespec ts;
+    if (timeout != MEDIA_LIB_MAX_LOCK_TIME) {
+        get_abs_time(&ts, timeout);
+    }
+    while (reached(s, arg) == false) {
+        if (timeout == MEDIA_LIB_MAX_LOCK_TIME) {
+            pthread_cond_wait(&s->cond, &s->mutex);
+        } else if (pthread_cond_timedwait(&s->cond, &s->mutex, &ts) == ETIMEDOUT) {
+            return reached(s, arg);
+        }
+    }
+    return true;
+}
+
+static void sync_destroy(posix_sync_t *s)
+{
+    pthread_cond_destroy(&s->cond);
+    pthread_mutex_destroy(&s->mutex);
+    free(s);
+}
+
+static int _sema_create(media_lib_sema_handle_t *sema)
+{
+    if (sema) {
+        // Binary semaphore with initial count 0 same as target
+        *sema = (media_lib_sema_handle_t)sync_create();
+        if (*sema != NULL) {
+            return ESP_OK;
+        }
+    }
+    return ESP_FAIL;
+}
+
+static bool sema_available(posix_sync_t *s, uint32_t arg)
+{
+    return s->value > 0;
+}
+
+static int _sema_lock_timeout(media_lib_sema_handle_t sema, uint32_t timeout)
+{
+    RETURN_ON_NULL_HANDLE(sema);
+    posix_sync_t *s = (posix_sync_t *)sema;
+    pthread_mutex_lock(&s->mutex);
+    bool ok = sync_wait(s, sema_available, 0, timeout);
+    if (ok) {
+        s->value--;
+    }
+    pthread_mutex_unlock(&s->mutex);
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+static int _sema_unlock(media_lib_sema_handle_t sema)
+{
+    RETURN_ON_NULL_HANDLE(sema);
+    posix_sync_t *s = (posix_sync_t *)sema;
+    pthread_mutex_lock(&s->mutex);
+    s->value = 1;
+    pthread_cond_signal(&s->cond);
+    pthread_mutex_unlock(&s->mutex);
+    return ESP_OK;
+}
+
+static int _sema_destroy(media_lib_sema_handle_t sema)
+{
+    RETURN_ON_NULL_HANDLE(sema);
+    sync_destroy((posix_sync_t *)sema);
+    return ESP_OK;
+}
+
+static int _mutex_create(media_lib_mutex_handle_t *mutex)
+{
+    if (mutex == NULL) {
+        return ESP_FAIL;
+    }
+    pthread_mutex_t *m = (pthread_mutex_t *)malloc(sizeof(pthread_mutex_t));
+    if (m == NULL) {
+        return ESP_FAIL;
+    }
+    // Recursive mutex same as target
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(m, &attr);
+    pthread_mutexattr_destroy(&attr);
+    *mutex = (media_lib_mutex_handle_t)m;
+    return ESP_OK;
+}
+
+static int _mutex_lock_timeout(media_lib_mutex_handle_t mutex, uint32_t timeout)
+{
+    RETURN_ON_NULL_HANDLE(mutex);
+    pthread_mutex_t *m = (pthread_mutex_t *)mutex;
+    if (timeout == MEDIA_LIB_MAX_LOCK_TIME) {
+        return pthread_mutex_lock(m) == 0 ? ESP_OK : ESP_FAIL;
+    }
+#if defined(__linux__)
+    // pthread_mutex_timedlock only accept realtime clock
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t nsec = (uint64_t)ts.tv_nsec + (uint64_t)(timeout % 1000) * 1000000;
+    ts.tv_sec += timeout / 1000 + nsec / 1000000000;
+    ts.tv_nsec = nsec % 1000000000;
+    return pthread_mutex_timedlock(m, &ts) == 0 ? ESP_OK : ESP_FAIL;
+#else
+    for (uint32_t i = 0; i <= timeout; i++) {
+        if (pthread_mutex_trylock(m) == 0) {
+            return ESP_OK;
+        }
+        _thread_sleep(1);
+    }
+    return ESP_FAIL;
+#endif
+}
+
+static int _mutex_unlock(media_lib_mutex_handle_t mutex)
+{
+    RETURN_ON_NULL_HANDLE(mutex);
+    return pthread_mutex_unlock((pthread_mutex_t *)mutex) == 0 ? ESP_OK : ESP_FAIL;
+}
+
+static int _mutex_destroy(media_lib_mutex_handle_t mutex)
+{
+    RETURN_ON_NULL_HANDLE(mutex);
+    pthread_mutex_destroy((pthread_mutex_t *)mutex);
+    free(mutex);
+    return ESP_OK;
+}
+
+static int _enter_critical(void)
+{
+    return ESP_OK;
+}
+
+static int _leave_critical(void)
+{
+    return ESP_OK;
+}
+
+static int _event_group_create(media_lib_event_grp_handle_t *group)
+{
+    RETURN_ON_NULL_HANDLE(group);
+    *group = (media_lib_event_grp_handle_t)sync_create();
+    return *group ? ESP_OK : ESP_FAIL;
+}
+
+static uint32_t _event_group_set_bits(media_lib_event_grp_handle_t group, uint32_t bits)
+{
+    RETURN_ON_NULL_HANDLE(group);
+    posix_sync_t *s = (posix_sync_t *)group;
+    pthread_mutex_lock(&s->mutex);
+    s->value |= bits;
+    uint32_t value = s->value;
+    pthread_cond_broadcast(&s->cond);
+    pthread_mutex_unlock(&s->mutex);
+    return value;
+}
+
+static uint32_t _event_group_clr_bits(media_lib_event_grp_handle_t group, uint32_t bits)
+{
+    RETURN_ON_NULL_HANDLE(group);
+    posix_sync_t *s = (posix_sync_t *)group;
+    pthread_mutex_lock(&s->mutex);
+    // Return bits before clear same as target
+    uint32_t value = s->value;
+    s->value &= ~bits;
+    pthread_mutex_unlock(&s->mutex);
+    return value;
+}
+
+static bool event_bits_reached(posix_sync_t *s, uint32_t bits)
+{
+    return (s->value & bits) == bits;
+}
+
+static uint32_t _event_group_wait_bits(media_lib_event_grp_handle_t group,
+                                       uint32_t bits, uint32_t timeout)
+{
+    RETURN_ON_NULL_HANDLE(group);
+    posix_sync_t *s = (posix_sync_t *)group;
+    pthread_mutex_lock(&s->mutex);
+    // Wait for all bits and not clear on exit same as target
+    sync_wait(s, event_bits_reached, bits, timeout);
+    uint32_t value = s->value;
+    pthread_mutex_unlock(&s->mutex);
+    return value;
+}
+
+static int _event_group_destroy(media_lib_event_grp_handle_t group)
+{
+    RETURN_ON_NULL_HANDLE(group);
+    sync_destroy((posix_sync_t *)group);
+    return ESP_OK;
+}
+
+esp_err_t media_lib_add_default_os_adapter(void)
+{
+    media_lib_os_t os_lib = {
+        .malloc = malloc,
+        .free = free,
+        .calloc = calloc,
+        .realloc = realloc,
+        .malloc_align = _malloc_align,
+        .free_align = free,
+        .strdup = strdup,
+        .get_stack_frame = _get_stack_frame,
+
+        .thread_create = _thread_create,
+        .thread_destroy = _thread_destroy,
+        .thread_set_prio = _thread_set_priority,
+        .thread_sleep = _thread_sleep,
+
+        .sema_create = _sema_create,
+        .sema_lock   = _sema_lock_timeout,
+        .sema_unlock = _sema_unlock,
+        .sema_destroy = _sema_destroy,
+
+        .mutex_create = _mutex_create,
+        .mutex_lock =   _mutex_lock_timeout,
+        .mutex_unlock = _mutex_unlock,
+        .mutex_destroy = _mutex_destroy,
+
+        .enter_critical = _enter_critical,
+        .leave_critical = _leave_critical,
+
+        .group_create = _event_group_create,
+        .group_set_bits = _event_group_set_bits,
+        .group_clr_bits = _event_group_clr_bits,
+        .group_wait_bits = _event_group_wait_bits,
+        .group_destroy = _event_group_destroy,
+    };
+    return media_lib_os_register(&os_lib);
+}
+
+#endif
@@ -23,12 +23,14 @@
  */
 
 #include "msg_q.h"
+#include "queue_stats.h"
 #include "string.h"
 #include "stdio.h"
 #include "stdlib.h"
 #include <unistd.h>
 #include "pthread.h"
 #include "stdbool.h"
+#include "stdint.h"
 
 typedef struct msg_q_t {
    pthread_mutex_t data_mutex;
@@ -42,46 +44,38 @@ typedef struct msg_q_t {
    bool            quit;
    bool            reset;
    int             user;
+   queue_stats_t*  stats;
 } msg_q_t;
 
-msg_q_handle_t msg_q_create(int msg_number, int msg_size) {
-    msg_q_t* q = (msg_q_t*)calloc(1, sizeof(msg_q_t));
+msg_q_handle_t msg_q_create_by_name(const char* name, int msg_size, int msg_number) {
     if (msg_size == 0 || msg_number == 0) {
         return NULL;
     }
+    msg_q_t* q = (msg_q_t*)calloc(1, sizeof(msg_q_t));
     if (q) {
-        q->name = "";
-        pthread_mutex_init(&(q->data_mutex), NULL);
-        pthread_cond_init(&q->data_cond, NULL);
-        q->data = (void**)malloc(sizeof(void*) * msg_number);
+        // Slot pointers and all slots are carved from one slab
+        q->data = (void**)malloc(sizeof(void*) * msg_number + msg_size * msg_number);
+        if (q->data == NULL) {
+            free(q);
+            return NULL;
+        }
+        uint8_t* slab = (uint8_t*)(q->data + msg_number);
         for (int i = 0; i < msg_number; i++) {
-            q->data[i] = malloc(msg_size);
+            q->data[i] = slab + i * msg_size;
         }
-        q->number = msg_number;
-        q->each_size = msg_size;
-    }
-    return q;
-}
-
-msg_q_handle_t msg_q_create_by_name(const char* name, int msg_size, int msg_number) {
-    msg_q_t* q = (msg_q_t*)calloc(1, sizeof(msg_q_t));
-    if (msg_size == 0 || msg_number == 0) {
-        return NULL;
-    }
-    if (q) {
         q->name = name;
         pthread_mutex_init(&(q->data_mutex), NULL);
         pthread_cond_init(&q->data_cond, NULL);
-        q->data = (void**)malloc(sizeof(void*) * msg_number);
-        for (int i = 0; i < msg_number; i++) {
-            q->data[i] = malloc(msg_size);
-        }
         q->number = msg_number;
         q->each_size = msg_size;
     }
     return q;
 }
 
+msg_q_handle_t msg_q_create(int msg_number, int msg_size) {
+    return msg_q_create_by_name("", msg_size, msg_number);
+}
+
 int msg_q_wait_consume(msg_q_handle_t q) {
     int ret = -1;
     if (q) {
@@ -114,7 +108,9 @@ int msg_q_send(msg_q_handle_t q, void* msg, int size) {
         while (q->quit == false && q->filled >= q->number && q->reset == false) {
             //printf("msg buffer %s full\n", q->name);
             q->user++;
+            uint64_t start = q->stats ? queue_stats_now() : 0;
             pthread_cond_wait(&(q->data_cond), &(q->data_mutex));
+            queue_stats_producer_wait(q->stats, start);
             q->user--;
         }
         if (q->reset) {
@@ -124,6 +120,7 @@ int msg_q_send(msg_q_handle_t q, void* msg, int size) {
             int idx = (q->cur + q->filled) % q->number;
             memcpy(q->data[idx], msg, size);
             q->filled++;
+            queue_stats_push(q->stats, q->each_size);
             // printf("Send q %s OK have: %d\n", q->name, q->filled);
         }
         else {
@@ -154,7 +151,9 @@ int msg_q_recv(msg_q_handle_t q, void* msg, int size, bool no_wait) {
             }
             q->user++;
             //printf("msg buffer %s empty\n", q->name);
+            uint64_t start = q->stats ? queue_stats_now() : 0;
             ret = pthread_cond_wait(&(q->data_cond), &(q->data_mutex));
+            queue_stats_consumer_wait(q->stats, start);
             //printf("msg buffer %s reset:%d\n", q->name, q->reset);
             q->user--;
         }
@@ -162,6 +161,7 @@ int msg_q_recv(msg_q_handle_t q, void* msg, int size, bool no_wait) {
             memcpy(msg, q->data[q->cur], size);
             // printf("Recv q %s OK have: %d\n", q->name, q->filled);
             q->filled--;
+            queue_stats_pop(q->stats, q->each_size);
             q->cur++;
             q->cur %= q->number;   
         }
@@ -182,6 +182,82 @@ int msg_q_recv(msg_q_handle_t q, void* msg, int size, bool no_wait) {
     return -1;
 }
 
+int msg_q_send_many(msg_q_handle_t q, void* msgs, int size, int num) {
+    if (q == NULL || msgs == NULL || size > q->each_size) {
+        return -1;
+    }
+    int sent = 0;
+    pthread_mutex_lock(&(q->data_mutex));
+    while (sent < num) {
+        while (q->quit == false && q->filled >= q->number && q->reset == false) {
+            // Let consumer take what already sent before wait for space
+            if (sent) {
+                pthread_cond_signal(&(q->data_cond));
+            }
+            q->user++;
+            uint64_t start = q->stats ? queue_stats_now() : 0;
+            pthread_cond_wait(&(q->data_cond), &(q->data_mutex));
+            queue_stats_producer_wait(q->stats, start);
+            q->user--;
+        }
+        if (q->quit || q->reset) {
+            if (q->reset) {
+                q->reset = false;
+            }
+            break;
+        }
+        while (sent < num && q->filled < q->number) {
+            int idx = (q->cur + q->filled) % q->number;
+            memcpy(q->data[idx], (uint8_t*)msgs + sent * size, size);
+            q->filled++;
+            queue_stats_push(q->stats, q->each_size);
+            sent++;
+        }
+    }
+    pthread_mutex_unlock(&(q->data_mutex));
+    if (sent) {
+        pthread_cond_signal(&(q->data_cond));
+    }
+    return (sent == num) ? sent : (sent ? sent : -2);
+}
+
+int msg_q_recv_many(msg_q_handle_t q, void* msgs, int size, int max_num, bool no_wait) {
+    if (q == NULL || msgs == NULL || size > q->each_size) {
+        return -1;
+    }
+    pthread_mutex_lock(&(q->data_mutex));
+    while (q->quit == false && q->filled == 0 && q->reset == false) {
+        if (no_wait) {
+            pthread_mutex_unlock(&(q->data_mutex));
+            return 0;
+        }
+        q->user++;
+        uint64_t start = q->stats ? queue_stats_now() : 0;
+        pthread_cond_wait(&(q->data_cond), &(q->data_mutex));
+        queue_stats_consumer_wait(q->stats, start);
+        q->user--;
+    }
+    if (q->quit || q->reset) {
+        if (q->reset) {
+            q->reset = false;
+        }
+        pthread_mutex_unlock(&(q->data_mutex));
+        return -2;
+    }
+    int recv = 0;
+    while (recv < max_num && q->filled) {
+        memcpy((uint8_t*)msgs + recv * size, q->data[q->cur], size);
+        q->filled--;
+        queue_stats_pop(q->stats, q->each_size);
+        q->cur++;
+        q->cur %= q->number;
+        recv++;
+    }
+    pthread_mutex_unlock(&(q->data_mutex));
+    pthread_cond_signal(&(q->data_cond));
+    return recv;
+}
+
 int msg_q_add_user(msg_q_handle_t q, int dir) {
     if (q) {
         pthread_mutex_lock(&(q->data_mutex));
@@ -208,8 +284,11 @@ int msg_q_reset(msg_q_handle_t q) {
             usleep(2000);
         }
         pthread_mutex_lock(&(q->data_mutex));
+        while (q->filled) {
+            queue_stats_pop(q->stats, q->each_size);
+            q->filled--;
+        }
         q->cur = 0;
-        q->filled = 0;
         pthread_mutex_unlock(&(q->data_mutex));
         //printf("reset Finished %s\n", q->name);
     }
@@ -234,6 +313,18 @@ int msg_q_wakeup(msg_q_handle_t q) {
     return 0;
 }
 
+int msg_q_enable_stats(msg_q_handle_t q, const char* name) {
+    if (q == NULL) {
+        return -1;
+    }
+    pthread_mutex_lock(&(q->data_mutex));
+    if (q->stats == NULL) {
+        q->stats = queue_stats_register(name, QUEUE_STATS_TYPE_MSG_Q);
+    }
+    pthread_mutex_unlock(&(q->data_mutex));
+    return q->stats ? 0 : -1;
+}
+
 int msg_q_number(msg_q_handle_t q) {
    int n = 0;
    if (q) {
@@ -287,12 +378,9 @@ void msg_q_destroy(msg_q_handle_t q) {
         pthread_mutex_lock(&(q->data_mutex));
         pthread_mutex_unlock(&(q->data_mutex));
 
+        queue_stats_unregister(q->stats);
         pthread_mutex_destroy(&(q->data_mutex));
         pthread_cond_destroy(&(q->data_cond));
-        int i;
-        for (i = 0; i < q->number; i++) {
-            free(q->data[i]);
-        }
         free(q->data);
         free(q);
     }
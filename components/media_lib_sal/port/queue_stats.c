@@ -0,0 +1,193 @@
+/**
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2025 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <string.h>
+#include <time.h>
+#include "media_lib_os.h"
+#include "queue_stats.h"
+#include "esp_log.h"
+
+#define TAG "QUEUE_STATS"
+
+typedef struct _queue_stats_node {
+    queue_stats_t              stats;
+    struct _queue_stats_node  *next;
+} queue_stats_node_t;
+
+typedef struct {
+    bool                      enable;
+    media_lib_mutex_handle_t  lock;
+    queue_stats_node_t       *head;
+    uint32_t                  dump_interval;
+    uint32_t                  dump_gen;
+} queue_stats_registry_t;
+
+static queue_stats_registry_t registry;
+
+static const char *type_to_str(queue_stats_type_t type)
+{
+    switch (type) {
+        case QUEUE_STATS_TYPE_DATA_QUEUE:
+            return "data_q";
+        case QUEUE_STATS_TYPE_MSG_Q:
+            return "msg_q";
+        case QUEUE_STATS_TYPE_FIFO_RINGBUF:
+            return "ringbuf";
+        case QUEUE_STATS_TYPE_SHARE_Q:
+            return "share_q";
+        default:
+            return "";
+    }
+}
+
+void queue_stats_set_enable(bool enable)
+{
+    if (enable && registry.lock == NULL) {
+        media_lib_mutex_create(&registry.lock);
+    }
+    registry.enable = enable;
+}
+
+queue_stats_t *queue_stats_register(const char *name, queue_stats_type_t type)
+{
+    if (registry.enable == false || registry.lock == NULL) {
+        return NULL;
+    }
+    queue_stats_node_t *node = (queue_stats_node_t *) media_lib_calloc(1, sizeof(queue_stats_node_t));
+    if (node == NULL) {
+        return NULL;
+    }
+    if (name) {
+        strncpy(node->stats.name, name, QUEUE_STATS_NAME_LEN - 1);
+    }
+    node->stats.type = type;
+    media_lib_mutex_lock(registry.lock, MEDIA_LIB_MAX_LOCK_TIME);
+    node->next = registry.head;
+    registry.head = node;
+    media_lib_mutex_unlock(registry.lock);
+    return &node->stats;
+}
+
+void queue_stats_unregister(queue_stats_t *stats)
+{
+    if (stats == NULL || registry.lock == NULL) {
+        return;
+    }
+    media_lib_mutex_lock(registry.lock, MEDIA_LIB_MAX_LOCK_TIME);
+    queue_stats_node_t **cur = &registry.head;
+    while (*cur) {
+        if (&(*cur)->stats == stats) {
+            queue_stats_node_t *node = *cur;
+            *cur = node->next;
+            media_lib_free(node);
+            break;
+        }
+        cur = &(*cur)->next;
+    }
+    media_lib_mutex_unlock(registry.lock);
+}
+
+int queue_stats_snapshot(queue_stats_t *stats, int max_num)
+{
+    int n = 0;
+    if (stats == NULL || registry.lock == NULL) {
+        return 0;
+    }
+    media_lib_mutex_lock(registry.lock, MEDIA_LIB_MAX_LOCK_TIME);
+    queue_stats_node_t *node = registry.head;
+    while (node && n < max_num) {
+        stats[n++] = node->stats;
+        node = node->next;
+    }
+    media_lib_mutex_unlock(registry.lock);
+    return n;
+}
+
+void queue_stats_dump(void)
+{
+    if (registry.lock == NULL) {
+        return;
+    }
+    media_lib_mutex_lock(registry.lock, MEDIA_LIB_MAX_LOCK_TIME);
+    queue_stats_node_t *node = registry.head;
+    while (node) {
+        queue_stats_t *s = &node->stats;
+        ESP_LOGI(TAG, "%-8s %-15s items:%d/%d bytes:%d/%d drops:%d wait(ms) producer:%d consumer:%d",
+                 type_to_str(s->type), s->name, (int) s->items, (int) s->max_items,
+                 (int) s->bytes, (int) s->max_bytes, (int) s->drops,
+                 (int) (s->producer_wait_us / 1000), (int) (s->consumer_wait_us / 1000));
+        node = node->next;
+    }
+    media_lib_mutex_unlock(registry.lock);
+}
+
+// Each start creates a new generation, thread of old generation quits after wake up
+static void dump_thread(void *arg)
+{
+    uint32_t gen = (uint32_t) (uintptr_t) arg;
+    while (MEDIA_LIB_ATOMIC_LOAD_ACQ(registry.dump_gen) == gen) {
+        media_lib_thread_sleep(MEDIA_LIB_ATOMIC_LOAD_RELAXED(registry.dump_interval));
+        if (MEDIA_LIB_ATOMIC_LOAD_ACQ(registry.dump_gen) == gen) {
+            queue_stats_dump();
+        }
+    }
+    media_lib_thread_destroy(NULL);
+}
+
+// Odd generation means dump thread is running
+int queue_stats_start_dump(uint32_t interval_ms)
+{
+    if (interval_ms == 0) {
+        return -1;
+    }
+    MEDIA_LIB_ATOMIC_STORE_RELAXED(registry.dump_interval, interval_ms);
+    uint32_t gen = MEDIA_LIB_ATOMIC_LOAD_ACQ(registry.dump_gen);
+    if (gen & 1) {
+        return 0;
+    }
+    media_lib_thread_handle_t thread = NULL;
+    gen++;
+    MEDIA_LIB_ATOMIC_STORE_REL(registry.dump_gen, gen);
+    if (media_lib_thread_create_from_scheduler(&thread, "QStats", dump_thread, (void *) (uintptr_t) gen) != 0) {
+        MEDIA_LIB_ATOMIC_STORE_REL(registry.dump_gen, gen + 1);
+        return -1;
+    }
+    return 0;
+}
+
+void queue_stats_stop_dump(void)
+{
+    uint32_t gen = MEDIA_LIB_ATOMIC_LOAD_ACQ(registry.dump_gen);
+    if (gen & 1) {
+        MEDIA_LIB_ATOMIC_STORE_REL(registry.dump_gen, gen + 1);
+    }
+}
+
+uint64_t queue_stats_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
@@ -1,9 +1,11 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 
+#include "stdlib.h"
 #include "string.h"
 
 #include "fifo_ringbuf.h"
+#include "queue_stats.h"
 
 struct fifo_ringbuf_t {
     void *buffer;
@@ -12,7 +14,9 @@ struct fifo_ringbuf_t {
     size_t item_size;
     UBaseType_t write_idx;   // Next position to write
     UBaseType_t read_idx;    // Next position to read
-    UBaseType_t count;       // Next position to read
+    UBaseType_t count;       // Number of packets available to read
+    UBaseType_t reading;     // Number of packets acquired by reader
+    queue_stats_t *stats;    // Statistics, NULL if not enabled
     SemaphoreHandle_t mutex; // Thread safety
     SemaphoreHandle_t
         data_available; // Counting semaphore for available packets
@@ -40,6 +44,8 @@ fifo_ringbuf_t *fifo_ringbuf_init(size_t len, size_t item_size) {
     rb->write_idx = 0;
     rb->read_idx = 0;
     rb->count = 0;
+    rb->reading = 0;
+    rb->stats = NULL;
 
     rb->mutex = xSemaphoreCreateMutex();
     if (!rb->mutex) {
@@ -61,6 +67,11 @@ fifo_ringbuf_t *fifo_ringbuf_init(size_t len, size_t item_size) {
 
 void fifo_ringbuf_release(fifo_ringbuf_t *rb) {
     if (rb) {
+        queue_stats_unregister(rb->stats);
+        if (rb->data_available)
+            vSemaphoreDelete(rb->data_available);
+        if (rb->mutex)
+            vSemaphoreDelete(rb->mutex);
         if (rb->buffer)
             free(rb->buffer);
         if (rb->item_sizes)
@@ -69,54 +80,118 @@ void fifo_ringbuf_release(fifo_ringbuf_t *rb) {
     }
 }
 
+// Get slot to write (overwrite old data if full)
+void *fifo_ringbuf_acquire_write(fifo_ringbuf_t *rb) {
+    void *dst = NULL;
+    xSemaphoreTake(rb->mutex, portMAX_DELAY);
+    if (rb->count + rb->reading == rb->len) {
+        // Write slot follows the slots held by reader, so oldest packet can be
+        // overwritten only when reader holds nothing, otherwise drop new one
+        if (rb->reading == 0) {
+            // Buffer is full. To overwrite, drop the oldest unread packet.
+            // Semaphore is not taken back, reader will recheck count.
+            queue_stats_pop(rb->stats, rb->item_sizes[rb->read_idx]);
+            queue_stats_drop(rb->stats);
+            rb->read_idx = (rb->read_idx + 1) % rb->len;
+            rb->count--;
+            dst = (int8_t *)rb->buffer + rb->write_idx * rb->item_size;
+        } else {
+            queue_stats_drop(rb->stats);
+        }
+    } else {
+        dst = (int8_t *)rb->buffer + rb->write_idx * rb->item_size;
+    }
+    xSemaphoreGive(rb->mutex);
+    return dst;
+}
+
+void fifo_ringbuf_commit_write(fifo_ringbuf_t *rb, size_t size) {
+    if (size == 0)
+        return;
+    xSemaphoreTake(rb->mutex, portMAX_DELAY);
+    rb->item_sizes[rb->write_idx] = size;
+    rb->write_idx = (rb->write_idx + 1) % rb->len;
+    rb->count++;
+    queue_stats_push(rb->stats, size);
+    // Signal that new data is available.
+    xSemaphoreGive(rb->data_available);
+    xSemaphoreGive(rb->mutex);
+}
+
 // Write data to the buffer (overwrite old data if full)
 size_t fifo_ringbuf_write(fifo_ringbuf_t *rb, const void *data, size_t size) {
     if (size > rb->item_size)
         return 0;
 
-    xSemaphoreTake(rb->mutex, portMAX_DELAY);
-
-    void *dst = (int8_t *)rb->buffer + rb->write_idx * rb->item_size;
+    void *dst = fifo_ringbuf_acquire_write(rb);
+    if (!dst)
+        return 0;
     memcpy(dst, data, size);
-    rb->item_sizes[rb->write_idx] = size;
+    fifo_ringbuf_commit_write(rb, size);
+    return size;
+}
 
-    rb->write_idx = (rb->write_idx + 1) % rb->len;
+// Get oldest unread packets which are continuous in buffer
+size_t fifo_ringbuf_acquire_read(fifo_ringbuf_t *rb, void **data,
+                                 size_t max_items, size_t *items,
+                                 size_t timeout) {
+    *items = 0;
+    if (max_items == 0)
+        return 0;
 
-    if (rb->count == rb->len) {
-        // Buffer is full. To overwrite, advance the read pointer.
-        rb->read_idx = (rb->read_idx + 1) % rb->len;
-        // The count remains at rb->len.
-        // Do not give the semaphore because from the consumer’s point of view,
-        // the number of available packets is unchanged.
-    } else {
-        // Buffer was not full. Increase the count.
-        rb->count++;
-        // Signal that new data is available.
-        xSemaphoreGive(rb->data_available);
+    xSemaphoreTake(rb->mutex, portMAX_DELAY);
+    while (rb->count == 0) {
+        xSemaphoreGive(rb->mutex);
+        // Block until a packet is available.
+        uint64_t start = rb->stats ? queue_stats_now() : 0;
+        BaseType_t got = xSemaphoreTake(rb->data_available, timeout);
+        queue_stats_consumer_wait(rb->stats, start);
+        if (got != pdTRUE) {
+            return 0;
+        }
+        xSemaphoreTake(rb->mutex, portMAX_DELAY);
+    }
+
+    *data = (int8_t *)rb->buffer + rb->read_idx * rb->item_size;
+    size_t total = rb->item_sizes[rb->read_idx];
+    size_t n = 1;
+    // Packets are continuous only when previous one fill the whole slot
+    while (n < max_items && n < rb->count && rb->read_idx + n < rb->len &&
+           rb->item_sizes[rb->read_idx + n - 1] == rb->item_size) {
+        total += rb->item_sizes[rb->read_idx + n];
+        n++;
+    }
+    for (size_t i = 0; i < n; i++) {
+        queue_stats_pop(rb->stats, rb->item_sizes[rb->read_idx + i]);
     }
+    rb->read_idx = (rb->read_idx + n) % rb->len;
+    rb->count -= n;
+    rb->reading += n;
+    *items = n;
+
+    xSemaphoreGive(rb->mutex);
+    return total;
+}
+
+void fifo_ringbuf_release_read(fifo_ringbuf_t *rb, size_t items) {
+    xSemaphoreTake(rb->mutex, portMAX_DELAY);
+    rb->reading = (items < rb->reading) ? rb->reading - items : 0;
     xSemaphoreGive(rb->mutex);
-    return size;
 }
 
 // Read oldest unread packet (returns true if data was read)
 size_t fifo_ringbuf_read(fifo_ringbuf_t *rb, void *data, size_t max_len,
                          size_t timeout) {
-    // Block until a packet is available.
-    if (xSemaphoreTake(rb->data_available, timeout) != pdTRUE) {
+    void *item_data = NULL;
+    size_t items = 0;
+    size_t item_size =
+        fifo_ringbuf_acquire_read(rb, &item_data, 1, &items, timeout);
+    if (items == 0) {
         return 0;
     }
-
-    xSemaphoreTake(rb->mutex, portMAX_DELAY);
-
-    void *item_data = (int8_t *)rb->buffer + rb->read_idx * rb->item_size;
-    size_t item_size = rb->item_sizes[rb->read_idx];
     const size_t copy_len = (item_size < max_len) ? item_size : max_len;
     memcpy(data, item_data, copy_len);
-
-    rb->read_idx = (rb->read_idx + 1) % rb->len;
-    rb->count--;
-
-    xSemaphoreGive(rb->mutex);
+    fifo_ringbuf_release_read(rb, items);
     return copy_len;
 }
 
@@ -125,11 +200,26 @@ int fifo_ringbuf_reset(fifo_ringbuf_t *rb) {
         xSemaphoreTake(rb->mutex, portMAX_DELAY);
         while (xSemaphoreTake(rb->data_available, 0) == pdTRUE) {
         }
+        for (UBaseType_t i = 0; i < rb->count; i++) {
+            queue_stats_pop(rb->stats,
+                            rb->item_sizes[(rb->read_idx + i) % rb->len]);
+        }
         rb->write_idx = 0;
         rb->read_idx = 0;
         rb->count = 0;
+        rb->reading = 0;
         xSemaphoreGive(rb->mutex);
         return 0;
     }
     return -1;
 }
+
+int fifo_ringbuf_enable_stats(fifo_ringbuf_t *rb, const char *name) {
+    if (!rb)
+        return -1;
+    xSemaphoreTake(rb->mutex, portMAX_DELAY);
+    if (!rb->stats)
+        rb->stats = queue_stats_register(name, QUEUE_STATS_TYPE_FIFO_RINGBUF);
+    xSemaphoreGive(rb->mutex);
+    return rb->stats ? 0 : -1;
+}
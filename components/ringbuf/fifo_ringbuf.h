@@ -38,6 +38,28 @@ void fifo_ringbuf_release(fifo_ringbuf_t *rb);
  *       - >=0   Bytes wrote
  */
 size_t fifo_ringbuf_write(fifo_ringbuf_t *rb, const void *data, size_t size);
+/**
+ * @brief  Get a slot in ringbuf storage to fill in place
+ *
+ * @note   When buffer is full the oldest unread packet is dropped
+ *         If reader still holds slots at that time, the new packet is dropped instead
+ *         so that slots held by reader are never overwritten
+ *         Only one writer is allowed, must call `fifo_ringbuf_commit_write` afterwards
+ *
+ * @param[in]  rb  fifo ringbuf instance
+ *
+ * @return
+ *       - NULL    Buffer is full and reader holds slots
+ *       - Others  Slot pointer, can fill up to item_size bytes
+ */
+void *fifo_ringbuf_acquire_write(fifo_ringbuf_t *rb);
+/**
+ * @brief  Commit slot got by `fifo_ringbuf_acquire_write` as a new packet
+ *
+ * @param[in]  rb    fifo ringbuf instance
+ * @param[in]  size  Data size filled in bytes, 0 to drop the slot
+ */
+void fifo_ringbuf_commit_write(fifo_ringbuf_t *rb, size_t size);
 /**
  * @brief  Read from ringbuf
  *
@@ -51,6 +73,32 @@ size_t fifo_ringbuf_write(fifo_ringbuf_t *rb, const void *data, size_t size);
  */
 size_t fifo_ringbuf_read(fifo_ringbuf_t *rb, void *data, size_t max_len,
                          size_t timeout);
+/**
+ * @brief  Acquire oldest unread packets in place without copy
+ *
+ * @note   Packets returned are continuous in ringbuf storage, so that less than
+ *         `max_items` may be returned when ring back or packet not fill whole slot
+ *         Data is kept valid until call `fifo_ringbuf_release_read`
+ *
+ * @param[in]   rb         fifo ringbuf instance
+ * @param[out]  data       Pointer to first packet in ringbuf storage
+ * @param[in]   max_items  Max packets to acquire
+ * @param[out]  items      Packets acquired
+ * @param[in]   timeout    Wait timeout for first packet
+ *
+ * @return
+ *       - >=0  Total bytes of acquired packets
+ */
+size_t fifo_ringbuf_acquire_read(fifo_ringbuf_t *rb, void **data,
+                                 size_t max_items, size_t *items,
+                                 size_t timeout);
+/**
+ * @brief  Release packets got by `fifo_ringbuf_acquire_read`
+ *
+ * @param[in]  rb     fifo ringbuf instance
+ * @param[in]  items  Packets to release
+ */
+void fifo_ringbuf_release_read(fifo_ringbuf_t *rb, size_t items);
 /**
  * @brief  Reset ringbuf state
  *
@@ -61,6 +109,19 @@ size_t fifo_ringbuf_read(fifo_ringbuf_t *rb, void *data, size_t max_len,
  *       - 0   Success
  */
 int fifo_ringbuf_reset(fifo_ringbuf_t *rb);
+/**
+ * @brief  Enable statistics for ringbuf, overwrite of oldest packet is counted as drop
+ *
+ * @note   Statistics is registered only when `queue_stats_set_enable` is enabled
+ *
+ * @param[in]  rb    fifo ringbuf instance
+ * @param[in]  name  Name to show in statistics
+ *
+ * @return
+ *       - -1  Statistics is disabled or no memory
+ *       - 0   Success
+ */
+int fifo_ringbuf_enable_stats(fifo_ringbuf_t *rb, const char *name);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,133 @@
+/**
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2025 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+/* YUV420 to RGB565 benchmark, compare lookup table and per pixel calculation on speed and PSNR
+ * PSNR is measured against float BT.601 reference
+ * Usage: color_bench [width height iterations]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "color_convert.h"
+
+static void fill_frame(uint8_t *src, int w, int h)
+{
+    // Gradients with noise so that table quantization error shows up
+    uint32_t seed = 1;
+    int uv_w = (w + 1) / 2, uv_h = (h + 1) / 2;
+    uint8_t *u = src + w * h, *v = u + uv_w * uv_h;
+    for (int i = 0; i < h; i++) {
+        for (int j = 0; j < w; j++) {
+            seed = seed * 1103515245 + 12345;
+            int y = 16 + (i * 219 / h + j * 40 / w) % 220 + (int)((seed >> 16) & 7) - 4;
+            src[i * w + j] = (uint8_t)(y < 0 ? 0 : y > 255 ? 255 : y);
+        }
+    }
+    for (int i = 0; i < uv_h; i++) {
+        for (int j = 0; j < uv_w; j++) {
+            seed = seed * 1103515245 + 12345;
+            u[i * uv_w + j] = (uint8_t)(16 + j * 224 / uv_w + ((seed >> 16) & 3));
+            v[i * uv_w + j] = (uint8_t)(16 + i * 224 / uv_h + ((seed >> 20) & 3));
+        }
+    }
+}
+
+static double get_psnr(uint8_t *src, uint16_t *rgb, int w, int h)
+{
+    int uv_w = (w + 1) / 2, uv_h = (h + 1) / 2;
+    uint8_t *u = src + w * h, *v = u + uv_w * uv_h;
+    double err = 0;
+    for (int i = 0; i < h; i++) {
+        for (int j = 0; j < w; j++) {
+            double y = 1.164 * (src[i * w + j] - 16);
+            double cu = u[(i / 2) * uv_w + j / 2] - 128;
+            double cv = v[(i / 2) * uv_w + j / 2] - 128;
+            double ref[3] = { y + 1.596 * cv, y - 0.391 * cu - 0.813 * cv, y + 2.018 * cu };
+            uint16_t p = rgb[i * w + j];
+            double out[3] = { ((p >> 11) & 0x1F) * 255.0 / 31, ((p >> 5) & 0x3F) * 255.0 / 63, (p & 0x1F) * 255.0 / 31 };
+            for (int c = 0; c < 3; c++) {
+                double r = ref[c] < 0 ? 0 : ref[c] > 255 ? 255 : ref[c];
+                err += (r - out[c]) * (r - out[c]);
+            }
+        }
+    }
+    err /= (double)w * h * 3;
+    return 10 * log10(255.0 * 255.0 / err);
+}
+
+static int run(const char *name, bool no_table, uint8_t *src, int src_size, uint16_t *dst, int w, int h, int loops)
+{
+    color_convert_cfg_t cfg = {
+        .from = AV_RENDER_VIDEO_RAW_TYPE_YUV420,
+        .to = AV_RENDER_VIDEO_RAW_TYPE_RGB565,
+        .width = w,
+        .height = h,
+        .no_table = no_table,
+    };
+    color_convert_table_t t = init_convert_table(&cfg);
+    if (t == NULL) {
+        printf("Fail to init %s converter\n", name);
+        return -1;
+    }
+    int dst_size = w * h * 2;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < loops; i++) {
+        convert_color(t, src, src_size, (uint8_t *)dst, dst_size);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    deinit_convert_table(t);
+    double sec = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%-6s %dx%d: %8.1f Mpixel/s  PSNR %.2f dB\n", name, w, h, (double)w * h * loops / sec / 1e6,
+           get_psnr(src, dst, w, h));
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int w = argc > 2 ? atoi(argv[1]) : 640;
+    int h = argc > 2 ? atoi(argv[2]) : 480;
+    int loops = argc > 3 ? atoi(argv[3]) : 100;
+    if (w <= 0 || h <= 0 || loops <= 0) {
+        printf("Usage: color_bench [width height iterations]\n");
+        return 1;
+    }
+    int src_size = convert_table_get_image_size(AV_RENDER_VIDEO_RAW_TYPE_YUV420, w, h);
+    uint8_t *src = (uint8_t *)malloc(src_size);
+    uint16_t *dst = (uint16_t *)malloc(w * h * 2);
+    if (src == NULL || dst == NULL) {
+        return 1;
+    }
+    fill_frame(src, w, h);
+    int ret = run("table", false, src, src_size, dst, w, h, loops);
+    if (ret == 0) {
+        ret = run("calc", true, src, src_size, dst, w, h, loops);
+    }
+    free(src);
+    free(dst);
+    return ret ? 1 : 0;
+}
@@ -0,0 +1,371 @@
+/**
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2025 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/* Queue micro benchmark, measure throughput and p50/p99 handoff latency of queue implementations
+ * Usage: queue_bench [items_per_producer]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include "data_queue.h"
+#include "msg_q.h"
+#include "fifo_ringbuf.h"
+#include "share_q.h"
+
+#define BENCH_MAX_THREADS  (4)
+#define BENCH_QUEUE_SIZE   (64 * 1024)
+#define BENCH_MSG_NUM      (32)
+#define BENCH_RB_NUM       (16)
+#define BENCH_SHARE_NUM    (8)
+#define BENCH_EOS_SIZE     (1)
+#define BENCH_MIN_ITEM     (sizeof(bench_item_t))
+
+typedef enum {
+    BENCH_DATA_QUEUE,
+    BENCH_DATA_QUEUE_SPSC,
+    BENCH_MSG_Q,
+    BENCH_FIFO_RINGBUF,
+    BENCH_SHARE_Q,
+} bench_type_t;
+
+typedef struct {
+    uint64_t send_ns;
+    uint32_t seq;
+    uint32_t eos;
+} bench_item_t;
+
+typedef struct {
+    uint8_t *data;
+    int      size;
+} bench_frame_t;
+
+typedef struct bench_t bench_t;
+
+typedef struct {
+    bench_t  *bench;
+    int       index;
+    uint32_t *lat;
+    int       lat_num;
+} bench_worker_t;
+
+struct bench_t {
+    bench_type_t     type;
+    int              item_size;
+    int              producers;
+    int              consumers;
+    int              items;
+    data_queue_t    *dq;
+    msg_q_handle_t   mq;
+    fifo_ringbuf_t  *rb;
+    share_q_handle_t sq;
+    uint8_t         *frames;
+    int              eos_left;
+    bench_worker_t   worker[BENCH_MAX_THREADS * 2];
+};
+
+static const char *bench_names[] = {"data_queue", "data_queue_spsc", "msg_q", "fifo_ringbuf", "share_q"};
+
+static uint64_t bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void fill_item(uint8_t *buf, uint32_t seq, bool eos)
+{
+    bench_item_t item = {
+        .seq = seq,
+        .eos = eos,
+    };
+    item.send_ns = bench_now();
+    memcpy(buf, &item, sizeof(item));
+}
+
+// Record latency of received item, return true when got end of stream
+static bool on_item(bench_worker_t *w, uint8_t *buf)
+{
+    bench_item_t item;
+    memcpy(&item, buf, sizeof(item));
+    if (item.eos) {
+        return true;
+    }
+    w->lat[w->lat_num++] = (uint32_t) (bench_now() - item.send_ns);
+    return false;
+}
+
+static void *share_get_frame_data(void *item)
+{
+    return ((bench_frame_t *) item)->data;
+}
+
+static int share_release_frame(void *item, void *ctx)
+{
+    return 0;
+}
+
+static void produce_one(bench_t *b, uint32_t seq, bool eos)
+{
+    int size = eos ? (int) BENCH_MIN_ITEM : b->item_size;
+    switch (b->type) {
+        case BENCH_DATA_QUEUE:
+        case BENCH_DATA_QUEUE_SPSC: {
+            uint8_t *buf = (uint8_t *) data_queue_get_buffer(b->dq, size);
+            if (buf) {
+                fill_item(buf, seq, eos);
+                data_queue_send_buffer(b->dq, size);
+            }
+            break;
+        }
+        case BENCH_MSG_Q: {
+            uint8_t buf[b->item_size];
+            fill_item(buf, seq, eos);
+            msg_q_send(b->mq, buf, b->item_size);
+            break;
+        }
+        case BENCH_FIFO_RINGBUF: {
+            uint8_t *buf = (uint8_t *) fifo_ringbuf_acquire_write(b->rb);
+            if (buf) {
+                fill_item(buf, seq, eos);
+                fifo_ringbuf_commit_write(b->rb, size);
+            }
+            break;
+        }
+        case BENCH_SHARE_Q: {
+            // Frame pool is bigger than queue depth, so reused frame always retired
+            bench_frame_t frame = {
+                .data = b->frames + (seq % BENCH_SHARE_NUM) * b->item_size,
+                .size = size,
+            };
+            fill_item(frame.data, seq, eos);
+            share_q_add(b->sq, &frame);
+            break;
+        }
+    }
+}
+
+static void *producer_thread(void *arg)
+{
+    bench_worker_t *w = (bench_worker_t *) arg;
+    bench_t *b = w->bench;
+    for (int i = 0; i < b->items; i++) {
+        produce_one(b, i, false);
+    }
+    // Each producer send one end of stream per consumer for queues which dispatch to one reader
+    int eos_num = (b->type == BENCH_SHARE_Q) ? 1 : b->consumers;
+    for (int i = 0; i < eos_num; i++) {
+        produce_one(b, b->items, true);
+    }
+    return NULL;
+}
+
+static void *consumer_thread(void *arg)
+{
+    bench_worker_t *w = (bench_worker_t *) arg;
+    bench_t *b = w->bench;
+    int eos = 0;
+    while (eos < b->producers) {
+        switch (b->type) {
+            case BENCH_DATA_QUEUE:
+            case BENCH_DATA_QUEUE_SPSC: {
+                void *buf = NULL;
+                int size = 0;
+                if (data_queue_read_lock(b->dq, &buf, &size) != 0) {
+                    return NULL;
+                }
+                eos += on_item(w, (uint8_t *) buf);
+                data_queue_read_unlock(b->dq);
+                break;
+            }
+            case BENCH_MSG_Q: {
+                uint8_t buf[b->item_size];
+                if (msg_q_recv(b->mq, buf, b->item_size, false) != 0) {
+                    return NULL;
+                }
+                eos += on_item(w, buf);
+                break;
+            }
+            case BENCH_FIFO_RINGBUF: {
+                void *buf = NULL;
+                size_t items = 0;
+                fifo_ringbuf_acquire_read(b->rb, &buf, 1, &items, 1000);
+                if (items == 0) {
+                    return NULL;
+                }
+                eos += on_item(w, (uint8_t *) buf);
+                fifo_ringbuf_release_read(b->rb, items);
+                break;
+            }
+            case BENCH_SHARE_Q: {
+                bench_frame_t frame;
+                if (share_q_recv(b->sq, w->index, &frame) != 0) {
+                    return NULL;
+                }
+                eos += on_item(w, frame.data);
+                share_q_release(b->sq, &frame);
+                break;
+            }
+        }
+    }
+    return NULL;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+    return (x > y) - (x < y);
+}
+
+static int bench_create(bench_t *b)
+{
+    switch (b->type) {
+        case BENCH_DATA_QUEUE:
+            b->dq = data_queue_init(BENCH_QUEUE_SIZE);
+            return b->dq ? 0 : -1;
+        case BENCH_DATA_QUEUE_SPSC:
+            b->dq = data_queue_init_spsc(BENCH_QUEUE_SIZE);
+            return b->dq ? 0 : -1;
+        case BENCH_MSG_Q:
+            b->mq = msg_q_create(BENCH_MSG_NUM, b->item_size);
+            return b->mq ? 0 : -1;
+        case BENCH_FIFO_RINGBUF:
+            b->rb = fifo_ringbuf_init(BENCH_RB_NUM, b->item_size);
+            return b->rb ? 0 : -1;
+        case BENCH_SHARE_Q: {
+            share_q_cfg_t cfg = {
+                .user_count = b->consumers,
+                .q_count = BENCH_SHARE_NUM - 1,
+                .item_size = sizeof(bench_frame_t),
+                .get_frame_data = share_get_frame_data,
+                .release_frame = share_release_frame,
+            };
+            b->sq = share_q_create(&cfg);
+            b->frames = (uint8_t *) malloc(BENCH_SHARE_NUM * b->item_size);
+            if (b->sq == NULL || b->frames == NULL) {
+                return -1;
+            }
+            for (int i = 0; i < b->consumers; i++) {
+                share_q_enable(b->sq, i, true);
+            }
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static void bench_destroy(bench_t *b)
+{
+    if (b->dq) {
+        data_queue_deinit(b->dq);
+    }
+    if (b->mq) {
+        msg_q_destroy(b->mq);
+    }
+    if (b->rb) {
+        fifo_ringbuf_release(b->rb);
+    }
+    if (b->sq) {
+        share_q_destroy(b->sq);
+    }
+    free(b->frames);
+}
+
+static void bench_run(bench_type_t type, int item_size, int producers, int consumers, int items)
+{
+    bench_t b = {
+        .type = type,
+        .item_size = item_size,
+        .producers = producers,
+        .consumers = consumers,
+        .items = items,
+    };
+    if (bench_create(&b) != 0) {
+        printf("%-16s create fail\n", bench_names[type]);
+        bench_destroy(&b);
+        return;
+    }
+    pthread_t threads[BENCH_MAX_THREADS * 2];
+    int lat_cap = items * producers + producers;
+    for (int i = 0; i < consumers; i++) {
+        b.worker[i] = (bench_worker_t) {.bench = &b, .index = i};
+        b.worker[i].lat = (uint32_t *) malloc(lat_cap * sizeof(uint32_t));
+    }
+    uint64_t start = bench_now();
+    for (int i = 0; i < consumers; i++) {
+        pthread_create(&threads[i], NULL, consumer_thread, &b.worker[i]);
+    }
+    for (int i = 0; i < producers; i++) {
+        b.worker[consumers + i] = (bench_worker_t) {.bench = &b, .index = i};
+        pthread_create(&threads[consumers + i], NULL, producer_thread, &b.worker[consumers + i]);
+    }
+    for (int i = 0; i < producers + consumers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    uint64_t elapsed = bench_now() - start;
+    // Merge latency of all consumers
+    int total = 0;
+    for (int i = 0; i < consumers; i++) {
+        total += b.worker[i].lat_num;
+    }
+    uint32_t *lat = (uint32_t *) malloc((total + 1) * sizeof(uint32_t));
+    int n = 0;
+    for (int i = 0; i < consumers; i++) {
+        memcpy(lat + n, b.worker[i].lat, b.worker[i].lat_num * sizeof(uint32_t));
+        n += b.worker[i].lat_num;
+        free(b.worker[i].lat);
+    }
+    qsort(lat, total, sizeof(uint32_t), cmp_u32);
+    // Share queue deliver every item to all users, other queues deliver to one reader
+    int expect = items * producers * (type == BENCH_SHARE_Q ? consumers : 1);
+    double sec = elapsed / 1e9;
+    printf("%-16s %6d %3d %3d %10.0f %8.1f %8.1f %8.1f %7d\n", bench_names[type], item_size, producers, consumers,
+           total / sec, (double) total * item_size / sec / 1e6,
+           total ? lat[total / 2] / 1000.0 : 0, total ? lat[(int) (total * 0.99)] / 1000.0 : 0, expect - total);
+    free(lat);
+    bench_destroy(&b);
+}
+
+int main(int argc, char *argv[])
+{
+    int items = argc > 1 ? atoi(argv[1]) : 20000;
+    static const int sizes[] = {64, 1024, 4096};
+    printf("%-16s %6s %3s %3s %10s %8s %8s %8s %7s\n", "queue", "size", "P", "C", "items/s", "MB/s", "p50(us)",
+           "p99(us)", "lost");
+    for (int s = 0; s < (int) (sizeof(sizes) / sizeof(sizes[0])); s++) {
+        int size = sizes[s];
+        bench_run(BENCH_DATA_QUEUE, size, 1, 1, items);
+        bench_run(BENCH_DATA_QUEUE, size, 4, 1, items);
+        bench_run(BENCH_DATA_QUEUE_SPSC, size, 1, 1, items);
+        bench_run(BENCH_MSG_Q, size, 1, 1, items);
+        bench_run(BENCH_MSG_Q, size, 4, 4, items);
+        bench_run(BENCH_FIFO_RINGBUF, size, 1, 1, items);
+        bench_run(BENCH_SHARE_Q, size, 1, 1, items);
+        bench_run(BENCH_SHARE_Q, size, 1, 2, items);
+    }
+    return 0;
+}
@@ -0,0 +1,262 @@
+/**
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2025 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+/* Fused audio converter benchmark, compare fused single pass output with a float model of chained
+ * channel, bit and rate conversion (esp_ae converters are not available on host)
+ * Reports throughput, passband gain, alias rejection and max sample difference when rate unchanged
+ * Usage: resample_bench [seconds]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "audio_resample.h"
+
+#define BENCH_AMPLITUDE (0.5)
+#define REF_TAPS_PER_PHASE (64)
+// Skip filter warm up before measurement
+#define BENCH_SKIP_MS (20)
+// Report floor, output below it is treated as silent
+#define BENCH_FLOOR_DB (-120)
+
+typedef struct {
+    int16_t *data;
+    int      num;
+    int      max;
+} bench_out_t;
+
+typedef struct {
+    int in_rate;
+    int in_ch;
+    int in_bits;
+    int out_rate;
+    int out_ch;
+} bench_case_t;
+
+static int output_cb(av_render_audio_frame_t *frame, void *ctx)
+{
+    bench_out_t *out = (bench_out_t *)ctx;
+    int n = frame->size / sizeof(int16_t);
+    if (out->num + n > out->max) {
+        n = out->max - out->num;
+    }
+    memcpy(out->data + out->num, frame->data, n * sizeof(int16_t));
+    out->num += n;
+    return 0;
+}
+
+static void gen_tone(uint8_t *buf, bench_case_t *c, int num, double freq)
+{
+    int bytes = c->in_bits >> 3;
+    for (int i = 0; i < num; i++) {
+        double v = BENCH_AMPLITUDE * sin(2 * M_PI * freq * i / c->in_rate);
+        int32_t s = (int32_t)lrint(v * 2147483647.0);
+        for (int ch = 0; ch < c->in_ch; ch++) {
+            uint8_t *p = buf + (i * c->in_ch + ch) * bytes;
+            for (int b = 0; b < bytes; b++) {
+                p[b] = (uint8_t)(s >> (32 - bytes * 8 + b * 8));
+            }
+        }
+    }
+}
+
+static double read_sample(const uint8_t *p, int bytes)
+{
+    int32_t v = 0;
+    for (int b = 0; b < bytes; b++) {
+        v |= (int32_t)((uint32_t)p[b] << (32 - bytes * 8 + b * 8));
+    }
+    return v / 65536.0;
+}
+
+// Float model of chained conversion: downmix, requantize to 16 bits then long windowed sinc decimation
+static int chained_ref(const uint8_t *in, bench_case_t *c, int num, int16_t *out)
+{
+    int bytes = c->in_bits >> 3;
+    int decimation = c->in_rate / c->out_rate;
+    int taps = REF_TAPS_PER_PHASE * decimation + 1;
+    double *coef = (double *)malloc(taps * sizeof(double));
+    double *x = (double *)malloc(num * c->out_ch * sizeof(double));
+    if (coef == NULL || x == NULL) {
+        free(coef);
+        free(x);
+        return 0;
+    }
+    for (int i = 0; i < num; i++) {
+        const uint8_t *p = in + i * c->in_ch * bytes;
+        if (c->in_ch == 2 && c->out_ch == 1) {
+            x[i] = lrint((read_sample(p, bytes) + read_sample(p + bytes, bytes)) / 2);
+        } else {
+            for (int ch = 0; ch < c->out_ch; ch++) {
+                x[i * c->out_ch + ch] = lrint(read_sample(p + ch * bytes, bytes));
+            }
+        }
+    }
+    double fc = 0.45 / decimation, sum = 0;
+    for (int i = 0; i < taps; i++) {
+        double t = i - (taps - 1) / 2.0;
+        double h = (t == 0) ? 2 * fc : sin(2 * M_PI * fc * t) / (M_PI * t);
+        coef[i] = h * (0.42 - 0.5 * cos(2 * M_PI * i / (taps - 1)) + 0.08 * cos(4 * M_PI * i / (taps - 1)));
+        sum += coef[i];
+    }
+    int out_num = 0;
+    for (int n = decimation - 1; n < num; n += decimation, out_num++) {
+        for (int ch = 0; ch < c->out_ch; ch++) {
+            double acc = 0;
+            for (int k = 0; k < taps && k <= n; k++) {
+                acc += coef[k] * x[(n - k) * c->out_ch + ch];
+            }
+            acc = decimation > 1 ? acc / sum : x[n * c->out_ch + ch];
+            out[out_num * c->out_ch + ch] = (int16_t)(acc > 32767 ? 32767 : acc < -32768 ? -32768 : lrint(acc));
+        }
+    }
+    free(coef);
+    free(x);
+    return out_num;
+}
+
+static double get_rms_db(int16_t *data, int num, int ch, int skip)
+{
+    double acc = 0;
+    int cnt = 0;
+    for (int i = skip * ch; i < num * ch; i++, cnt++) {
+        acc += (double)data[i] * data[i];
+    }
+    if (cnt == 0 || acc == 0) {
+        return BENCH_FLOOR_DB;
+    }
+    double db = 20 * log10(sqrt(acc / cnt) / (BENCH_AMPLITUDE * 32767 / sqrt(2)));
+    return db < BENCH_FLOOR_DB ? BENCH_FLOOR_DB : db;
+}
+
+static int run_fused(bench_case_t *c, uint8_t *in, int num, bench_out_t *out, double *sec)
+{
+    audio_resample_cfg_t cfg = {
+        .input_info = { .sample_rate = c->in_rate, .channel = c->in_ch, .bits_per_sample = c->in_bits },
+        .output_info = { .sample_rate = c->out_rate, .channel = c->out_ch, .bits_per_sample = 16 },
+        .resample_cb = output_cb,
+        .ctx = out,
+    };
+    audio_resample_handle_t h = audio_resample_open(&cfg);
+    if (h == NULL) {
+        return -1;
+    }
+    out->num = 0;
+    // Feed 20ms frames as decoder does
+    int frame = c->in_rate / 50;
+    int frame_size = frame * c->in_ch * (c->in_bits >> 3);
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i + frame <= num; i += frame) {
+        av_render_audio_frame_t f = {
+            .data = in + i / frame * frame_size,
+            .size = frame_size,
+        };
+        audio_resample_write(h, &f);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    audio_resample_close(h);
+    *sec = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    out->num /= c->out_ch;
+    return 0;
+}
+
+static int run_case(bench_case_t *c, int seconds)
+{
+    int num = c->in_rate * seconds;
+    int out_max = num / (c->in_rate / c->out_rate) + 1;
+    uint8_t *in = (uint8_t *)malloc(num * c->in_ch * (c->in_bits >> 3));
+    int16_t *ref = (int16_t *)malloc(out_max * c->out_ch * sizeof(int16_t));
+    bench_out_t out = {
+        .data = (int16_t *)malloc(out_max * c->out_ch * sizeof(int16_t)),
+        .max = out_max * c->out_ch,
+    };
+    int ret = -1;
+    if (in == NULL || ref == NULL || out.data == NULL) {
+        goto _exit;
+    }
+    printf("%5d Hz %d ch %2d bit -> %5d Hz %d ch\n", c->in_rate, c->in_ch, c->in_bits, c->out_rate, c->out_ch);
+    int skip = c->out_rate * BENCH_SKIP_MS / 1000;
+    // Tones relative to output nyquist: passband low, passband edge, alias at 1.5 and 2.5 times nyquist
+    double ratios[] = { 0.125, 0.75, 1.5, 2.5 };
+    for (int i = 0; i < sizeof(ratios) / sizeof(ratios[0]); i++) {
+        double freq = ratios[i] * c->out_rate / 2;
+        if (freq >= c->in_rate / 2) {
+            continue;
+        }
+        gen_tone(in, c, num, freq);
+        double sec = 0;
+        if (run_fused(c, in, num, &out, &sec) != 0) {
+            printf("  Fail to open fused converter\n");
+            goto _exit;
+        }
+        int ref_num = chained_ref(in, c, num, ref);
+        if (i == 0) {
+            printf("  fused %.1f Msample/s input\n", num / sec / 1e6);
+        }
+        printf("  %6.0f Hz: fused %7.2f dB  chained %7.2f dB", freq, get_rms_db(out.data, out.num, c->out_ch, skip),
+               get_rms_db(ref, ref_num, c->out_ch, skip));
+        if (c->in_rate == c->out_rate) {
+            // No filter in both, output should match within rounding
+            int max_diff = 0;
+            for (int k = 0; k < out.num * c->out_ch && k < ref_num * c->out_ch; k++) {
+                int d = abs(out.data[k] - ref[k]);
+                max_diff = d > max_diff ? d : max_diff;
+            }
+            printf("  max diff %d", max_diff);
+        }
+        printf("\n");
+    }
+    ret = 0;
+_exit:
+    free(in);
+    free(ref);
+    free(out.data);
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    int seconds = argc > 1 ? atoi(argv[1]) : 2;
+    if (seconds <= 0) {
+        printf("Usage: resample_bench [seconds]\n");
+        return 1;
+    }
+    bench_case_t cases[] = {
+        { 48000, 2, 16, 16000, 1 },
+        { 32000, 2, 16, 16000, 2 },
+        { 48000, 2, 32, 16000, 1 },
+        { 96000, 1, 24, 16000, 1 },
+        { 16000, 2, 24, 16000, 1 },
+    };
+    for (int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        if (run_case(&cases[i], seconds) != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
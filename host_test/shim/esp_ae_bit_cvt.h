@@ -0,0 +1,28 @@
+/* Host replacement of esp_ae_bit_cvt.h, chained converters are not available on host */
+#pragma once
+
+#include "esp_ae_ch_cvt.h"
+
+typedef void *esp_ae_bit_cvt_handle_t;
+
+typedef struct {
+    uint32_t sample_rate;
+    uint8_t  channel;
+    uint8_t  src_bits;
+    uint8_t  dest_bits;
+} esp_ae_bit_cvt_cfg_t;
+
+static inline esp_ae_err_t esp_ae_bit_cvt_open(esp_ae_bit_cvt_cfg_t *cfg, esp_ae_bit_cvt_handle_t *handle)
+{
+    return -1;
+}
+
+static inline esp_ae_err_t esp_ae_bit_cvt_process(esp_ae_bit_cvt_handle_t handle, uint32_t sample_num,
+                                                  esp_ae_sample_t in, esp_ae_sample_t out)
+{
+    return -1;
+}
+
+static inline void esp_ae_bit_cvt_close(esp_ae_bit_cvt_handle_t handle)
+{
+}
@@ -0,0 +1,40 @@
+/* Host replacement of esp_ae_rate_cvt.h, chained converters are not available on host */
+#pragma once
+
+#include "esp_ae_ch_cvt.h"
+
+typedef void *esp_ae_rate_cvt_handle_t;
+
+enum {
+    ESP_AE_RATE_CVT_PERF_TYPE_SPEED,
+};
+
+typedef struct {
+    uint32_t src_rate;
+    uint32_t dest_rate;
+    uint8_t  channel;
+    uint8_t  bits_per_sample;
+    uint8_t  complexity;
+    int      perf_type;
+} esp_ae_rate_cvt_cfg_t;
+
+static inline esp_ae_err_t esp_ae_rate_cvt_open(esp_ae_rate_cvt_cfg_t *cfg, esp_ae_rate_cvt_handle_t *handle)
+{
+    return -1;
+}
+
+static inline esp_ae_err_t esp_ae_rate_cvt_get_max_out_sample_num(esp_ae_rate_cvt_handle_t handle, uint32_t in_num,
+                                                                  uint32_t *out_num)
+{
+    return -1;
+}
+
+static inline esp_ae_err_t esp_ae_rate_cvt_process(esp_ae_rate_cvt_handle_t handle, esp_ae_sample_t in,
+                                                   uint32_t in_num, esp_ae_sample_t out, uint32_t *out_num)
+{
+    return -1;
+}
+
+static inline void esp_ae_rate_cvt_close(esp_ae_rate_cvt_handle_t handle)
+{
+}
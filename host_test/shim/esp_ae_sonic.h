@@ -0,0 +1,44 @@
+/* Host replacement of esp_ae_sonic.h, speed change is not supported on host */
+#pragma once
+
+#include <stdint.h>
+
+#define ESP_AE_ERR_OK (0)
+
+typedef struct {
+    uint32_t sample_rate;
+    uint8_t  channel;
+    uint8_t  bits_per_sample;
+} esp_ae_sonic_cfg_t;
+
+typedef struct {
+    void *samples;
+    int   num;
+    int   consume_num;
+} esp_ae_sonic_in_data_t;
+
+typedef struct {
+    void *samples;
+    int   needed_num;
+    int   out_num;
+} esp_ae_sonic_out_data_t;
+
+static inline int esp_ae_sonic_open(esp_ae_sonic_cfg_t *cfg, void **handle)
+{
+    return -1;
+}
+
+static inline int esp_ae_sonic_process(void *handle, esp_ae_sonic_in_data_t *in, esp_ae_sonic_out_data_t *out)
+{
+    return -1;
+}
+
+static inline int esp_ae_sonic_set_speed(void *handle, float speed)
+{
+    return -1;
+}
+
+static inline int esp_ae_sonic_close(void *handle)
+{
+    return 0;
+}
@@ -0,0 +1,20 @@
+/* Host replacement of esp_codec_dev.h, tests provide device functions as simulated sink */
+#pragma once
+
+#include <stdint.h>
+
+typedef void *esp_codec_dev_handle_t;
+
+typedef struct {
+    uint8_t  bits_per_sample;
+    uint8_t  channel;
+    uint16_t channel_mask;
+    uint32_t sample_rate;
+    int      mclk_multiple;
+} esp_codec_dev_sample_info_t;
+
+int esp_codec_dev_open(esp_codec_dev_handle_t dev, esp_codec_dev_sample_info_t *fs);
+
+int esp_codec_dev_write(esp_codec_dev_handle_t dev, void *data, int len);
+
+int esp_codec_dev_close(esp_codec_dev_handle_t dev);
@@ -0,0 +1,4 @@
+/* Host replacement of esp_lcd_panel_ops.h */
+#pragma once
+
+typedef void *esp_lcd_panel_handle_t;
@@ -0,0 +1,6 @@
+/* Host replacement of ESP-IDF esp_timer.h */
+#pragma once
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
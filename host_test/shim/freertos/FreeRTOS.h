@@ -0,0 +1,13 @@
+/* Host replacement of FreeRTOS types used by fifo_ringbuf, one tick is one millisecond */
+#pragma once
+
+#include <stdint.h>
+
+typedef long          BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t      TickType_t;
+
+#define pdTRUE             ((BaseType_t) 1)
+#define pdFALSE            ((BaseType_t) 0)
+#define portMAX_DELAY      ((TickType_t) 0xffffffffUL)
+#define pdMS_TO_TICKS(ms)  ((TickType_t) (ms))
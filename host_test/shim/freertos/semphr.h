@@ -0,0 +1,16 @@
+/* Host replacement of FreeRTOS semaphores over pthreads */
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_sem_t *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t init_count);
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+
+void vSemaphoreDelete(SemaphoreHandle_t sem);
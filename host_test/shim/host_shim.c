@@ -0,0 +1,101 @@
+/* Host implementation of ESP-IDF and FreeRTOS functions used by components under test */
+#include <stdlib.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+#include "media_lib_adapter.h"
+
+struct host_sem_t {
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    UBaseType_t     count;
+    UBaseType_t     max_count;
+};
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t init_count)
+{
+    SemaphoreHandle_t sem = (SemaphoreHandle_t) calloc(1, sizeof(struct host_sem_t));
+    if (sem == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&sem->mutex, NULL);
+    pthread_cond_init(&sem->cond, NULL);
+    sem->count = init_count;
+    sem->max_count = max_count;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    if (ticks != portMAX_DELAY) {
+        ts.tv_sec += ticks / 1000;
+        ts.tv_nsec += (long) (ticks % 1000) * 1000000;
+        if (ts.tv_nsec >= 1000000000) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+    }
+    BaseType_t ret = pdTRUE;
+    pthread_mutex_lock(&sem->mutex);
+    while (sem->count == 0) {
+        if (ticks == 0) {
+            ret = pdFALSE;
+            break;
+        }
+        if (ticks == portMAX_DELAY) {
+            pthread_cond_wait(&sem->cond, &sem->mutex);
+        } else if (pthread_cond_timedwait(&sem->cond, &sem->mutex, &ts) == ETIMEDOUT) {
+            ret = sem->count ? pdTRUE : pdFALSE;
+            break;
+        }
+    }
+    if (ret == pdTRUE) {
+        sem->count--;
+    }
+    pthread_mutex_unlock(&sem->mutex);
+    return ret;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    BaseType_t ret = pdFALSE;
+    pthread_mutex_lock(&sem->mutex);
+    if (sem->count < sem->max_count) {
+        sem->count++;
+        ret = pdTRUE;
+        pthread_cond_signal(&sem->cond);
+    }
+    pthread_mutex_unlock(&sem->mutex);
+    return ret;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    if (sem) {
+        pthread_cond_destroy(&sem->cond);
+        pthread_mutex_destroy(&sem->mutex);
+        free(sem);
+    }
+}
+
+// Register POSIX OS adapter before test main
+__attribute__((constructor)) static void host_shim_init(void)
+{
+    media_lib_add_default_os_adapter();
+}
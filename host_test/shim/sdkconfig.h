@@ -0,0 +1,2 @@
+/* Host build has no Kconfig options */
+#pragma once
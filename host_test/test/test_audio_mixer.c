@@ -0,0 +1,170 @@
+/* Tests for av_render PCM mixer, stream format equal to output so no resample is involved */
+#include <string.h>
+#include <pthread.h>
+#include "media_lib_os.h"
+#include "audio_resample.h"
+#include "audio_mixer.h"
+#include "test_common.h"
+
+#define FIFO_MS (100)
+
+static av_render_audio_frame_info_t out_info = {
+    .sample_rate = 16000,
+    .channel = 1,
+    .bits_per_sample = 16,
+};
+
+// Resample not built on host, mixer must report not supported
+audio_resample_handle_t audio_resample_open(audio_resample_cfg_t *cfg)
+{
+    return NULL;
+}
+
+int audio_resample_write(audio_resample_handle_t h, av_render_audio_frame_t *data)
+{
+    return ESP_MEDIA_ERR_NOT_SUPPORT;
+}
+
+void audio_resample_close(audio_resample_handle_t h)
+{
+}
+
+static void fill(int16_t *buf, int n, int16_t v)
+{
+    for (int i = 0; i < n; i++) {
+        buf[i] = v;
+    }
+}
+
+static void test_mix_gain(void)
+{
+    audio_mixer_t *mixer = audio_mixer_create(&out_info, FIFO_MS);
+    TEST_ASSERT(mixer != NULL);
+    int16_t main[160], out[160], data[160];
+    fill(main, 160, 1000);
+    // Only main with unity gain needs no mixing
+    TEST_ASSERT(audio_mixer_need_mix(mixer) == false);
+    int id = audio_mixer_add_stream(mixer, &out_info, 0.5f);
+    TEST_ASSERT(id > AUDIO_MIXER_MAIN_STREAM);
+    fill(data, 160, 400);
+    TEST_ASSERT_EQUAL(0, audio_mixer_write(mixer, id, (uint8_t *) data, sizeof(data)));
+    TEST_ASSERT_EQUAL(160, audio_mixer_get_pending(mixer, id));
+    TEST_ASSERT(audio_mixer_need_mix(mixer));
+    audio_mixer_process(mixer, main, out, 100);
+    TEST_ASSERT_EQUAL(1200, out[0]);
+    TEST_ASSERT_EQUAL(1200, out[99]);
+    TEST_ASSERT_EQUAL(60, audio_mixer_get_pending(mixer, 0));
+    // Stream drained in the middle of frame, rest keeps main only
+    audio_mixer_process(mixer, main, out, 100);
+    TEST_ASSERT_EQUAL(1200, out[59]);
+    TEST_ASSERT_EQUAL(1000, out[60]);
+    // Main gain and silence main
+    TEST_ASSERT_EQUAL(0, audio_mixer_set_gain(mixer, AUDIO_MIXER_MAIN_STREAM, 0.5f));
+    audio_mixer_process(mixer, main, out, 160);
+    TEST_ASSERT_EQUAL(500, out[0]);
+    TEST_ASSERT_EQUAL(0, audio_mixer_write(mixer, id, (uint8_t *) data, sizeof(data)));
+    audio_mixer_process(mixer, NULL, out, 160);
+    TEST_ASSERT_EQUAL(200, out[0]);
+    audio_mixer_destroy(mixer);
+}
+
+static void test_mix_clip(void)
+{
+    audio_mixer_t *mixer = audio_mixer_create(&out_info, FIFO_MS);
+    int id1 = audio_mixer_add_stream(mixer, &out_info, 1.0f);
+    int id2 = audio_mixer_add_stream(mixer, &out_info, 1.0f);
+    TEST_ASSERT(id1 > 0 && id2 > 0 && id1 != id2);
+    int16_t main[16], out[16], hi[16], lo[16];
+    fill(main, 16, 30000);
+    fill(hi, 16, 10000);
+    fill(lo, 16, -32768);
+    audio_mixer_write(mixer, id1, (uint8_t *) hi, sizeof(hi));
+    audio_mixer_process(mixer, main, out, 16);
+    TEST_ASSERT_EQUAL(32767, out[0]);
+    fill(main, 16, -30000);
+    audio_mixer_write(mixer, id2, (uint8_t *) lo, sizeof(lo));
+    audio_mixer_process(mixer, main, out, 16);
+    TEST_ASSERT_EQUAL(-32768, out[15]);
+    audio_mixer_destroy(mixer);
+}
+
+static void test_stream_limit(void)
+{
+    audio_mixer_t *mixer = audio_mixer_create(&out_info, FIFO_MS);
+    int ids[AUDIO_MIXER_MAX_STREAMS];
+    for (int i = 0; i < AUDIO_MIXER_MAX_STREAMS; i++) {
+        ids[i] = audio_mixer_add_stream(mixer, &out_info, 1.0f);
+        TEST_ASSERT(ids[i] > 0);
+    }
+    TEST_ASSERT_EQUAL(ESP_MEDIA_ERR_EXCEED_LIMIT, audio_mixer_add_stream(mixer, &out_info, 1.0f));
+    TEST_ASSERT_EQUAL(0, audio_mixer_remove_stream(mixer, ids[1]));
+    TEST_ASSERT_EQUAL(ESP_MEDIA_ERR_INVALID_ARG, audio_mixer_remove_stream(mixer, ids[1]));
+    TEST_ASSERT_EQUAL(ESP_MEDIA_ERR_INVALID_ARG, audio_mixer_write(mixer, ids[1], (uint8_t *) ids, 4));
+    TEST_ASSERT_EQUAL(ids[1], audio_mixer_add_stream(mixer, &out_info, 1.0f));
+    // Format differs from output needs resample
+    av_render_audio_frame_info_t other = out_info;
+    other.sample_rate = 8000;
+    audio_mixer_remove_stream(mixer, ids[0]);
+    TEST_ASSERT_EQUAL(ESP_MEDIA_ERR_NOT_SUPPORT, audio_mixer_add_stream(mixer, &other, 1.0f));
+    other.bits_per_sample = 8;
+    TEST_ASSERT_EQUAL(ESP_MEDIA_ERR_NOT_SUPPORT, audio_mixer_add_stream(mixer, &other, 1.0f));
+    audio_mixer_destroy(mixer);
+}
+
+typedef struct {
+    audio_mixer_t *mixer;
+    int            id;
+    int            written;
+} writer_ctx_t;
+
+static void *writer(void *arg)
+{
+    writer_ctx_t *ctx = (writer_ctx_t *) arg;
+    int16_t data[800];
+    fill(data, 800, 1);
+    for (int i = 0; i < 10; i++) {
+        int ret;
+        while ((ret = audio_mixer_write(ctx->mixer, ctx->id, (uint8_t *) data, sizeof(data))) == ESP_MEDIA_ERR_EXCEED_LIMIT) {
+            audio_mixer_wait_space(ctx->mixer, 1000);
+        }
+        TEST_ASSERT_EQUAL(0, ret);
+        __atomic_add_fetch(&ctx->written, 800, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+// Full fifo rejects write without consuming, mixing releases space and wakes writer
+static void test_wait_space(void)
+{
+    audio_mixer_t *mixer = audio_mixer_create(&out_info, FIFO_MS);
+    writer_ctx_t ctx = {.mixer = mixer};
+    ctx.id = audio_mixer_add_stream(mixer, &out_info, 1.0f);
+    pthread_t t;
+    pthread_create(&t, NULL, writer, &ctx);
+    int16_t out[320];
+    long long sum = 0;
+    while (__atomic_load_n(&ctx.written, __ATOMIC_RELAXED) < 8000 || audio_mixer_get_pending(mixer, 0) > 0) {
+        TEST_ASSERT(audio_mixer_get_pending(mixer, 0) <= 1600);
+        audio_mixer_process(mixer, NULL, out, 320);
+        for (int i = 0; i < 320; i++) {
+            sum += out[i];
+        }
+        media_lib_thread_sleep(1);
+    }
+    pthread_join(t, NULL);
+    TEST_ASSERT_EQUAL(8000, sum);
+    // Posted wakeup lets next waiter return without timeout
+    audio_mixer_wakeup(mixer);
+    audio_mixer_wait_space(mixer, 1000);
+    audio_mixer_destroy(mixer);
+}
+
+int main(void)
+{
+    RUN_TEST(test_mix_gain);
+    RUN_TEST(test_mix_clip);
+    RUN_TEST(test_stream_limit);
+    RUN_TEST(test_wait_space);
+    printf("All tests passed\n");
+    return 0;
+}
@@ -0,0 +1,152 @@
+/* Tests for YUV420 to RGB565 conversion on table, per pixel calculation and rotate path */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "color_convert.h"
+#include "test_common.h"
+
+#define GUARD_SIZE (64)
+
+static void convert_frame(int w, int h, bool no_table, int rotate, av_render_video_frame_type_t to, uint8_t *src,
+                          uint16_t *out)
+{
+    color_convert_cfg_t cfg = {
+        .from = AV_RENDER_VIDEO_RAW_TYPE_YUV420,
+        .to = to,
+        .width = w,
+        .height = h,
+        .rotate = rotate,
+        .no_table = no_table,
+    };
+    color_convert_table_t t = init_convert_table(&cfg);
+    TEST_ASSERT(t != NULL);
+    int src_size = convert_table_get_image_size(AV_RENDER_VIDEO_RAW_TYPE_YUV420, w, h);
+    int dst_size = w * h * 2;
+    // Guard area after output must stay untouched
+    uint8_t *dst = (uint8_t *)malloc(dst_size + GUARD_SIZE);
+    TEST_ASSERT(dst != NULL);
+    memset(dst, 0xA5, dst_size + GUARD_SIZE);
+    TEST_ASSERT_EQUAL(0, convert_color(t, src, src_size, dst, dst_size));
+    for (int i = 0; i < GUARD_SIZE; i++) {
+        TEST_ASSERT_EQUAL(0xA5, dst[dst_size + i]);
+    }
+    memcpy(out, dst, dst_size);
+    free(dst);
+    deinit_convert_table(t);
+}
+
+static void check_size(int w, int h)
+{
+    int src_size = convert_table_get_image_size(AV_RENDER_VIDEO_RAW_TYPE_YUV420, w, h);
+    TEST_ASSERT_EQUAL(w * h + ((w + 1) / 2) * ((h + 1) / 2) * 2, src_size);
+    uint8_t *src = (uint8_t *)malloc(src_size);
+    uint16_t *calc = (uint16_t *)malloc(w * h * 2);
+    uint16_t *table = (uint16_t *)malloc(w * h * 2);
+    uint16_t *be = (uint16_t *)malloc(w * h * 2);
+    TEST_ASSERT(src && calc && table && be);
+    for (int i = 0; i < src_size; i++) {
+        src[i] = (uint8_t)(i * 7 + (i >> 5));
+    }
+    convert_frame(w, h, true, 0, AV_RENDER_VIDEO_RAW_TYPE_RGB565, src, calc);
+    convert_frame(w, h, false, 0, AV_RENDER_VIDEO_RAW_TYPE_RGB565, src, table);
+    convert_frame(w, h, true, 0, AV_RENDER_VIDEO_RAW_TYPE_RGB565_BE, src, be);
+    for (int i = 0; i < w * h; i++) {
+        TEST_ASSERT_EQUAL(calc[i], __builtin_bswap16(be[i]));
+        // Table quantize input, allow small error on each channel
+        int dr = abs((calc[i] >> 11) - (table[i] >> 11));
+        int dg = abs(((calc[i] >> 5) & 0x3F) - ((table[i] >> 5) & 0x3F));
+        int db = abs((calc[i] & 0x1F) - (table[i] & 0x1F));
+        TEST_ASSERT(dr <= 4 && dg <= 8 && db <= 4);
+    }
+    free(src);
+    free(calc);
+    free(table);
+    free(be);
+}
+
+static void test_even_size(void)
+{
+    check_size(64, 48);
+}
+
+static void test_odd_size(void)
+{
+    check_size(64, 47);
+    check_size(33, 17);
+    check_size(1, 1);
+}
+
+static void test_last_line(void)
+{
+    // Last line of odd height use last chroma line
+    int w = 4, h = 3;
+    int src_size = convert_table_get_image_size(AV_RENDER_VIDEO_RAW_TYPE_YUV420, w, h);
+    uint8_t *src = (uint8_t *)malloc(src_size);
+    uint16_t out[12];
+    TEST_ASSERT(src != NULL);
+    memset(src, 128, src_size);
+    memset(src, 235, w * h);
+    // Second chroma line strong blue
+    src[w * h + 2] = 240;
+    src[w * h + 3] = 240;
+    convert_frame(w, h, true, 0, AV_RENDER_VIDEO_RAW_TYPE_RGB565, src, out);
+    TEST_ASSERT_EQUAL(0xFFFF, out[0]);
+    TEST_ASSERT(out[8] != 0xFFFF && (out[8] & 0x1F) == 0x1F);
+    TEST_ASSERT_EQUAL(out[8], out[11]);
+    free(src);
+}
+
+static void check_rotate(int w, int h, int rotate, av_render_video_frame_type_t to)
+{
+    int src_size = convert_table_get_image_size(AV_RENDER_VIDEO_RAW_TYPE_YUV420, w, h);
+    uint8_t *src = (uint8_t *)malloc(src_size);
+    uint16_t *ref = (uint16_t *)malloc(w * h * 2);
+    uint16_t *out = (uint16_t *)malloc(w * h * 2);
+    TEST_ASSERT(src && ref && out);
+    for (int i = 0; i < src_size; i++) {
+        src[i] = (uint8_t)(i * 13 + (i >> 4));
+    }
+    convert_frame(w, h, true, 0, to, src, ref);
+    convert_frame(w, h, true, rotate, to, src, out);
+    // Rotated output must be exact pixel move of unrotated output
+    int ow = (rotate == 90 || rotate == 270) ? h : w;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            int ox = x, oy = y;
+            if (rotate == 90) {
+                ox = h - 1 - y;
+                oy = x;
+            } else if (rotate == 180) {
+                ox = w - 1 - x;
+                oy = h - 1 - y;
+            } else if (rotate == 270) {
+                ox = y;
+                oy = w - 1 - x;
+            }
+            TEST_ASSERT_EQUAL(ref[y * w + x], out[oy * ow + ox]);
+        }
+    }
+    free(src);
+    free(ref);
+    free(out);
+}
+
+static void test_rotate(void)
+{
+    int rotates[] = { 90, 180, 270 };
+    for (int i = 0; i < 3; i++) {
+        check_rotate(64, 48, rotates[i], AV_RENDER_VIDEO_RAW_TYPE_RGB565);
+        check_rotate(33, 17, rotates[i], AV_RENDER_VIDEO_RAW_TYPE_RGB565);
+        check_rotate(16, 8, rotates[i], AV_RENDER_VIDEO_RAW_TYPE_RGB565_BE);
+    }
+}
+
+int main(void)
+{
+    RUN_TEST(test_even_size);
+    RUN_TEST(test_odd_size);
+    RUN_TEST(test_last_line);
+    RUN_TEST(test_rotate);
+    printf("All tests passed\n");
+    return 0;
+}
@@ -0,0 +1,33 @@
+/* Minimal assertion helpers for host tests, failing check aborts test program with location */
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+
+#define TEST_ASSERT(cond)                                                       \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            abort();                                                            \
+        }                                                                       \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expect, actual)                                       \
+    do {                                                                        \
+        long long _e = (long long) (expect), _a = (long long) (actual);         \
+        if (_e != _a) {                                                         \
+            fprintf(stderr, "%s:%d: expect %s == %lld, got %lld\n", __FILE__, __LINE__, #actual, _e, _a); \
+            abort();                                                            \
+        }                                                                       \
+    } while (0)
+
+// Run one test case, alarm turns a hang into failure
+#define RUN_TEST(func)                                                          \
+    do {                                                                        \
+        printf("Run %s\n", #func);                                              \
+        alarm(30);                                                              \
+        func();                                                                 \
+        alarm(0);                                                               \
+    } while (0)
@@ -0,0 +1,248 @@
+/* Tests for data_queue in mutex, SPSC and pool mode */
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "data_queue.h"
+#include "test_common.h"
+
+#define STRESS_ITEMS (100000)
+
+typedef struct {
+    data_queue_t *q;
+    int           items;
+    int           produced;
+    int           done;
+    uint32_t      sum;
+} stress_ctx_t;
+
+static int item_size(int i)
+{
+    return 8 + (i * 37) % 696;
+}
+
+static void *stress_producer(void *arg)
+{
+    stress_ctx_t *ctx = (stress_ctx_t *) arg;
+    for (int i = 0; i < ctx->items; i++) {
+        int size = item_size(i);
+        uint8_t *b = (uint8_t *) data_queue_get_buffer(ctx->q, size);
+        TEST_ASSERT(b != NULL);
+        memcpy(b, &i, sizeof(i));
+        memset(b + 4, (uint8_t) i, size - 4);
+        data_queue_send_buffer(ctx->q, size);
+    }
+    __atomic_store_n(&ctx->produced, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// Items arrive in order with intact content through ring back
+static void check_order(data_queue_t *q)
+{
+    stress_ctx_t ctx = {.q = q, .items = STRESS_ITEMS};
+    pthread_t t;
+    pthread_create(&t, NULL, stress_producer, &ctx);
+    for (int i = 0; i < ctx.items; i++) {
+        void *buf = NULL;
+        int size = 0;
+        TEST_ASSERT_EQUAL(0, data_queue_read_lock(q, &buf, &size));
+        TEST_ASSERT_EQUAL(item_size(i), size);
+        int seq;
+        memcpy(&seq, buf, sizeof(seq));
+        TEST_ASSERT_EQUAL(i, seq);
+        TEST_ASSERT_EQUAL((uint8_t) i, ((uint8_t *) buf)[size - 1]);
+        data_queue_read_unlock(q);
+    }
+    pthread_join(t, NULL);
+    int num = -1, bytes = -1;
+    data_queue_query(q, &num, &bytes);
+    TEST_ASSERT_EQUAL(0, num);
+    TEST_ASSERT_EQUAL(0, bytes);
+}
+
+static void test_mutex_order(void)
+{
+    data_queue_t *q = data_queue_init(4096);
+    check_order(q);
+    data_queue_deinit(q);
+}
+
+static void test_spsc_order(void)
+{
+    data_queue_t *q = data_queue_init_spsc(4096);
+    check_order(q);
+    data_queue_deinit(q);
+}
+
+static void test_pool_order(void)
+{
+    data_queue_cfg_t cfg = {
+        .block_size = 704,
+        .block_num = 4,
+    };
+    data_queue_t *q = data_queue_init_with_cfg(&cfg);
+    TEST_ASSERT(q != NULL);
+    check_order(q);
+    data_queue_deinit(q);
+}
+
+static void send_value(data_queue_t *q, int v)
+{
+    int *b = (int *) data_queue_get_buffer(q, sizeof(int));
+    TEST_ASSERT(b != NULL);
+    *b = v;
+    data_queue_send_buffer(q, sizeof(int));
+}
+
+static int read_value(data_queue_t *q)
+{
+    void *buf = NULL;
+    int size = 0;
+    TEST_ASSERT_EQUAL(0, data_queue_read_lock(q, &buf, &size));
+    return *(int *) buf;
+}
+
+static void test_spsc_peek(void)
+{
+    data_queue_t *q = data_queue_init_spsc(1024);
+    send_value(q, 1);
+    send_value(q, 2);
+    TEST_ASSERT_EQUAL(1, read_value(q));
+    data_queue_peek_unlock(q);
+    TEST_ASSERT_EQUAL(1, read_value(q));
+    data_queue_read_unlock(q);
+    TEST_ASSERT_EQUAL(2, read_value(q));
+    data_queue_read_unlock(q);
+    TEST_ASSERT(data_queue_have_data(q) == false);
+    TEST_ASSERT_EQUAL(0, q->user);
+    data_queue_deinit(q);
+}
+
+static void *consume_all_thread(void *arg)
+{
+    data_queue_consume_all((data_queue_t *) arg);
+    return NULL;
+}
+
+// Consume all from other thread must not free item held by reader, and unlock still release user
+static void test_spsc_consume_all_while_locked(void)
+{
+    data_queue_t *q = data_queue_init_spsc(1024);
+    send_value(q, 1);
+    send_value(q, 2);
+    send_value(q, 3);
+    void *buf = NULL;
+    int size = 0;
+    TEST_ASSERT_EQUAL(0, data_queue_read_lock(q, &buf, &size));
+    pthread_t t;
+    pthread_create(&t, NULL, consume_all_thread, q);
+    pthread_join(t, NULL);
+    // Locked item kept, producer can not reuse its memory
+    TEST_ASSERT_EQUAL(1, *(int *) buf);
+    TEST_ASSERT(data_queue_have_data(q));
+    data_queue_read_unlock(q);
+    // Deferred consume all done on unlock
+    TEST_ASSERT(data_queue_have_data(q) == false);
+    TEST_ASSERT_EQUAL(0, q->user);
+    send_value(q, 4);
+    TEST_ASSERT_EQUAL(4, read_value(q));
+    data_queue_read_unlock(q);
+    TEST_ASSERT_EQUAL(0, q->user);
+    // Wakeup waits for all users, must not hang
+    data_queue_wakeup(q);
+    data_queue_deinit(q);
+}
+
+static void test_spsc_consume_all_idle(void)
+{
+    data_queue_t *q = data_queue_init_spsc(1024);
+    send_value(q, 1);
+    send_value(q, 2);
+    data_queue_consume_all(q);
+    TEST_ASSERT(data_queue_have_data(q) == false);
+    int num = -1, bytes = -1;
+    data_queue_query(q, &num, &bytes);
+    TEST_ASSERT_EQUAL(0, num);
+    send_value(q, 3);
+    TEST_ASSERT_EQUAL(3, read_value(q));
+    data_queue_read_unlock(q);
+    data_queue_deinit(q);
+}
+
+static void *flush_loop(void *arg)
+{
+    stress_ctx_t *ctx = (stress_ctx_t *) arg;
+    while (!__atomic_load_n(&ctx->done, __ATOMIC_ACQUIRE)) {
+        data_queue_consume_all(ctx->q);
+        usleep(50);
+    }
+    return NULL;
+}
+
+// Consumer keep reading while other thread flush, order kept and no item corrupted
+static void test_spsc_consume_all_stress(void)
+{
+    data_queue_t *q = data_queue_init_spsc(4096);
+    stress_ctx_t ctx = {.q = q, .items = STRESS_ITEMS};
+    pthread_t producer, flusher;
+    pthread_create(&producer, NULL, stress_producer, &ctx);
+    pthread_create(&flusher, NULL, flush_loop, &ctx);
+    int last = -1;
+    while (last < ctx.items - 1) {
+        void *buf = NULL;
+        int size = 0;
+        if (data_queue_read_lock_timeout(q, &buf, &size, 100) != 0) {
+            // Last items may be flushed
+            if (__atomic_load_n(&ctx.produced, __ATOMIC_ACQUIRE) && data_queue_have_data(q) == false) {
+                break;
+            }
+            continue;
+        }
+        int seq;
+        memcpy(&seq, buf, sizeof(seq));
+        TEST_ASSERT(seq > last);
+        TEST_ASSERT_EQUAL(item_size(seq), size);
+        TEST_ASSERT_EQUAL((uint8_t) seq, ((uint8_t *) buf)[size - 1]);
+        last = seq;
+        data_queue_read_unlock(q);
+    }
+    __atomic_store_n(&ctx.done, 1, __ATOMIC_RELEASE);
+    pthread_join(producer, NULL);
+    pthread_join(flusher, NULL);
+    TEST_ASSERT_EQUAL(0, q->user);
+    data_queue_wakeup(q);
+    data_queue_deinit(q);
+}
+
+static void test_spsc_batch(void)
+{
+    data_queue_t *q = data_queue_init_spsc(1024);
+    for (int i = 0; i < 5; i++) {
+        send_value(q, i);
+    }
+    data_queue_iov_t iov[8];
+    int n = 0;
+    TEST_ASSERT_EQUAL(0, data_queue_read_lock_batch(q, iov, 3, &n));
+    TEST_ASSERT_EQUAL(3, n);
+    for (int i = 0; i < n; i++) {
+        TEST_ASSERT_EQUAL(i, *(int *) iov[i].buffer);
+    }
+    data_queue_read_unlock_batch(q, n);
+    TEST_ASSERT_EQUAL(3, read_value(q));
+    data_queue_read_unlock(q);
+    TEST_ASSERT_EQUAL(0, q->user);
+    data_queue_deinit(q);
+}
+
+int main(void)
+{
+    RUN_TEST(test_mutex_order);
+    RUN_TEST(test_spsc_order);
+    RUN_TEST(test_pool_order);
+    RUN_TEST(test_spsc_peek);
+    RUN_TEST(test_spsc_consume_all_idle);
+    RUN_TEST(test_spsc_consume_all_while_locked);
+    RUN_TEST(test_spsc_consume_all_stress);
+    RUN_TEST(test_spsc_batch);
+    printf("All tests passed\n");
+    return 0;
+}
@@ -0,0 +1,171 @@
+/* Tests for fifo_ringbuf copy and slot reservation API */
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "fifo_ringbuf.h"
+#include "test_common.h"
+
+#define ITEM_SIZE    (64)
+#define STRESS_ITEMS (200000)
+
+static void write_value(fifo_ringbuf_t *rb, int v)
+{
+    TEST_ASSERT_EQUAL(sizeof(v), fifo_ringbuf_write(rb, &v, sizeof(v)));
+}
+
+static int read_value(fifo_ringbuf_t *rb)
+{
+    int v = -1;
+    TEST_ASSERT_EQUAL(sizeof(v), fifo_ringbuf_read(rb, &v, sizeof(v), 0));
+    return v;
+}
+
+static void test_order_and_overwrite(void)
+{
+    fifo_ringbuf_t *rb = fifo_ringbuf_init(4, ITEM_SIZE);
+    for (int i = 0; i < 6; i++) {
+        write_value(rb, i);
+    }
+    // Oldest two dropped
+    for (int i = 2; i < 6; i++) {
+        TEST_ASSERT_EQUAL(i, read_value(rb));
+    }
+    int v;
+    TEST_ASSERT_EQUAL(0, fifo_ringbuf_read(rb, &v, sizeof(v), 0));
+    fifo_ringbuf_release(rb);
+}
+
+// Writer must never get a slot held by reader even when ring is full
+static void test_full_with_reader(void)
+{
+    fifo_ringbuf_t *rb = fifo_ringbuf_init(4, ITEM_SIZE);
+    for (int i = 0; i < 4; i++) {
+        write_value(rb, i);
+    }
+    void *held = NULL;
+    size_t items = 0;
+    fifo_ringbuf_acquire_read(rb, &held, 1, &items, 0);
+    TEST_ASSERT_EQUAL(1, items);
+    TEST_ASSERT_EQUAL(0, *(int *) held);
+    for (int i = 0; i < 8; i++) {
+        void *slot = fifo_ringbuf_acquire_write(rb);
+        TEST_ASSERT(slot != held);
+        if (slot) {
+            *(int *) slot = 100 + i;
+            fifo_ringbuf_commit_write(rb, sizeof(int));
+        }
+    }
+    TEST_ASSERT_EQUAL(0, *(int *) held);
+    fifo_ringbuf_release_read(rb, items);
+    // Unread packets kept in order
+    TEST_ASSERT_EQUAL(1, read_value(rb));
+    TEST_ASSERT_EQUAL(2, read_value(rb));
+    TEST_ASSERT_EQUAL(3, read_value(rb));
+    // Space released by reader is writable again
+    write_value(rb, 7);
+    TEST_ASSERT_EQUAL(7, read_value(rb));
+    fifo_ringbuf_release(rb);
+}
+
+static void test_contiguous_read(void)
+{
+    fifo_ringbuf_t *rb = fifo_ringbuf_init(4, ITEM_SIZE);
+    uint8_t full[ITEM_SIZE];
+    for (int i = 0; i < 3; i++) {
+        memset(full, i, sizeof(full));
+        fifo_ringbuf_write(rb, full, sizeof(full));
+    }
+    void *data = NULL;
+    size_t items = 0;
+    size_t bytes = fifo_ringbuf_acquire_read(rb, &data, 8, &items, 0);
+    TEST_ASSERT_EQUAL(3, items);
+    TEST_ASSERT_EQUAL(3 * ITEM_SIZE, bytes);
+    TEST_ASSERT_EQUAL(2, ((uint8_t *) data)[bytes - 1]);
+    fifo_ringbuf_release_read(rb, items);
+    // Ring back stops at buffer end
+    fifo_ringbuf_write(rb, full, sizeof(full));
+    fifo_ringbuf_write(rb, full, sizeof(full));
+    bytes = fifo_ringbuf_acquire_read(rb, &data, 8, &items, 0);
+    TEST_ASSERT_EQUAL(1, items);
+    fifo_ringbuf_release_read(rb, items);
+    // Partial packet ends continuous run
+    fifo_ringbuf_write(rb, full, 10);
+    fifo_ringbuf_write(rb, full, sizeof(full));
+    bytes = fifo_ringbuf_acquire_read(rb, &data, 8, &items, 0);
+    TEST_ASSERT_EQUAL(2, items);
+    TEST_ASSERT_EQUAL(ITEM_SIZE + 10, bytes);
+    fifo_ringbuf_release_read(rb, items);
+    bytes = fifo_ringbuf_acquire_read(rb, &data, 8, &items, 0);
+    TEST_ASSERT_EQUAL(1, items);
+    TEST_ASSERT_EQUAL(ITEM_SIZE, bytes);
+    fifo_ringbuf_release_read(rb, items);
+    fifo_ringbuf_release(rb);
+}
+
+typedef struct {
+    fifo_ringbuf_t *rb;
+    int             done;
+} stress_ctx_t;
+
+static void *stress_writer(void *arg)
+{
+    stress_ctx_t *ctx = (stress_ctx_t *) arg;
+    for (int i = 0; i < STRESS_ITEMS; i++) {
+        uint32_t *slot = (uint32_t *) fifo_ringbuf_acquire_write(ctx->rb);
+        if (slot == NULL) {
+            continue;
+        }
+        for (int k = 0; k < ITEM_SIZE / 4; k++) {
+            slot[k] = i;
+        }
+        fifo_ringbuf_commit_write(ctx->rb, ITEM_SIZE);
+    }
+    __atomic_store_n(&ctx->done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// Held slots keep content while writer overruns the ring
+static void test_stress_reserve(void)
+{
+    stress_ctx_t ctx = {.rb = fifo_ringbuf_init(4, ITEM_SIZE)};
+    pthread_t t;
+    pthread_create(&t, NULL, stress_writer, &ctx);
+    int last = -1;
+    while (1) {
+        void *data = NULL;
+        size_t items = 0;
+        fifo_ringbuf_acquire_read(ctx.rb, &data, 2, &items, 10);
+        if (items == 0) {
+            if (__atomic_load_n(&ctx.done, __ATOMIC_ACQUIRE)) {
+                break;
+            }
+            continue;
+        }
+        uint32_t *p = (uint32_t *) data;
+        int first = p[0];
+        TEST_ASSERT(first > last);
+        sched_yield();
+        for (size_t n = 0; n < items; n++) {
+            uint32_t *item = p + n * ITEM_SIZE / 4;
+            for (int k = 0; k < ITEM_SIZE / 4; k++) {
+                TEST_ASSERT_EQUAL(item[0], item[k]);
+            }
+            TEST_ASSERT((int) item[0] > last);
+            last = item[0];
+        }
+        TEST_ASSERT_EQUAL(first, p[0]);
+        fifo_ringbuf_release_read(ctx.rb, items);
+    }
+    pthread_join(t, NULL);
+    fifo_ringbuf_release(ctx.rb);
+}
+
+int main(void)
+{
+    RUN_TEST(test_order_and_overwrite);
+    RUN_TEST(test_full_with_reader);
+    RUN_TEST(test_contiguous_read);
+    RUN_TEST(test_stress_reserve);
+    printf("All tests passed\n");
+    return 0;
+}
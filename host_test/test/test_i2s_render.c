@@ -0,0 +1,144 @@
+/* Check i2s_render output latency estimation against a simulated I2S sink */
+#include <stdlib.h>
+#include <unistd.h>
+#include "esp_timer.h"
+#include "esp_codec_dev.h"
+#include "av_render_default.h"
+#include "audio_render.h"
+#include "test_common.h"
+
+#define SINK_RATE        (16000)
+#define SINK_DMA_FRAMES  (1280)
+#define SINK_START_DELAY (4000)
+#define FRAME_MS         (20)
+#define FRAME_SAMPLES    (SINK_RATE * FRAME_MS / 1000)
+
+// Sink drains DMA at sample rate of a slightly drifting clock, starts after a fixed delay
+typedef struct {
+    double  drift;
+    double  level;
+    int64_t last;
+    int64_t start_at;
+    bool    started;
+} sink_t;
+
+static sink_t sink;
+
+static void sink_drain(void)
+{
+    int64_t now = esp_timer_get_time();
+    if (sink.started && now > sink.start_at) {
+        int64_t from = sink.last > sink.start_at ? sink.last : sink.start_at;
+        sink.level -= (now - from) * SINK_RATE * sink.drift / 1000000;
+        if (sink.level < 0) {
+            sink.level = 0;
+        }
+    }
+    sink.last = now;
+}
+
+static double sink_latency_ms(void)
+{
+    sink_drain();
+    return sink.level * 1000 / (SINK_RATE * sink.drift);
+}
+
+int esp_codec_dev_open(esp_codec_dev_handle_t dev, esp_codec_dev_sample_info_t *fs)
+{
+    sink.level = 0;
+    sink.started = false;
+    return 0;
+}
+
+// Blocks until data fits into DMA like I2S driver
+int esp_codec_dev_write(esp_codec_dev_handle_t dev, void *data, int len)
+{
+    int frames = len / sizeof(int16_t);
+    sink_drain();
+    if (sink.started == false) {
+        sink.started = true;
+        sink.start_at = esp_timer_get_time() + SINK_START_DELAY;
+        sink.last = sink.start_at;
+    }
+    while (sink.level + frames > SINK_DMA_FRAMES) {
+        usleep(500);
+        sink_drain();
+    }
+    sink.level += frames;
+    return 0;
+}
+
+int esp_codec_dev_close(esp_codec_dev_handle_t dev)
+{
+    return 0;
+}
+
+// Bursty producer with one long underrun, reported latency must follow real queued duration
+static void run_sink(double drift, int frames)
+{
+    sink.drift = drift;
+    i2s_render_cfg_t cfg = {
+        .play_handle = (esp_codec_dev_handle_t) 1,
+        .dma_frames = SINK_DMA_FRAMES,
+    };
+    audio_render_handle_t render = av_render_alloc_i2s_render(&cfg);
+    TEST_ASSERT(render != NULL);
+    av_render_audio_frame_info_t info = {
+        .channel = 1,
+        .bits_per_sample = 16,
+        .sample_rate = SINK_RATE,
+    };
+    TEST_ASSERT_EQUAL(0, audio_render_open(render, &info));
+    static int16_t pcm[FRAME_SAMPLES];
+    double err_sum = 0, err_max = 0, true_sum = 0;
+    srand(1);
+    for (int i = 0; i < frames; i++) {
+        av_render_audio_frame_t frame = {
+            .pts = i * FRAME_MS,
+            .data = (uint8_t *) pcm,
+            .size = sizeof(pcm),
+        };
+        TEST_ASSERT_EQUAL(0, audio_render_write(render, &frame));
+        if (i == frames / 2) {
+            usleep(200000);
+        }
+        if (i % 7 == 0) {
+            usleep(rand() % 15000);
+        }
+        uint32_t latency = 0;
+        TEST_ASSERT_EQUAL(0, audio_render_get_latency(render, &latency));
+        double real = sink_latency_ms();
+        double err = latency > real ? latency - real : real - latency;
+        err_sum += err;
+        if (err > err_max) {
+            err_max = err;
+        }
+        true_sum += real;
+    }
+    printf("drift %.4f: true latency avg %.1f ms, estimate error avg %.2f ms max %.2f ms\n", drift,
+           true_sum / frames, err_sum / frames, err_max);
+    // Estimation error far below the 200 ms sync tolerance it is used for
+    TEST_ASSERT(err_sum / frames < 5);
+    TEST_ASSERT(err_max < 20);
+    audio_render_close(render);
+    audio_render_free_handle(render);
+}
+
+static void test_latency_exact_clock(void)
+{
+    run_sink(1.0, 150);
+}
+
+static void test_latency_drift_clock(void)
+{
+    run_sink(1.001, 150);
+    run_sink(0.999, 150);
+}
+
+int main(void)
+{
+    RUN_TEST(test_latency_exact_clock);
+    RUN_TEST(test_latency_drift_clock);
+    printf("All tests passed\n");
+    return 0;
+}
@@ -0,0 +1,113 @@
+/* Tests for queue statistics registry and counters */
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "queue_stats.h"
+#include "data_queue.h"
+#include "test_common.h"
+
+#define STRESS_ITEMS (200000)
+
+static queue_stats_t *find_stats(const char *name, queue_stats_t *out)
+{
+    queue_stats_t all[16];
+    int n = queue_stats_snapshot(all, 16);
+    for (int i = 0; i < n; i++) {
+        if (strcmp(all[i].name, name) == 0) {
+            *out = all[i];
+            return out;
+        }
+    }
+    return NULL;
+}
+
+static void test_counters(void)
+{
+    queue_stats_t *stats = queue_stats_register("cnt", QUEUE_STATS_TYPE_MSG_Q);
+    TEST_ASSERT(stats != NULL);
+    queue_stats_push(stats, 10);
+    queue_stats_push(stats, 20);
+    queue_stats_pop(stats, 10);
+    queue_stats_drop(stats);
+    queue_stats_producer_wait(stats, queue_stats_now() - 2000);
+    queue_stats_t s;
+    TEST_ASSERT(find_stats("cnt", &s) != NULL);
+    TEST_ASSERT_EQUAL(1, s.items);
+    TEST_ASSERT_EQUAL(20, s.bytes);
+    TEST_ASSERT_EQUAL(2, s.max_items);
+    TEST_ASSERT_EQUAL(30, s.max_bytes);
+    TEST_ASSERT_EQUAL(1, s.drops);
+    TEST_ASSERT(s.producer_wait_us >= 2000);
+    queue_stats_unregister(stats);
+    TEST_ASSERT(find_stats("cnt", &s) == NULL);
+    // Disabled statistics is NULL and record APIs accept it
+    queue_stats_push(NULL, 1);
+    queue_stats_pop(NULL, 1);
+    queue_stats_drop(NULL);
+}
+
+typedef struct {
+    data_queue_t *q;
+    int           done;
+} stress_ctx_t;
+
+static void *consumer(void *arg)
+{
+    stress_ctx_t *ctx = (stress_ctx_t *) arg;
+    for (int i = 0; i < STRESS_ITEMS; i++) {
+        void *buf;
+        int size;
+        TEST_ASSERT_EQUAL(0, data_queue_read_lock(ctx->q, &buf, &size));
+        data_queue_read_unlock(ctx->q);
+    }
+    __atomic_store_n(&ctx->done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// SPSC consumer pops right after publish, item counter must never go below zero
+static void test_spsc_no_underflow(void)
+{
+    data_queue_t *q = data_queue_init_spsc(1024);
+    TEST_ASSERT_EQUAL(0, data_queue_enable_stats(q, "spsc"));
+    stress_ctx_t ctx = {.q = q};
+    pthread_t t;
+    pthread_create(&t, NULL, consumer, &ctx);
+    for (int i = 0; i < STRESS_ITEMS; i++) {
+        void *b = data_queue_get_buffer(q, 8);
+        TEST_ASSERT(b != NULL);
+        data_queue_send_buffer(q, 8);
+        TEST_ASSERT(__atomic_load_n(&q->stats->items, __ATOMIC_RELAXED) <= 1024);
+    }
+    pthread_join(t, NULL);
+    queue_stats_t s;
+    TEST_ASSERT(find_stats("spsc", &s) != NULL);
+    TEST_ASSERT_EQUAL(0, s.items);
+    TEST_ASSERT_EQUAL(0, s.bytes);
+    TEST_ASSERT(s.max_items <= 1024);
+    data_queue_deinit(q);
+}
+
+// Quick stop and restart keeps only one dump thread
+static void test_dump_restart(void)
+{
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL(0, queue_stats_start_dump(20));
+        queue_stats_stop_dump();
+    }
+    TEST_ASSERT_EQUAL(0, queue_stats_start_dump(20));
+    TEST_ASSERT_EQUAL(0, queue_stats_start_dump(20));
+    usleep(50000);
+    queue_stats_stop_dump();
+    usleep(50000);
+}
+
+int main(void)
+{
+    queue_stats_set_enable(true);
+    RUN_TEST(test_counters);
+    RUN_TEST(test_spsc_no_underflow);
+    RUN_TEST(test_dump_restart);
+    printf("All tests passed\n");
+    return 0;
+}
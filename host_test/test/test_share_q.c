@@ -0,0 +1,156 @@
+/* Tests for share_q dispatch and release */
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "share_q.h"
+#include "test_common.h"
+
+#define Q_COUNT      (5)
+#define POOL_NUM     (Q_COUNT + 1)
+#define STRESS_ITEMS (50000)
+
+typedef struct {
+    uint8_t *data;
+    int      seq;
+} frame_t;
+
+static int released[STRESS_ITEMS];
+
+static void *get_frame_data(void *item)
+{
+    return ((frame_t *) item)->data;
+}
+
+static int release_frame(void *item, void *ctx)
+{
+    frame_t *frame = (frame_t *) item;
+    __atomic_add_fetch(&released[frame->seq], 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+static share_q_handle_t create_q(int users)
+{
+    share_q_cfg_t cfg = {
+        .user_count = users,
+        .q_count = Q_COUNT,
+        .item_size = sizeof(frame_t),
+        .get_frame_data = get_frame_data,
+        .release_frame = release_frame,
+    };
+    share_q_handle_t q = share_q_create(&cfg);
+    TEST_ASSERT(q != NULL);
+    for (int i = 0; i < users; i++) {
+        share_q_enable(q, i, true);
+    }
+    return q;
+}
+
+// Frame released only after all users released, in any order
+static void test_release_out_of_order(void)
+{
+    memset(released, 0, sizeof(released));
+    share_q_handle_t q = create_q(2);
+    static uint8_t pool[4];
+    for (int i = 0; i < 4; i++) {
+        frame_t f = {.data = &pool[i], .seq = i};
+        TEST_ASSERT_EQUAL(0, share_q_add(q, &f));
+    }
+    frame_t got[2][4];
+    for (int u = 0; u < 2; u++) {
+        for (int i = 0; i < 4; i++) {
+            TEST_ASSERT_EQUAL(0, share_q_recv(q, u, &got[u][i]));
+            TEST_ASSERT_EQUAL(i, got[u][i].seq);
+        }
+    }
+    // User 0 release reversed, user 1 release in order
+    for (int i = 3; i >= 0; i--) {
+        TEST_ASSERT_EQUAL(0, share_q_release(q, &got[0][i]));
+        TEST_ASSERT_EQUAL(0, released[i]);
+    }
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL(0, share_q_release(q, &got[1][i]));
+        TEST_ASSERT_EQUAL(1, released[i]);
+    }
+    // Releasing again is rejected
+    TEST_ASSERT(share_q_release(q, &got[1][0]) != 0);
+    share_q_destroy(q);
+}
+
+// Same frame data reused while older item with it is released but not retired
+static void test_frame_data_reuse(void)
+{
+    memset(released, 0, sizeof(released));
+    share_q_handle_t q = create_q(1);
+    static uint8_t pool[2];
+    frame_t a = {.data = &pool[0], .seq = 0};
+    frame_t b = {.data = &pool[1], .seq = 1};
+    frame_t c = {.data = &pool[1], .seq = 2};
+    share_q_add(q, &a);
+    share_q_add(q, &b);
+    frame_t got;
+    share_q_recv(q, 0, &got);
+    share_q_recv(q, 0, &got);
+    // b released out of order, slot kept until a released
+    TEST_ASSERT_EQUAL(0, share_q_release(q, &got));
+    share_q_add(q, &c);
+    share_q_recv(q, 0, &got);
+    TEST_ASSERT_EQUAL(2, got.seq);
+    TEST_ASSERT_EQUAL(0, share_q_release(q, &got));
+    TEST_ASSERT_EQUAL(1, released[2]);
+    TEST_ASSERT_EQUAL(0, share_q_release(q, &a));
+    TEST_ASSERT_EQUAL(1, released[0]);
+    TEST_ASSERT_EQUAL(1, released[1]);
+    share_q_destroy(q);
+}
+
+typedef struct {
+    share_q_handle_t q;
+    int              user;
+} consumer_t;
+
+static void *consumer_thread(void *arg)
+{
+    consumer_t *c = (consumer_t *) arg;
+    for (int i = 0; i < STRESS_ITEMS; i++) {
+        frame_t f;
+        TEST_ASSERT_EQUAL(0, share_q_recv(c->q, c->user, &f));
+        TEST_ASSERT_EQUAL(i, f.seq);
+        TEST_ASSERT_EQUAL(0, share_q_release(c->q, &f));
+    }
+    return NULL;
+}
+
+// Every frame released exactly once with concurrent users
+static void test_stress(void)
+{
+    memset(released, 0, sizeof(released));
+    share_q_handle_t q = create_q(3);
+    static uint8_t pool[POOL_NUM];
+    consumer_t c[3];
+    pthread_t t[3];
+    for (int i = 0; i < 3; i++) {
+        c[i] = (consumer_t) {.q = q, .user = i};
+        pthread_create(&t[i], NULL, consumer_thread, &c[i]);
+    }
+    for (int i = 0; i < STRESS_ITEMS; i++) {
+        // Queue holds at most Q_COUNT - 1 frames, so frame data is retired before reuse
+        frame_t f = {.data = &pool[i % POOL_NUM], .seq = i};
+        TEST_ASSERT_EQUAL(0, share_q_add(q, &f));
+    }
+    for (int i = 0; i < 3; i++) {
+        pthread_join(t[i], NULL);
+    }
+    for (int i = 0; i < STRESS_ITEMS; i++) {
+        TEST_ASSERT_EQUAL(1, released[i]);
+    }
+    share_q_destroy(q);
+}
+
+int main(void)
+{
+    RUN_TEST(test_release_out_of_order);
+    RUN_TEST(test_frame_data_reuse);
+    RUN_TEST(test_stress);
+    printf("All tests passed\n");
+    return 0;
+}
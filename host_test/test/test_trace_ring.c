@@ -0,0 +1,140 @@
+/* Tests for av_render lock-free trace ring */
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include "trace_ring.h"
+#include "test_common.h"
+
+#define PRODUCERS     (4)
+#define PRODUCE_COUNT (20000)
+
+static void test_round_trip(void)
+{
+    // Size rounded up to power of two
+    trace_ring_t *ring = trace_ring_create(3000);
+    TEST_ASSERT(ring != NULL);
+    int max_record = trace_ring_max_record(ring);
+    TEST_ASSERT(max_record > 0 && max_record < 4096 / 4);
+    uint8_t buf[1024];
+    TEST_ASSERT_EQUAL(0, trace_ring_read(ring, buf, sizeof(buf)));
+    uint8_t head[3] = { 1, 2, 3 };
+    uint8_t payload[200];
+    for (int i = 0; i < (int) sizeof(payload); i++) {
+        payload[i] = (uint8_t) i;
+    }
+    TEST_ASSERT_EQUAL(0, trace_ring_write(ring, head, 3, NULL, 0));
+    TEST_ASSERT_EQUAL(0, trace_ring_write(ring, head, 3, payload, 200));
+    TEST_ASSERT_EQUAL(3, trace_ring_read(ring, buf, sizeof(buf)));
+    TEST_ASSERT(memcmp(buf, head, 3) == 0);
+    TEST_ASSERT_EQUAL(203, trace_ring_read(ring, buf, sizeof(buf)));
+    TEST_ASSERT(memcmp(buf + 3, payload, 200) == 0);
+    // Short read buffer truncates record and still consumes it
+    TEST_ASSERT_EQUAL(0, trace_ring_write(ring, head, 3, payload, 200));
+    TEST_ASSERT_EQUAL(0, trace_ring_write(ring, head, 3, NULL, 0));
+    TEST_ASSERT_EQUAL(10, trace_ring_read(ring, buf, 10));
+    TEST_ASSERT_EQUAL(3, trace_ring_read(ring, buf, sizeof(buf)));
+    // Record bigger than max record refused without count as drop
+    TEST_ASSERT_EQUAL(-1, trace_ring_write(ring, head, 3, buf, max_record));
+    TEST_ASSERT_EQUAL(0, trace_ring_get_dropped(ring));
+    trace_ring_destroy(ring);
+}
+
+// Records of odd size force padding at ring end, content must survive wrap
+static void test_wrap_and_drop(void)
+{
+    trace_ring_t *ring = trace_ring_create(1024);
+    uint8_t payload[97], buf[256];
+    for (int round = 0; round < 200; round++) {
+        memset(payload, round, sizeof(payload));
+        uint32_t seq = round;
+        TEST_ASSERT_EQUAL(0, trace_ring_write(ring, &seq, 4, payload, sizeof(payload)));
+        TEST_ASSERT_EQUAL(4 + sizeof(payload), trace_ring_read(ring, buf, sizeof(buf)));
+        TEST_ASSERT(memcmp(buf, &seq, 4) == 0);
+        TEST_ASSERT_EQUAL(round & 0xFF, buf[4 + sizeof(payload) - 1]);
+    }
+    // Fill until full, producer never waits and drop is counted
+    int written = 0;
+    while (trace_ring_write(ring, payload, 4, payload, sizeof(payload)) == 0) {
+        written++;
+    }
+    TEST_ASSERT(written > 0);
+    TEST_ASSERT_EQUAL(1, trace_ring_get_dropped(ring));
+    int read = 0;
+    while (trace_ring_read(ring, buf, sizeof(buf)) > 0) {
+        read++;
+    }
+    TEST_ASSERT_EQUAL(written, read);
+    TEST_ASSERT_EQUAL(0, trace_ring_write(ring, payload, 4, payload, sizeof(payload)));
+    trace_ring_destroy(ring);
+}
+
+typedef struct {
+    trace_ring_t *ring;
+    uint32_t      id;
+} producer_ctx_t;
+
+static void *producer(void *arg)
+{
+    producer_ctx_t *ctx = (producer_ctx_t *) arg;
+    uint8_t payload[300];
+    unsigned seed = ctx->id;
+    for (uint32_t i = 0; i < PRODUCE_COUNT; i++) {
+        uint32_t head[2] = { ctx->id, i };
+        int len = rand_r(&seed) % sizeof(payload);
+        for (int k = 0; k < len; k++) {
+            payload[k] = (uint8_t) (i + k + ctx->id);
+        }
+        // Retry dropped record so that consumer can check sequence
+        while (trace_ring_write(ctx->ring, head, sizeof(head), payload, len) != 0) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+// Records from concurrent producers are never torn or reordered per producer
+static void test_multi_producer(void)
+{
+    trace_ring_t *ring = trace_ring_create(4096);
+    pthread_t threads[PRODUCERS];
+    producer_ctx_t ctx[PRODUCERS];
+    for (int i = 0; i < PRODUCERS; i++) {
+        ctx[i] = (producer_ctx_t) {.ring = ring, .id = i};
+        pthread_create(&threads[i], NULL, producer, &ctx[i]);
+    }
+    uint32_t next[PRODUCERS] = { 0 };
+    uint8_t buf[1024];
+    int got = 0;
+    while (got < PRODUCERS * PRODUCE_COUNT) {
+        int size = trace_ring_read(ring, buf, sizeof(buf));
+        if (size == 0) {
+            sched_yield();
+            continue;
+        }
+        uint32_t head[2];
+        TEST_ASSERT(size >= (int) sizeof(head));
+        memcpy(head, buf, sizeof(head));
+        TEST_ASSERT(head[0] < PRODUCERS);
+        TEST_ASSERT_EQUAL(next[head[0]], head[1]);
+        next[head[0]]++;
+        for (int k = 0; k < size - (int) sizeof(head); k++) {
+            TEST_ASSERT_EQUAL((uint8_t) (head[1] + k + head[0]), buf[sizeof(head) + k]);
+        }
+        got++;
+    }
+    for (int i = 0; i < PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    TEST_ASSERT_EQUAL(0, trace_ring_read(ring, buf, sizeof(buf)));
+    trace_ring_destroy(ring);
+}
+
+int main(void)
+{
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_wrap_and_drop);
+    RUN_TEST(test_multi_producer);
+    printf("All tests passed\n");
+    return 0;
+}
@@ -0,0 +1,147 @@
+/* Tests for reference counted video frame buffer pool */
+#include <stdint.h>
+#include <pthread.h>
+#include "media_lib_os.h"
+#include "video_fb_pool.h"
+#include "test_common.h"
+
+#define FB_SIZE (1000)
+
+static void test_acquire_release(void)
+{
+    video_fb_pool_handle_t pool = video_fb_pool_create(2, FB_SIZE, 64);
+    TEST_ASSERT(pool != NULL);
+    TEST_ASSERT_EQUAL(FB_SIZE, video_fb_pool_get_size(pool));
+    uint8_t *a = video_fb_pool_acquire(pool, 0);
+    uint8_t *b = video_fb_pool_acquire(pool, 0);
+    TEST_ASSERT(a != NULL && b != NULL && a != b);
+    TEST_ASSERT_EQUAL(0, (uintptr_t) a & 63);
+    TEST_ASSERT_EQUAL(0, (uintptr_t) b & 63);
+    TEST_ASSERT(video_fb_pool_contains(pool, a));
+    TEST_ASSERT(video_fb_pool_contains(pool, a + 1) == false);
+    // All buffers in use, acquire times out
+    TEST_ASSERT(video_fb_pool_acquire(pool, 10) == NULL);
+    // Extra reference keeps buffer until both released
+    TEST_ASSERT(video_fb_pool_ref(pool, a));
+    TEST_ASSERT(video_fb_pool_unref(pool, a));
+    TEST_ASSERT(video_fb_pool_acquire(pool, 0) == NULL);
+    TEST_ASSERT(video_fb_pool_unref(pool, a));
+    TEST_ASSERT(video_fb_pool_acquire(pool, 0) == a);
+    // Not owned or already free buffer is refused
+    uint8_t other[4];
+    TEST_ASSERT(video_fb_pool_ref(pool, other) == false);
+    TEST_ASSERT(video_fb_pool_unref(pool, other) == false);
+    TEST_ASSERT(video_fb_pool_unref(NULL, a) == false);
+    TEST_ASSERT(video_fb_pool_unref(pool, a));
+    TEST_ASSERT(video_fb_pool_unref(pool, a) == false);
+    TEST_ASSERT(video_fb_pool_unref(pool, b));
+    video_fb_pool_destroy(pool);
+}
+
+typedef struct {
+    video_fb_pool_handle_t pool;
+    uint8_t               *got;
+} acquire_ctx_t;
+
+static void *acquire_thread(void *arg)
+{
+    acquire_ctx_t *ctx = (acquire_ctx_t *) arg;
+    ctx->got = video_fb_pool_acquire(ctx->pool, 5000);
+    return NULL;
+}
+
+// Waiting acquire is woken once another thread releases buffer
+static void test_wait_release(void)
+{
+    video_fb_pool_handle_t pool = video_fb_pool_create(1, FB_SIZE, 0);
+    uint8_t *a = video_fb_pool_acquire(pool, 0);
+    acquire_ctx_t ctx = {.pool = pool};
+    pthread_t t;
+    pthread_create(&t, NULL, acquire_thread, &ctx);
+    media_lib_thread_sleep(20);
+    video_fb_pool_unref(pool, a);
+    pthread_join(t, NULL);
+    TEST_ASSERT(ctx.got == a);
+    video_fb_pool_unref(pool, a);
+    video_fb_pool_destroy(pool);
+}
+
+// Destroy wakes waiter, buffers still referenced stay valid until released
+static void test_destroy_in_use(void)
+{
+    video_fb_pool_handle_t pool = video_fb_pool_create(1, FB_SIZE, 16);
+    uint8_t *a = video_fb_pool_acquire(pool, 0);
+    acquire_ctx_t ctx = {.pool = pool};
+    pthread_t t;
+    pthread_create(&t, NULL, acquire_thread, &ctx);
+    media_lib_thread_sleep(20);
+    video_fb_pool_destroy(pool);
+    pthread_join(t, NULL);
+    TEST_ASSERT(ctx.got == NULL);
+    // Render side still holds frame after decoder destroyed pool
+    a[FB_SIZE - 1] = 0x5A;
+    TEST_ASSERT(video_fb_pool_acquire(pool, 0) == NULL);
+    TEST_ASSERT(video_fb_pool_unref(pool, a));
+}
+
+typedef struct {
+    video_fb_pool_handle_t pool;
+    uint8_t               *frames[64];
+    int                    rd;
+    int                    wr;
+    int                    done;
+} pipe_ctx_t;
+
+static void *render_thread(void *arg)
+{
+    pipe_ctx_t *ctx = (pipe_ctx_t *) arg;
+    while (1) {
+        int wr = __atomic_load_n(&ctx->wr, __ATOMIC_ACQUIRE);
+        if (ctx->rd == wr) {
+            if (__atomic_load_n(&ctx->done, __ATOMIC_ACQUIRE) && ctx->rd == __atomic_load_n(&ctx->wr, __ATOMIC_ACQUIRE)) {
+                break;
+            }
+            media_lib_thread_sleep(1);
+            continue;
+        }
+        uint8_t *fb = ctx->frames[ctx->rd % 64];
+        // Frame content stamped by decoder must be intact until released
+        TEST_ASSERT_EQUAL((uint8_t) ctx->rd, fb[0]);
+        TEST_ASSERT_EQUAL((uint8_t) ctx->rd, fb[FB_SIZE - 1]);
+        TEST_ASSERT(video_fb_pool_unref(ctx->pool, fb));
+        __atomic_store_n(&ctx->rd, ctx->rd + 1, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+// Decoder and render exchange buffers like av_render, no buffer reused while queued
+static void test_decode_render_pipe(void)
+{
+    pipe_ctx_t ctx = {.pool = video_fb_pool_create(3, FB_SIZE, 64)};
+    pthread_t t;
+    pthread_create(&t, NULL, render_thread, &ctx);
+    for (int i = 0; i < 2000; i++) {
+        uint8_t *fb = video_fb_pool_acquire(ctx.pool, 5000);
+        TEST_ASSERT(fb != NULL);
+        fb[0] = fb[FB_SIZE - 1] = (uint8_t) i;
+        // Queue holds its own reference, decoder drops one after frame callback
+        video_fb_pool_ref(ctx.pool, fb);
+        ctx.frames[i % 64] = fb;
+        __atomic_store_n(&ctx.wr, i + 1, __ATOMIC_RELEASE);
+        video_fb_pool_unref(ctx.pool, fb);
+    }
+    __atomic_store_n(&ctx.done, 1, __ATOMIC_RELEASE);
+    pthread_join(t, NULL);
+    TEST_ASSERT_EQUAL(2000, ctx.rd);
+    video_fb_pool_destroy(ctx.pool);
+}
+
+int main(void)
+{
+    RUN_TEST(test_acquire_release);
+    RUN_TEST(test_wait_release);
+    RUN_TEST(test_destroy_in_use);
+    RUN_TEST(test_decode_render_pipe);
+    printf("All tests passed\n");
+    return 0;
+}
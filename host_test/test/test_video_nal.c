@@ -0,0 +1,65 @@
+/* Tests for video frame type parser used by drop policy */
+#include <stdint.h>
+#include "video_nal.h"
+#include "test_common.h"
+
+static void test_h264_idr(void)
+{
+    // SPS, PPS then IDR slice
+    uint8_t data[] = {0, 0, 0, 1, 0x67, 0x42, 0, 0, 0, 1, 0x68, 0xCE, 0, 0, 1, 0x65, 0x88, 0x84};
+    video_nal_info_t info;
+    TEST_ASSERT_EQUAL(0, video_nal_parse(AV_RENDER_VIDEO_CODEC_H264, data, sizeof(data), &info));
+    TEST_ASSERT(info.key_frame);
+    TEST_ASSERT(info.reference);
+}
+
+static void test_h264_non_reference(void)
+{
+    // Two slices both with nal_ref_idc 0
+    uint8_t data[] = {0, 0, 0, 1, 0x01, 0x9A, 0x10, 0, 0, 1, 0x01, 0x9A, 0x20};
+    video_nal_info_t info;
+    TEST_ASSERT_EQUAL(0, video_nal_parse(AV_RENDER_VIDEO_CODEC_H264, data, sizeof(data), &info));
+    TEST_ASSERT(info.key_frame == false);
+    TEST_ASSERT(info.reference == false);
+}
+
+static void test_h264_reference(void)
+{
+    // First slice non-reference, second slice referenced
+    uint8_t data[] = {0, 0, 0, 1, 0x01, 0x9A, 0x10, 0, 0, 1, 0x41, 0x9A, 0x20, 0, 0, 1, 0x01, 0x9A};
+    video_nal_info_t info;
+    TEST_ASSERT_EQUAL(0, video_nal_parse(AV_RENDER_VIDEO_CODEC_H264, data, sizeof(data), &info));
+    TEST_ASSERT(info.key_frame == false);
+    TEST_ASSERT(info.reference);
+}
+
+static void test_h264_no_slice(void)
+{
+    uint8_t data[] = {0, 0, 0, 1, 0x67, 0x42, 0x00, 0x1E};
+    video_nal_info_t info;
+    TEST_ASSERT(video_nal_parse(AV_RENDER_VIDEO_CODEC_H264, data, sizeof(data), &info) != 0);
+    // Unknown type treated as reference to avoid corrupt picture
+    TEST_ASSERT(info.reference);
+    TEST_ASSERT(video_nal_parse(AV_RENDER_VIDEO_CODEC_H264, NULL, 0, &info) != 0);
+}
+
+static void test_mjpeg(void)
+{
+    uint8_t data[] = {0xFF, 0xD8, 0xFF, 0xE0, 0xFF, 0xD9};
+    video_nal_info_t info;
+    TEST_ASSERT_EQUAL(0, video_nal_parse(AV_RENDER_VIDEO_CODEC_MJPEG, data, sizeof(data), &info));
+    // Decodable alone and no frame depends on it, so it can be dropped when late
+    TEST_ASSERT(info.key_frame);
+    TEST_ASSERT(info.reference == false);
+}
+
+int main(void)
+{
+    RUN_TEST(test_h264_idr);
+    RUN_TEST(test_h264_non_reference);
+    RUN_TEST(test_h264_reference);
+    RUN_TEST(test_h264_no_slice);
+    RUN_TEST(test_mjpeg);
+    printf("All tests passed\n");
+    return 0;
+}
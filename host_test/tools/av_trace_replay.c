@@ -0,0 +1,847 @@
+/**
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2025 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/* Replay an av_render trace capture through av_render on host for offline analysis
+ * Decoders and renders are replaced by stubs: audio packets become silence of the duration till next packet
+ * and go through audio decoder as OPUS like the app stream,
+ * video packets become blank RGB565 frames, audio render consumes at real time and video render logs timing
+ * Usage: av_trace_replay [options] capture.bin
+ *        av_trace_replay -r capture.bin [-n seconds]   Record synthetic capture to try the tool
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <time.h>
+#include "esp_timer.h"
+#include "media_lib_os.h"
+#include "av_render.h"
+#include "audio_decoder.h"
+#include "video_decoder.h"
+#include "audio_render.h"
+#include "video_render.h"
+#include "audio_resample.h"
+
+#define REPLAY_MAX_VIDEO_LOG  (64 * 1024)
+#define REPLAY_MIN_FRAME_MS   (1)
+#define REPLAY_MAX_FRAME_MS   (200)
+#define REPLAY_VIDEO_ALIGN    (64)
+
+typedef struct {
+    uint8_t  type;
+    uint32_t pts;
+    uint32_t time;     // Capture time (unit us) of esp_timer_get_time, wraps
+    uint32_t size;     // Original data size
+    uint8_t *payload;  // Kept payload, may be shorter than size
+    uint32_t payload_len;
+} replay_record_t;
+
+typedef struct {
+    uint32_t sample_rate;
+    uint8_t  channel;
+    uint16_t width;
+    uint16_t height;
+    bool     coop;
+    uint16_t jitter_delay;
+    int      record_seconds;
+} replay_opt_t;
+
+typedef struct {
+    uint32_t pts;
+    int64_t  time;
+    int32_t  skew;
+} video_log_t;
+
+static replay_opt_t opt = {
+    .sample_rate = 16000,
+    .channel = 1,
+    .width = 320,
+    .height = 240,
+    .record_seconds = 5,
+};
+
+// Timing collected by stub renders
+static struct {
+    uint32_t     audio_frames;
+    uint64_t     audio_bytes;
+    int64_t      audio_clock;  // PTS at end of last written audio frame, -1 before first
+    uint32_t     video_num;
+    video_log_t *video_log;
+} sink = {.audio_clock = -1};
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void print_dist(const char *name, uint32_t *v, int n)
+{
+    if (n <= 0) {
+        printf("  %-26s n=0\n", name);
+        return;
+    }
+    qsort(v, n, sizeof(uint32_t), cmp_u32);
+    printf("  %-26s n=%-6d p50 %7.2f  p99 %7.2f  max %7.2f ms\n", name, n, v[n / 2] / 1000.0,
+           v[(int)(n * 0.99)] / 1000.0, v[n - 1] / 1000.0);
+}
+
+/* Decoder stubs, audio payload is already silence of the wanted duration */
+typedef struct {
+    adec_cfg_t       cfg;
+    adec_fb_cb_cfg_t fb;
+} stub_adec_t;
+
+adec_handle_t adec_open(adec_cfg_t *cfg)
+{
+    stub_adec_t *dec = calloc(1, sizeof(stub_adec_t));
+    if (dec) {
+        dec->cfg = *cfg;
+    }
+    return dec;
+}
+
+int adec_set_fb_cb(adec_handle_t h, adec_fb_cb_cfg_t *cfg)
+{
+    ((stub_adec_t *)h)->fb = *cfg;
+    return 0;
+}
+
+int adec_decode(adec_handle_t h, av_render_audio_data_t *data)
+{
+    stub_adec_t *dec = (stub_adec_t *)h;
+    uint8_t *out = data->data;
+    uint8_t *fb = dec->fb.fb_fetch ? dec->fb.fb_fetch(data->size, dec->fb.ctx) : NULL;
+    if (fb) {
+        memcpy(fb, data->data, data->size);
+        out = fb;
+    }
+    av_render_audio_frame_t frame = {
+        .pts = data->pts,
+        .data = out,
+        .size = data->size,
+        .eos = data->eos,
+    };
+    int ret = dec->cfg.frame_cb(&frame, dec->cfg.ctx);
+    if (fb) {
+        dec->fb.fb_return(fb, ret != 0, dec->fb.ctx);
+    }
+    return ret;
+}
+
+int adec_conceal(adec_handle_t h, uint32_t pts)
+{
+    return ESP_MEDIA_ERR_NOT_SUPPORT;
+}
+
+int adec_get_frame_info(adec_handle_t h, av_render_audio_frame_info_t *frame_info)
+{
+    frame_info->sample_rate = opt.sample_rate;
+    frame_info->channel = opt.channel;
+    frame_info->bits_per_sample = 16;
+    return 0;
+}
+
+int adec_close(adec_handle_t h)
+{
+    free(h);
+    return 0;
+}
+
+typedef struct {
+    vdec_cfg_t       cfg;
+    vdec_fb_cb_cfg_t fb;
+    uint8_t         *frame;
+} stub_vdec_t;
+
+int vdec_get_output_formats(av_render_video_codec_t codec, av_render_video_frame_type_t *fmts, uint8_t *num)
+{
+    fmts[0] = AV_RENDER_VIDEO_RAW_TYPE_RGB565;
+    *num = 1;
+    return 0;
+}
+
+vdec_handle_t vdec_open(vdec_cfg_t *cfg)
+{
+    stub_vdec_t *dec = calloc(1, sizeof(stub_vdec_t));
+    if (dec) {
+        dec->cfg = *cfg;
+    }
+    return dec;
+}
+
+int vdec_set_fb_cb(vdec_handle_t h, vdec_fb_cb_cfg_t *cfg)
+{
+    ((stub_vdec_t *)h)->fb = *cfg;
+    return 0;
+}
+
+int vdec_decode(vdec_handle_t h, av_render_video_data_t *data)
+{
+    stub_vdec_t *dec = (stub_vdec_t *)h;
+    int size = opt.width * opt.height * 2;
+    uint8_t *fb = dec->fb.fb_fetch ? dec->fb.fb_fetch(REPLAY_VIDEO_ALIGN, size, dec->fb.ctx) : NULL;
+    if (fb == NULL) {
+        if (dec->frame == NULL) {
+            dec->frame = calloc(1, size);
+        }
+        if (dec->frame == NULL) {
+            return ESP_MEDIA_ERR_NO_MEM;
+        }
+    }
+    av_render_video_frame_t frame = {
+        .pts = data->pts,
+        .data = fb ? fb : dec->frame,
+        .size = size,
+        .eos = data->eos,
+    };
+    int ret = dec->cfg.frame_cb(&frame, dec->cfg.ctx);
+    if (fb) {
+        dec->fb.fb_return(fb, ret != 0, dec->fb.ctx);
+    }
+    return ret;
+}
+
+int vdec_set_frame_buffer(vdec_handle_t h, av_render_frame_buffer_t *buffer)
+{
+    return ESP_MEDIA_ERR_NOT_SUPPORT;
+}
+
+int vdec_get_frame_info(vdec_handle_t h, av_render_video_frame_info_t *frame_info)
+{
+    frame_info->type = AV_RENDER_VIDEO_RAW_TYPE_RGB565;
+    frame_info->width = opt.width;
+    frame_info->height = opt.height;
+    frame_info->fps = ((stub_vdec_t *)h)->cfg.video_info.fps;
+    return 0;
+}
+
+int vdec_close(vdec_handle_t h)
+{
+    stub_vdec_t *dec = (stub_vdec_t *)h;
+    free(dec->frame);
+    free(dec);
+    return 0;
+}
+
+// Decoder output always matches render format, resample never needed
+audio_resample_handle_t audio_resample_open(audio_resample_cfg_t *cfg)
+{
+    return NULL;
+}
+
+int audio_resample_write(audio_resample_handle_t h, av_render_audio_frame_t *data)
+{
+    return ESP_MEDIA_ERR_NOT_SUPPORT;
+}
+
+void audio_resample_close(audio_resample_handle_t h)
+{
+}
+
+/* Render stubs */
+static audio_render_handle_t stub_arender_init(void *cfg, int cfg_size)
+{
+    static int handle;
+    return &handle;
+}
+
+static int stub_arender_open(audio_render_handle_t h, av_render_audio_frame_info_t *info)
+{
+    return 0;
+}
+
+// Blocks for frame duration like I2S write on a full DMA
+static int stub_arender_write(audio_render_handle_t h, av_render_audio_frame_t *frame)
+{
+    uint32_t duration_us = (uint64_t)frame->size * 1000000 / (opt.sample_rate * opt.channel * 2);
+    usleep(duration_us);
+    sink.audio_frames++;
+    sink.audio_bytes += frame->size;
+    __atomic_store_n(&sink.audio_clock, (int64_t)frame->pts + duration_us / 1000, __ATOMIC_RELAXED);
+    return 0;
+}
+
+static int stub_arender_latency(audio_render_handle_t h, uint32_t *latency)
+{
+    *latency = 0;
+    return 0;
+}
+
+static int stub_arender_frame_info(audio_render_handle_t h, av_render_audio_frame_info_t *info)
+{
+    info->sample_rate = opt.sample_rate;
+    info->channel = opt.channel;
+    info->bits_per_sample = 16;
+    return 0;
+}
+
+static int stub_arender_speed(audio_render_handle_t h, float speed)
+{
+    return 0;
+}
+
+static int stub_arender_close(audio_render_handle_t h)
+{
+    return 0;
+}
+
+static void stub_arender_deinit(audio_render_handle_t h)
+{
+}
+
+static video_render_handle_t stub_vrender_open(void *cfg, int cfg_size)
+{
+    static int handle;
+    return &handle;
+}
+
+static bool stub_vrender_format_support(video_render_handle_t h, av_render_video_frame_type_t type)
+{
+    return type == AV_RENDER_VIDEO_RAW_TYPE_RGB565;
+}
+
+static int stub_vrender_set_frame_info(video_render_handle_t h, av_render_video_frame_info_t *info)
+{
+    return 0;
+}
+
+static int stub_vrender_get_frame_buffer(video_render_handle_t h, av_render_frame_buffer_t *buffer)
+{
+    return ESP_MEDIA_ERR_NOT_SUPPORT;
+}
+
+static int stub_vrender_write(video_render_handle_t h, av_render_video_frame_t *frame)
+{
+    if (sink.video_num < REPLAY_MAX_VIDEO_LOG) {
+        int64_t audio_clock = __atomic_load_n(&sink.audio_clock, __ATOMIC_RELAXED);
+        video_log_t *log = &sink.video_log[sink.video_num++];
+        log->pts = frame->pts;
+        log->time = esp_timer_get_time();
+        log->skew = audio_clock < 0 ? 0 : (int32_t)(frame->pts - (uint32_t)audio_clock);
+    }
+    return 0;
+}
+
+static int stub_vrender_latency(video_render_handle_t h, uint32_t *latency)
+{
+    *latency = 0;
+    return 0;
+}
+
+static int stub_vrender_frame_info(video_render_handle_t h, av_render_video_frame_info_t *info)
+{
+    info->type = AV_RENDER_VIDEO_RAW_TYPE_RGB565;
+    info->width = opt.width;
+    info->height = opt.height;
+    return 0;
+}
+
+static int stub_vrender_clear(video_render_handle_t h)
+{
+    return 0;
+}
+
+static int stub_vrender_close(video_render_handle_t h)
+{
+    return 0;
+}
+
+static audio_render_handle_t audio_render;
+static video_render_handle_t video_render;
+
+static av_render_handle_t open_render(av_render_trace_cfg_t *trace_cfg)
+{
+    audio_render_cfg_t a_cfg = {
+        .ops = {
+            .init = stub_arender_init,
+            .open = stub_arender_open,
+            .write = stub_arender_write,
+            .get_latency = stub_arender_latency,
+            .get_frame_info = stub_arender_frame_info,
+            .set_speed = stub_arender_speed,
+            .close = stub_arender_close,
+            .deinit = stub_arender_deinit,
+        },
+    };
+    video_render_cfg_t v_cfg = {
+        .ops = {
+            .open = stub_vrender_open,
+            .format_support = stub_vrender_format_support,
+            .set_frame_info = stub_vrender_set_frame_info,
+            .get_frame_buffer = stub_vrender_get_frame_buffer,
+            .write = stub_vrender_write,
+            .get_latency = stub_vrender_latency,
+            .get_frame_info = stub_vrender_frame_info,
+            .clear = stub_vrender_clear,
+            .close = stub_vrender_close,
+        },
+    };
+    audio_render = audio_render_alloc_handle(&a_cfg);
+    video_render = video_render_alloc_handle(&v_cfg);
+    av_render_cfg_t cfg = {
+        .audio_render = audio_render,
+        .video_render = video_render,
+        .sync_mode = AV_RENDER_SYNC_FOLLOW_AUDIO,
+        .audio_raw_fifo_size = 8 * 4096,
+        .audio_render_fifo_size = 100 * 1024,
+        .video_raw_fifo_size = 256 * 1024,
+        .allow_drop_data = true,
+        .latency_stats = true,
+        .audio_coop = opt.coop,
+        .audio_jitter = {
+            .enable = opt.jitter_delay > 0,
+            .target_delay = opt.jitter_delay,
+        },
+    };
+    av_render_handle_t render = av_render_open(&cfg);
+    if (render == NULL) {
+        return NULL;
+    }
+    if (trace_cfg) {
+        av_render_trace_start(render, trace_cfg);
+    }
+    av_render_audio_info_t a_info = {
+        .codec = AV_RENDER_AUDIO_CODEC_OPUS,
+        .channel = opt.channel,
+        .bits_per_sample = 16,
+        .sample_rate = opt.sample_rate,
+    };
+    av_render_video_info_t v_info = {
+        .codec = AV_RENDER_VIDEO_CODEC_MJPEG,
+        .width = opt.width,
+        .height = opt.height,
+        .fps = 30,
+    };
+    av_render_add_audio_stream(render, &a_info);
+    av_render_add_video_stream(render, &v_info);
+    return render;
+}
+
+static void close_render(av_render_handle_t render)
+{
+    av_render_close(render);
+    audio_render_free_handle(audio_render);
+    video_render_free_handle(video_render);
+}
+
+static int get_varint(const uint8_t *b, int size, int *pos, uint32_t *v)
+{
+    *v = 0;
+    for (int shift = 0; shift < 35 && *pos < size; shift += 7) {
+        uint8_t c = b[(*pos)++];
+        *v |= (uint32_t)(c & 0x7F) << shift;
+        if ((c & 0x80) == 0) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Parse whole capture, records point into file buffer
+static int parse_capture(uint8_t *b, int size, replay_record_t **out)
+{
+    if (size < 5 || memcmp(b, "AVTR", 4) != 0) {
+        fprintf(stderr, "Not a trace capture\n");
+        return -1;
+    }
+    if (b[4] != 1) {
+        fprintf(stderr, "Unsupported capture version %d\n", b[4]);
+        return -1;
+    }
+    int max_num = size / 4 + 1;
+    replay_record_t *records = calloc(max_num, sizeof(replay_record_t));
+    if (records == NULL) {
+        return -1;
+    }
+    uint32_t last_pts[AV_RENDER_TRACE_MAX] = { 0 };
+    uint32_t last_time[AV_RENDER_TRACE_MAX] = { 0 };
+    int num = 0;
+    int pos = 5;
+    while (pos < size) {
+        uint32_t len, pts_zz, time_delta, data_size;
+        if (get_varint(b, size, &pos, &len) != 0 || len == 0 || pos + (int)len > size) {
+            fprintf(stderr, "Capture truncated at offset %d, keep %d records\n", pos, num);
+            break;
+        }
+        int end = pos + len;
+        replay_record_t *r = &records[num];
+        r->type = b[pos++];
+        if (r->type >= AV_RENDER_TRACE_MAX || get_varint(b, end, &pos, &pts_zz) != 0 ||
+            get_varint(b, end, &pos, &time_delta) != 0 || get_varint(b, end, &pos, &data_size) != 0) {
+            fprintf(stderr, "Bad record at offset %d\n", pos);
+            pos = end;
+            continue;
+        }
+        int32_t pts_delta = (int32_t)(pts_zz >> 1) ^ -(int32_t)(pts_zz & 1);
+        last_pts[r->type] += (uint32_t)pts_delta;
+        last_time[r->type] += time_delta;
+        r->pts = last_pts[r->type];
+        r->time = last_time[r->type];
+        r->size = data_size;
+        r->payload = b + pos;
+        r->payload_len = end - pos;
+        pos = end;
+        num++;
+    }
+    *out = records;
+    return num;
+}
+
+static const char *type_names[AV_RENDER_TRACE_MAX] = {"audio decode", "audio render", "video decode", "video render"};
+
+static void report_capture(replay_record_t *records, int num)
+{
+    printf("Capture: %d records\n", num);
+    uint32_t *v = malloc((num + 1) * sizeof(uint32_t));
+    if (v == NULL) {
+        return;
+    }
+    for (int type = 0; type < AV_RENDER_TRACE_MAX; type++) {
+        int n = 0;
+        uint32_t last = 0;
+        uint32_t first_pts = 0, last_pts = 0;
+        uint64_t bytes = 0;
+        int count = 0;
+        for (int i = 0; i < num; i++) {
+            if (records[i].type != type) {
+                continue;
+            }
+            if (count == 0) {
+                first_pts = records[i].pts;
+            } else {
+                v[n++] = records[i].time - last;
+            }
+            last = records[i].time;
+            last_pts = records[i].pts;
+            bytes += records[i].size;
+            count++;
+        }
+        if (count == 0) {
+            continue;
+        }
+        printf("  %-14s %6d records, pts %u..%u, %llu bytes\n", type_names[type], count, first_pts, last_pts,
+               (unsigned long long)bytes);
+        print_dist("  interval", v, n);
+    }
+    free(v);
+}
+
+static void report_replay(av_render_handle_t render, int audio_in, int video_in)
+{
+    printf("Replay:\n");
+    printf("  audio %d packets in, %u frames rendered (%.2f s)\n", audio_in, sink.audio_frames,
+           sink.audio_bytes / (double)(opt.sample_rate * opt.channel * 2));
+    printf("  video %d packets in, %u frames rendered\n", video_in, sink.video_num);
+    av_render_drop_stat_t drop = { 0 };
+    if (av_render_get_drop_stat(render, &drop) == 0) {
+        printf("  video drop: decoded %u dropped %u skip_to_key %u skipped %u\n", drop.decoded, drop.dropped,
+               drop.skip_to_key, drop.skipped);
+    }
+    av_render_plc_stat_t plc = { 0 };
+    if (av_render_get_plc_stat(render, &plc) == 0) {
+        printf("  audio gaps %u, concealed %u, faded %u\n", plc.gap_num, plc.plc_frames, plc.fade_frames);
+    }
+    if (sink.video_num > 1) {
+        uint32_t *v = malloc(sink.video_num * sizeof(uint32_t));
+        if (v) {
+            for (uint32_t i = 1; i < sink.video_num; i++) {
+                v[i - 1] = (uint32_t)(sink.video_log[i].time - sink.video_log[i - 1].time);
+            }
+            print_dist("video render interval", v, sink.video_num - 1);
+            int n = 0;
+            for (uint32_t i = 0; i < sink.video_num; i++) {
+                int32_t skew = sink.video_log[i].skew;
+                v[n++] = (uint32_t)(skew < 0 ? -skew : skew) * 1000;
+            }
+            print_dist("|video pts - audio clock|", v, n);
+            free(v);
+        }
+    }
+    av_render_stats_t stats;
+    if (av_render_get_stats(render, &stats) == 0) {
+        static const char *stage_names[AV_RENDER_STAGE_MAX] = {"queue", "decode", "convert", "render"};
+        for (int s = 0; s < AV_RENDER_STREAM_MAX; s++) {
+            for (int i = 0; i < AV_RENDER_STAGE_MAX; i++) {
+                av_render_latency_t *l = &stats.stage[s][i];
+                if (l->count == 0) {
+                    continue;
+                }
+                printf("  %s %-8s p50 %7.2f  p99 %7.2f  max %7.2f ms\n", s == AV_RENDER_STREAM_AUDIO ? "audio" : "video",
+                       stage_names[i], l->p50 / 1000.0, l->p99 / 1000.0, l->max / 1000.0);
+            }
+        }
+    }
+}
+
+static void wait_until(int64_t start, int64_t offset)
+{
+    int64_t wait = start + offset - esp_timer_get_time();
+    if (wait > 0) {
+        usleep(wait);
+    }
+}
+
+// Feed decoder input records with original arrival timing
+static int replay(replay_record_t *records, int num)
+{
+    sink.video_log = calloc(REPLAY_MAX_VIDEO_LOG, sizeof(video_log_t));
+    if (sink.video_log == NULL) {
+        return -1;
+    }
+    av_render_handle_t render = open_render(NULL);
+    if (render == NULL) {
+        fprintf(stderr, "Fail to open av_render\n");
+        return -1;
+    }
+    uint32_t max_size = 0;
+    for (int i = 0; i < num; i++) {
+        if (records[i].size > max_size) {
+            max_size = records[i].size;
+        }
+    }
+    uint32_t max_pcm = opt.sample_rate * opt.channel * 2 * REPLAY_MAX_FRAME_MS / 1000;
+    uint8_t *data = calloc(1, (max_size > max_pcm ? max_size : max_pcm) + 1);
+    if (data == NULL) {
+        close_render(render);
+        return -1;
+    }
+    uint32_t t0 = 0;
+    bool have_t0 = false;
+    for (int i = 0; i < num; i++) {
+        if (records[i].type == AV_RENDER_TRACE_ADEC || records[i].type == AV_RENDER_TRACE_VDEC) {
+            if (have_t0 == false || (int32_t)(records[i].time - t0) < 0) {
+                t0 = records[i].time;
+                have_t0 = true;
+            }
+        }
+    }
+    int audio_in = 0, video_in = 0;
+    uint32_t frame_ms = 20;
+    int64_t start = esp_timer_get_time();
+    // Records of different types are not ordered by time in capture, feed earliest of next audio and video
+    int a = 0, v = 0;
+    while (1) {
+        while (a < num && records[a].type != AV_RENDER_TRACE_ADEC) {
+            a++;
+        }
+        while (v < num && records[v].type != AV_RENDER_TRACE_VDEC) {
+            v++;
+        }
+        if (a >= num && v >= num) {
+            break;
+        }
+        bool use_audio = v >= num || (a < num && (int32_t)(records[a].time - records[v].time) <= 0);
+        replay_record_t *r = &records[use_audio ? a : v];
+        wait_until(start, (int32_t)(r->time - t0));
+        if (use_audio) {
+            // Silence lasting till next audio packet, decoder stub passes it through
+            int next = a + 1;
+            while (next < num && records[next].type != AV_RENDER_TRACE_ADEC) {
+                next++;
+            }
+            if (next < num) {
+                uint32_t delta = records[next].pts - r->pts;
+                if (delta >= REPLAY_MIN_FRAME_MS && delta <= REPLAY_MAX_FRAME_MS) {
+                    frame_ms = delta;
+                }
+            }
+            av_render_audio_data_t audio = {
+                .pts = r->pts,
+                .data = data,
+                .size = opt.sample_rate * opt.channel * 2 * frame_ms / 1000,
+            };
+            memset(data, 0, audio.size);
+            if (r->size && av_render_add_audio_data(render, &audio) == 0) {
+                audio_in++;
+            }
+            a++;
+        } else {
+            // Keep original size, truncated payload padded with zero
+            memset(data, 0, r->size);
+            memcpy(data, r->payload, r->payload_len < r->size ? r->payload_len : r->size);
+            av_render_video_data_t video = {
+                .pts = r->pts,
+                .key_frame = (video_in == 0),
+                .data = data,
+                .size = r->size,
+            };
+            if (r->size && av_render_add_video_data(render, &video) == 0) {
+                video_in++;
+            }
+            v++;
+        }
+    }
+    // Let queued data play out
+    usleep(500000);
+    report_replay(render, audio_in, video_in);
+    close_render(render);
+    free(data);
+    free(sink.video_log);
+    return 0;
+}
+
+// Produce capture of synthetic stream with network like arrival jitter
+static int record(const char *path)
+{
+    av_render_trace_cfg_t trace_cfg = {
+        .mask = (1 << AV_RENDER_TRACE_MAX) - 1,
+        .max_payload = 16,
+        .file_path = path,
+    };
+    sink.video_log = calloc(REPLAY_MAX_VIDEO_LOG, sizeof(video_log_t));
+    av_render_handle_t render = open_render(&trace_cfg);
+    if (render == NULL || sink.video_log == NULL) {
+        return -1;
+    }
+    int pcm_size = opt.sample_rate * opt.channel * 2 * 20 / 1000;
+    uint8_t *pcm = calloc(1, pcm_size);
+    uint8_t jpeg[2048] = { 0xFF, 0xD8 };
+    srand(1);
+    int64_t start = esp_timer_get_time();
+    uint32_t audio_pts = 0, video_pts = 0;
+    int64_t offset = 0;
+    while (pcm && offset < opt.record_seconds * 1000000LL) {
+        // Bursts of late packets every second
+        int64_t jitter = (audio_pts % 1000 < 100) ? 80000 : rand() % 10000;
+        if (audio_pts <= video_pts) {
+            wait_until(start, (int64_t)audio_pts * 1000 + jitter);
+            av_render_audio_data_t audio = {.pts = audio_pts, .data = pcm, .size = pcm_size};
+            av_render_add_audio_data(render, &audio);
+            audio_pts += 20;
+        } else {
+            wait_until(start, (int64_t)video_pts * 1000 + jitter);
+            av_render_video_data_t video = {
+                .pts = video_pts,
+                .key_frame = true,
+                .data = jpeg,
+                .size = 1024 + rand() % 1024,
+            };
+            av_render_add_video_data(render, &video);
+            video_pts += 33;
+        }
+        offset = esp_timer_get_time() - start;
+    }
+    usleep(300000);
+    av_render_trace_stop(render);
+    close_render(render);
+    free(pcm);
+    free(sink.video_log);
+    memset(&sink, 0, sizeof(sink));
+    sink.audio_clock = -1;
+    printf("Recorded %d s capture to %s\n", opt.record_seconds, path);
+    return 0;
+}
+
+static void usage(void)
+{
+    printf("Usage: av_trace_replay [options] capture.bin\n"
+           "  -a rate:ch   Decoded audio format (default 16000:1)\n"
+           "  -v WxH       Decoded video size (default 320x240)\n"
+           "  -c           Run audio decode and render in one cooperative thread\n"
+           "  -j ms        Enable audio jitter buffer with target delay\n"
+           "  -r           Record synthetic capture to file instead of replay\n"
+           "  -n seconds   Duration of recorded capture (default 5)\n");
+}
+
+int main(int argc, char *argv[])
+{
+    bool do_record = false;
+    int c;
+    while ((c = getopt(argc, argv, "a:v:cj:rn:h")) != -1) {
+        switch (c) {
+            case 'a': {
+                unsigned rate = 0, ch = 0;
+                if (sscanf(optarg, "%u:%u", &rate, &ch) != 2 || rate == 0 || ch == 0 || ch > 8) {
+                    usage();
+                    return 1;
+                }
+                opt.sample_rate = rate;
+                opt.channel = ch;
+                break;
+            }
+            case 'v': {
+                unsigned w = 0, h = 0;
+                if (sscanf(optarg, "%ux%u", &w, &h) != 2 || w == 0 || h == 0 || w > 4096 || h > 4096) {
+                    usage();
+                    return 1;
+                }
+                opt.width = w;
+                opt.height = h;
+                break;
+            }
+            case 'c':
+                opt.coop = true;
+                break;
+            case 'j':
+                opt.jitter_delay = atoi(optarg);
+                break;
+            case 'r':
+                do_record = true;
+                break;
+            case 'n':
+                opt.record_seconds = atoi(optarg);
+                break;
+            default:
+                usage();
+                return c == 'h' ? 0 : 1;
+        }
+    }
+    if (optind >= argc) {
+        usage();
+        return 1;
+    }
+    const char *path = argv[optind];
+    if (do_record) {
+        return record(path) == 0 ? 0 : 1;
+    }
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "Fail to open %s\n", path);
+        return 1;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t *buf = malloc(size > 0 ? size : 1);
+    if (buf == NULL || fread(buf, 1, size, fp) != (size_t)size) {
+        fprintf(stderr, "Fail to read %s\n", path);
+        fclose(fp);
+        free(buf);
+        return 1;
+    }
+    fclose(fp);
+    replay_record_t *records = NULL;
+    int num = parse_capture(buf, size, &records);
+    int ret = 1;
+    if (num >= 0) {
+        report_capture(records, num);
+        ret = replay(records, num) == 0 ? 0 : 1;
+    }
+    free(records);
+    free(buf);
+    return ret;
+}
@@ -389,6 +389,12 @@ static void thread_scheduler(const char *thread_name,
     } else if (strcmp(thread_name, "ARender") == 0) {
         thread_cfg->stack_size = 1 * 1024;
         thread_cfg->priority = 5;
+    } else if (strcmp(thread_name, "APipe") == 0) {
+        thread_cfg->stack_size = 2 * 1024;
+        thread_cfg->priority = 5;
+    } else if (strcmp(thread_name, "AVTrace") == 0) {
+        thread_cfg->stack_size = 3 * 1024;
+        thread_cfg->priority = 1;
     } else if (strcmp(thread_name, "AUD_SRC") == 0) {
         thread_cfg->stack_size = 3 * 1024;
         thread_cfg->priority = 5;
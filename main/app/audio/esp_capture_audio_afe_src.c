@@ -137,11 +137,17 @@ static void afe_fetch(void *arg) {
         assert(res->data_size % src->audio_frame_sz == 0);
 
         for (size_t i = 0; i < fetch_chunksize / src->audio_frame_len; i++) {
-            size_t bytes = fifo_ringbuf_write(
-                src->audio_ringbuf, &res->data[src->audio_frame_len * i],
-                src->audio_frame_sz);
-            ESP_LOGD(__FUNCTION__, "%lld: wrote [%u]: %u/%u",
-                     esp_timer_get_time(), i, bytes, src->audio_frame_sz);
+            // Fetch result is owned by AFE, copy it into ring slot directly
+            void *slot = fifo_ringbuf_acquire_write(src->audio_ringbuf);
+            if (!slot) {
+                ESP_LOGD(TAG, "drop frame [%u], ringbuf held by reader", i);
+                continue;
+            }
+            memcpy(slot, &res->data[src->audio_frame_len * i],
+                   src->audio_frame_sz);
+            fifo_ringbuf_commit_write(src->audio_ringbuf, src->audio_frame_sz);
+            ESP_LOGD(__FUNCTION__, "%lld: wrote [%u]: %u",
+                     esp_timer_get_time(), i, src->audio_frame_sz);
         }
     }
     src->flags.fetch_stopped = true;
@@ -219,6 +225,7 @@ static int afe_dev_src_start(esp_capture_audio_src_if_t *h) {
         ESP_LOGE(TAG, "Unable to create audio_ringbuf");
         return ESP_CAPTURE_ERR_NO_MEM;
     }
+    fifo_ringbuf_enable_stats(src->audio_ringbuf, "AfeRb");
     ESP_LOGD(TAG, "audio_frame_len=%u, audio_frame_sz=%u", src->audio_frame_len,
              src->audio_frame_sz);
 
@@ -237,14 +244,24 @@ static int afe_dev_src_read_frame(esp_capture_audio_src_if_t *h,
         return ESP_CAPTURE_ERR_NOT_SUPPORTED;
     }
     int samples = frame->size / (sizeof(int16_t) * src->info.channel);
+    size_t frames = samples / src->audio_frame_len;
     size_t read_total = 0;
-    for (size_t i = 0; i < samples / src->audio_frame_len; i++) {
-        size_t read_bytes = fifo_ringbuf_read(
-            src->audio_ringbuf, frame->data + i * src->audio_frame_sz,
-            src->audio_frame_sz, portMAX_DELAY);
-        ESP_LOGD(__FUNCTION__, "%lld: read [%u]: %u/%u", esp_timer_get_time(),
-                 i, read_bytes, src->audio_frame_sz);
+    // Frame buffer is owned by capture, copy continuous 10ms frames in one call
+    for (size_t i = 0; i < frames;) {
+        void *data = NULL;
+        size_t items = 0;
+        size_t read_bytes =
+            fifo_ringbuf_acquire_read(src->audio_ringbuf, &data, frames - i,
+                                      &items, portMAX_DELAY);
+        if (items == 0) {
+            break;
+        }
+        memcpy(frame->data + read_total, data, read_bytes);
+        fifo_ringbuf_release_read(src->audio_ringbuf, items);
+        ESP_LOGD(__FUNCTION__, "%lld: read [%u]: %u frames %u bytes",
+                 esp_timer_get_time(), i, items, read_bytes);
         read_total += read_bytes;
+        i += items;
     }
     if (read_total != frame->size) {
         ESP_LOGE(TAG, "Fail to read from AFE, %u/%d", read_total, frame->size);
@@ -12,6 +12,7 @@
 #include "board.h"
 #include "esp_capture_audio_afe_src.h"
 #include "media_lib_os.h"
+#include "queue_stats.h"
 
 #include "av_render_default.h"
 #include "esp_audio_dec_default.h"
@@ -76,6 +77,8 @@ static int build_capture_system(void) {
 static int build_player_system() {
     i2s_render_cfg_t i2s_cfg = {
         .play_handle = get_playback_handle(),
+        // Same as DMA setting in board.c, used to estimate output latency
+        .dma_frames = 8 * 160,
     };
     player_sys.audio_render = av_render_alloc_i2s_render(&i2s_cfg);
     if (player_sys.audio_render == NULL) {
@@ -103,6 +106,11 @@ static int build_player_system() {
 }
 
 int media_sys_buildup(void) {
+#if CONFIG_MEDIA_LIB_QUEUE_STATS
+    // Register queue statistics to help sizing fifo in player and capture
+    queue_stats_set_enable(true);
+    queue_stats_start_dump(CONFIG_MEDIA_LIB_QUEUE_STATS_DUMP_INTERVAL);
+#endif
     // Register default audio encoder
     esp_audio_enc_register_default();
     // Register default audio decoder